@@ -69,6 +69,8 @@ G_BEGIN_DECLS
 #define file_manager_menu_item_list_free                      nautilus_menu_item_list_free
 #define file_manager_file_info_get_uri                        nautilus_file_info_get_uri
 #define file_manager_file_info_get_mime_type                  nautilus_file_info_get_mime_type
+#define file_manager_file_info_get_file_type                  nautilus_file_info_get_file_type
+#define file_manager_file_info_get_location                   nautilus_file_info_get_location
 #define file_manager_file_info_list_copy                      nautilus_file_info_list_copy
 #define file_manager_file_info_list_free                      nautilus_file_info_list_free
 #define file_manager_menu_provider_emit_items_updated_signal  nautilus_menu_provider_emit_items_updated_signal
@@ -90,6 +92,8 @@ G_BEGIN_DECLS
 #define file_manager_menu_item_list_free                      nemo_menu_item_list_free
 #define file_manager_file_info_get_uri                        nemo_file_info_get_uri
 #define file_manager_file_info_get_mime_type                  nemo_file_info_get_mime_type
+#define file_manager_file_info_get_file_type                  nemo_file_info_get_file_type
+#define file_manager_file_info_get_location                   nemo_file_info_get_location
 #define file_manager_file_info_list_copy                      nemo_file_info_list_copy
 #define file_manager_file_info_list_free                      nemo_file_info_list_free
 #define file_manager_menu_provider_emit_items_updated_signal  nemo_menu_provider_emit_items_updated_signal
@@ -111,6 +115,8 @@ G_BEGIN_DECLS
 #define file_manager_menu_item_list_free                      caja_menu_item_list_free
 #define file_manager_file_info_get_uri                        caja_file_info_get_uri
 #define file_manager_file_info_get_mime_type                  caja_file_info_get_mime_type
+#define file_manager_file_info_get_file_type                  caja_file_info_get_file_type
+#define file_manager_file_info_get_location                   caja_file_info_get_location
 #define file_manager_file_info_list_copy                      caja_file_info_list_copy
 #define file_manager_file_info_list_free                      caja_file_info_list_free
 #define file_manager_menu_provider_emit_items_updated_signal  caja_menu_provider_emit_items_updated_signal
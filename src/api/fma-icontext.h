@@ -45,7 +45,7 @@
  * FMA_FACTORY_CONDITIONS_GROUP data group.
  */
 
-#include <glib-object.h>
+#include <gio/gio.h>
 
 G_BEGIN_DECLS
 
@@ -93,20 +93,22 @@ typedef struct {
 }
 	FMAIContextInterface;
 
-GType    fma_icontext_get_type        ( void );
+GType    fma_icontext_get_type            ( void );
 
-gboolean fma_icontext_are_equal       ( const FMAIContext *a, const FMAIContext *b );
-gboolean fma_icontext_is_candidate    ( const FMAIContext *context, guint target, GList *selection );
-gboolean fma_icontext_is_valid        ( const FMAIContext *context );
+gboolean fma_icontext_are_equal           ( const FMAIContext *a, const FMAIContext *b );
+gboolean fma_icontext_is_candidate        ( const FMAIContext *context, guint target, GList *selection );
+void     fma_icontext_is_candidate_async  ( const FMAIContext *context, guint target, GList *selection, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data );
+gboolean fma_icontext_is_candidate_finish ( const FMAIContext *context, GAsyncResult *result, GError **error );
+gboolean fma_icontext_is_valid            ( const FMAIContext *context );
 
-void     fma_icontext_check_mimetypes ( const FMAIContext *context );
+void     fma_icontext_check_mimetypes     ( const FMAIContext *context );
 
-void     fma_icontext_copy            ( FMAIContext *context, const FMAIContext *source );
-void     fma_icontext_read_done       ( FMAIContext *context );
-void     fma_icontext_set_scheme      ( FMAIContext *context, const gchar *scheme, gboolean selected );
-void     fma_icontext_set_only_desktop( FMAIContext *context, const gchar *desktop, gboolean selected );
-void     fma_icontext_set_not_desktop ( FMAIContext *context, const gchar *desktop, gboolean selected );
-void     fma_icontext_replace_folder  ( FMAIContext *context, const gchar *old, const gchar *new );
+void     fma_icontext_copy                ( FMAIContext *context, const FMAIContext *source );
+void     fma_icontext_read_done           ( FMAIContext *context );
+void     fma_icontext_set_scheme          ( FMAIContext *context, const gchar *scheme, gboolean selected );
+void     fma_icontext_set_only_desktop    ( FMAIContext *context, const gchar *desktop, gboolean selected );
+void     fma_icontext_set_not_desktop     ( FMAIContext *context, const gchar *desktop, gboolean selected );
+void     fma_icontext_replace_folder      ( FMAIContext *context, const gchar *old, const gchar *new );
 
 G_END_DECLS
 
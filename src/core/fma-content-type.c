@@ -0,0 +1,199 @@
+/*
+ * FileManager-Actions
+ * A file-manager extension which offers configurable context menu actions.
+ *
+ * Copyright (C) 2005 The GNOME Foundation
+ * Copyright (C) 2006-2008 Frederic Ruaudel and others (see AUTHORS)
+ * Copyright (C) 2009-2015 Pierre Wieser and others (see AUTHORS)
+ *
+ * FileManager-Actions is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * FileManager-Actions is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FileManager-Actions; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Frederic Ruaudel <grumz@grumz.net>
+ *   Rodrigo Moya <rodrigo@gnome-db.org>
+ *   Pierre Wieser <pwieser@trychlos.org>
+ *   ... and many others (see AUTHORS)
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <gio/gio.h>
+
+#include "fma-content-type.h"
+
+/* the memo of a file mimetype
+ */
+typedef struct {
+	gchar      *content_type;			/* NULL if unknown */
+	GHashTable *relations;				/* interned content type -> is_a + 1 */
+}
+	MimetypeMemo;
+
+static GMutex      st_mutex;
+static GHashTable *st_memo     = NULL;	/* file mimetype -> MimetypeMemo */
+static GList      *st_monitors = NULL;
+
+static void          monitor_database( void );
+static void          on_database_changed( GFileMonitor *monitor, GFile *file, GFile *other, GFileMonitorEvent event, void *empty );
+static MimetypeMemo *memo_get( const gchar *file_mimetype );
+static void          memo_free( MimetypeMemo *memo );
+
+/*
+ * fma_content_type_intern:
+ * @mimetype: the mimetype of a condition.
+ *
+ * Returns: the content type which corresponds to the @mimetype, as an
+ * interned string which may be used with fma_content_type_is_a(), or
+ * %NULL if there is no such content type.
+ */
+const gchar *
+fma_content_type_intern( const gchar *mimetype )
+{
+	gchar *content_type;
+	const gchar *interned;
+
+	g_return_val_if_fail( mimetype, NULL );
+
+	g_mutex_lock( &st_mutex );
+	if( !st_memo ){
+		st_memo = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, ( GDestroyNotify ) memo_free );
+		monitor_database();
+	}
+	g_mutex_unlock( &st_mutex );
+
+	content_type = g_content_type_from_mime_type( mimetype );
+	interned = content_type ? g_intern_string( content_type ) : NULL;
+	g_free( content_type );
+
+	return( interned );
+}
+
+/*
+ * fma_content_type_is_a:
+ * @file_mimetype: the mimetype of a file.
+ * @content_type: an interned content type, as returned by
+ *  fma_content_type_intern().
+ *
+ * Returns: %TRUE if the content type of the @file_mimetype is the
+ * @content_type or one of its subtypes, %FALSE else.
+ */
+gboolean
+fma_content_type_is_a( const gchar *file_mimetype, const gchar *content_type )
+{
+	MimetypeMemo *memo;
+	guint relation;
+
+	g_return_val_if_fail( file_mimetype, FALSE );
+	g_return_val_if_fail( content_type, FALSE );
+
+	g_mutex_lock( &st_mutex );
+
+	memo = memo_get( file_mimetype );
+	relation = GPOINTER_TO_UINT( g_hash_table_lookup( memo->relations, content_type ));
+
+	if( !relation ){
+		relation = 1 + ( memo->content_type && g_content_type_is_a( memo->content_type, content_type ));
+		g_hash_table_insert( memo->relations, ( gpointer ) content_type, GUINT_TO_POINTER( relation ));
+	}
+
+	g_mutex_unlock( &st_mutex );
+
+	return( relation == 2 );
+}
+
+/*
+ * the database is made of the mime.cache files found in the mime/
+ * subdirectory of each of the XDG data directories
+ *
+ * the mutex is expected to be locked by the caller
+ */
+static void
+monitor_database( void )
+{
+	static const gchar *thisfn = "fma_content_type_monitor_database";
+	const gchar * const *dirs;
+	gchar *fname;
+	GFile *file;
+	GFileMonitor *monitor;
+	GError *error;
+	guint i;
+
+	dirs = g_get_system_data_dirs();
+
+	for( i = 0 ; i <= g_strv_length(( gchar ** ) dirs ) ; ++i ){
+		fname = g_build_filename( i ? dirs[i-1] : g_get_user_data_dir(), "mime", "mime.cache", NULL );
+		file = g_file_new_for_path( fname );
+		error = NULL;
+		monitor = g_file_monitor_file( file, G_FILE_MONITOR_NONE, NULL, &error );
+
+		if( monitor ){
+			g_signal_connect( monitor, "changed", G_CALLBACK( on_database_changed ), NULL );
+			st_monitors = g_list_prepend( st_monitors, monitor );
+
+		} else {
+			g_debug( "%s: %s: %s", thisfn, fname, error->message );
+			g_error_free( error );
+		}
+
+		g_object_unref( file );
+		g_free( fname );
+	}
+}
+
+static void
+on_database_changed( GFileMonitor *monitor, GFile *file, GFile *other, GFileMonitorEvent event, void *empty )
+{
+	static const gchar *thisfn = "fma_content_type_on_database_changed";
+
+	g_debug( "%s: event=%d, emptying the memo", thisfn, event );
+
+	g_mutex_lock( &st_mutex );
+	g_hash_table_remove_all( st_memo );
+	g_mutex_unlock( &st_mutex );
+}
+
+/*
+ * the mutex is expected to be locked by the caller
+ */
+static MimetypeMemo *
+memo_get( const gchar *file_mimetype )
+{
+	MimetypeMemo *memo;
+
+	if( !st_memo ){
+		st_memo = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, ( GDestroyNotify ) memo_free );
+	}
+
+	memo = ( MimetypeMemo * ) g_hash_table_lookup( st_memo, file_mimetype );
+
+	if( !memo ){
+		memo = g_new0( MimetypeMemo, 1 );
+		memo->content_type = g_content_type_from_mime_type( file_mimetype );
+		memo->relations = g_hash_table_new( g_direct_hash, g_direct_equal );
+		g_hash_table_insert( st_memo, g_strdup( file_mimetype ), memo );
+	}
+
+	return( memo );
+}
+
+static void
+memo_free( MimetypeMemo *memo )
+{
+	g_free( memo->content_type );
+	g_hash_table_destroy( memo->relations );
+	g_free( memo );
+}
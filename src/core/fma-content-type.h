@@ -0,0 +1,64 @@
+/*
+ * FileManager-Actions
+ * A file-manager extension which offers configurable context menu actions.
+ *
+ * Copyright (C) 2005 The GNOME Foundation
+ * Copyright (C) 2006-2008 Frederic Ruaudel and others (see AUTHORS)
+ * Copyright (C) 2009-2015 Pierre Wieser and others (see AUTHORS)
+ *
+ * FileManager-Actions is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * FileManager-Actions is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FileManager-Actions; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Frederic Ruaudel <grumz@grumz.net>
+ *   Rodrigo Moya <rodrigo@gnome-db.org>
+ *   Pierre Wieser <pwieser@trychlos.org>
+ *   ... and many others (see AUTHORS)
+ */
+
+#ifndef __CORE_FMA_CONTENT_TYPE_H__
+#define __CORE_FMA_CONTENT_TYPE_H__
+
+/* @title: FMAContentType
+ * @short_description: A memo of the relations between content types
+ * @include: core/fma-content-type.h
+ *
+ * Checking a selection against mimetype conditions requires, for each
+ * selected file and each condition, to know whether the content type of
+ * the file is a subtype of the content type of the condition.
+ *
+ * The content types of the conditions are interned once, when the
+ * conditions are compiled. The content type of each file mimetype, and
+ * its relations with the content types of the conditions, are computed
+ * on first use, and then kept in a process-wide memo table.
+ *
+ * The memo is emptied when the shared-mime-info database changes.
+ *
+ * All functions are thread-safe, but the first call to
+ * fma_content_type_intern() should be done from the main thread, as the
+ * database is monitored from the thread-default main context of this
+ * first caller.
+ */
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+const gchar *fma_content_type_intern( const gchar *mimetype );
+
+gboolean     fma_content_type_is_a  ( const gchar *file_mimetype, const gchar *content_type );
+
+G_END_DECLS
+
+#endif /* __CORE_FMA_CONTENT_TYPE_H__ */
@@ -0,0 +1,270 @@
+/*
+ * FileManager-Actions
+ * A file-manager extension which offers configurable context menu actions.
+ *
+ * Copyright (C) 2005 The GNOME Foundation
+ * Copyright (C) 2006-2008 Frederic Ruaudel and others (see AUTHORS)
+ * Copyright (C) 2009-2015 Pierre Wieser and others (see AUTHORS)
+ *
+ * FileManager-Actions is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * FileManager-Actions is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FileManager-Actions; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Frederic Ruaudel <grumz@grumz.net>
+ *   Rodrigo Moya <rodrigo@gnome-db.org>
+ *   Pierre Wieser <pwieser@trychlos.org>
+ *   ... and many others (see AUTHORS)
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <gio/gio.h>
+#include <string.h>
+
+#include "fma-dbus-names.h"
+
+#define DBUS_SERVICE					"org.freedesktop.DBus"
+#define DBUS_PATH						"/org/freedesktop/DBus"
+#define DBUS_INTERFACE					"org.freedesktop.DBus"
+
+/* the state of the subscription
+ */
+enum {
+	NAMES_NONE = 0,						/* not yet initialized, or connection lost */
+	NAMES_CONNECTING,					/* waiting for the bus connection */
+	NAMES_LISTING,						/* waiting for the reply to ListNames */
+	NAMES_READY
+};
+
+static GMutex           st_mutex;
+static guint            st_status       = NAMES_NONE;
+static GHashTable      *st_names        = NULL;	/* the set of owned names */
+static GHashTable      *st_released     = NULL;	/* names released while listing */
+static GDBusConnection *st_connection   = NULL;
+static guint            st_subscription = 0;
+
+static void on_bus_ready( GObject *source, GAsyncResult *result, gpointer user_data );
+static void on_list_names_ready( GObject *source, GAsyncResult *result, gpointer user_data );
+static void on_name_owner_changed( GDBusConnection *connection, const gchar *sender, const gchar *path, const gchar *interface, const gchar *signal, GVariant *parameters, gpointer user_data );
+static void on_connection_closed( GDBusConnection *connection, gboolean remote_peer_vanished, GError *error, gpointer user_data );
+static void names_reset( void );
+
+/*
+ * fma_dbus_names_init:
+ *
+ * Starts maintaining the set of owned names, unless this is already
+ * done.
+ *
+ * This is called when compiling the first ShowIfRegistered condition,
+ * so that the set is likely ready when the first menu is built.
+ */
+void
+fma_dbus_names_init( void )
+{
+	static const gchar *thisfn = "fma_dbus_names_init";
+
+	g_mutex_lock( &st_mutex );
+
+	if( st_status == NAMES_NONE ){
+		g_debug( "%s: connecting to the session bus", thisfn );
+		st_status = NAMES_CONNECTING;
+		st_names = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, NULL );
+		st_released = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, NULL );
+		g_bus_get( G_BUS_TYPE_SESSION, NULL, on_bus_ready, NULL );
+	}
+
+	g_mutex_unlock( &st_mutex );
+}
+
+/*
+ * fma_dbus_names_has_owner:
+ * @name: a well-known or unique bus name.
+ *
+ * Returns: %TRUE if the @name is currently owned on the session bus,
+ * %FALSE else, or if this is not known yet.
+ */
+gboolean
+fma_dbus_names_has_owner( const gchar *name )
+{
+	gboolean has_owner;
+
+	g_return_val_if_fail( name && strlen( name ), FALSE );
+
+	fma_dbus_names_init();
+
+	g_mutex_lock( &st_mutex );
+	has_owner = st_names && g_hash_table_contains( st_names, name );
+	g_mutex_unlock( &st_mutex );
+
+	return( has_owner );
+}
+
+/*
+ * subscribe to NameOwnerChanged before listing the names, so that no
+ * change is lost between the two
+ */
+static void
+on_bus_ready( GObject *source, GAsyncResult *result, gpointer user_data )
+{
+	static const gchar *thisfn = "fma_dbus_names_on_bus_ready";
+	GDBusConnection *connection;
+	GError *error;
+
+	error = NULL;
+	connection = g_bus_get_finish( result, &error );
+
+	if( !connection ){
+		g_warning( "%s: %s", thisfn, error->message );
+		g_error_free( error );
+		g_mutex_lock( &st_mutex );
+		names_reset();
+		g_mutex_unlock( &st_mutex );
+		return;
+	}
+
+	g_mutex_lock( &st_mutex );
+	st_connection = connection;
+	st_status = NAMES_LISTING;
+	g_mutex_unlock( &st_mutex );
+
+	g_signal_connect( connection, "closed", G_CALLBACK( on_connection_closed ), NULL );
+
+	st_subscription = g_dbus_connection_signal_subscribe( connection,
+			DBUS_SERVICE, DBUS_INTERFACE, "NameOwnerChanged", DBUS_PATH, NULL,
+			G_DBUS_SIGNAL_FLAGS_NONE, on_name_owner_changed, NULL, NULL );
+
+	g_dbus_connection_call( connection,
+			DBUS_SERVICE, DBUS_PATH, DBUS_INTERFACE, "ListNames", NULL,
+			G_VARIANT_TYPE( "(as)" ), G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+			on_list_names_ready, NULL );
+}
+
+/*
+ * a name which has been released after we have subscribed to the
+ * signal may still be in the list, and must not be added
+ */
+static void
+on_list_names_ready( GObject *source, GAsyncResult *result, gpointer user_data )
+{
+	static const gchar *thisfn = "fma_dbus_names_on_list_names_ready";
+	GVariant *reply;
+	GVariantIter *iter;
+	gchar *name;
+	GError *error;
+
+	error = NULL;
+	reply = g_dbus_connection_call_finish( G_DBUS_CONNECTION( source ), result, &error );
+
+	/* the set will be built again on next request, unless the connection
+	 * has already been closed, and maybe a new one requested
+	 */
+	if( !reply ){
+		g_warning( "%s: %s", thisfn, error->message );
+		g_error_free( error );
+		g_mutex_lock( &st_mutex );
+		if( st_status == NAMES_LISTING && st_connection == G_DBUS_CONNECTION( source )){
+			names_reset();
+		}
+		g_mutex_unlock( &st_mutex );
+		return;
+	}
+
+	g_mutex_lock( &st_mutex );
+
+	if( st_status == NAMES_LISTING ){
+		g_variant_get( reply, "(as)", &iter );
+		while( g_variant_iter_loop( iter, "s", &name )){
+			if( !g_hash_table_contains( st_released, name )){
+				g_hash_table_add( st_names, g_strdup( name ));
+			}
+		}
+		g_variant_iter_free( iter );
+		g_hash_table_remove_all( st_released );
+		st_status = NAMES_READY;
+		g_debug( "%s: %u owned names", thisfn, g_hash_table_size( st_names ));
+	}
+
+	g_mutex_unlock( &st_mutex );
+
+	g_variant_unref( reply );
+}
+
+static void
+on_name_owner_changed( GDBusConnection *connection, const gchar *sender, const gchar *path, const gchar *interface, const gchar *signal, GVariant *parameters, gpointer user_data )
+{
+	const gchar *name, *old_owner, *new_owner;
+
+	g_variant_get( parameters, "(&s&s&s)", &name, &old_owner, &new_owner );
+
+	g_mutex_lock( &st_mutex );
+
+	if( st_names ){
+		if( strlen( new_owner )){
+			g_hash_table_add( st_names, g_strdup( name ));
+			g_hash_table_remove( st_released, name );
+
+		} else {
+			g_hash_table_remove( st_names, name );
+			if( st_status == NAMES_LISTING ){
+				g_hash_table_add( st_released, g_strdup( name ));
+			}
+		}
+	}
+
+	g_mutex_unlock( &st_mutex );
+}
+
+/*
+ * the set will be built again on next request
+ */
+static void
+on_connection_closed( GDBusConnection *connection, gboolean remote_peer_vanished, GError *error, gpointer user_data )
+{
+	static const gchar *thisfn = "fma_dbus_names_on_connection_closed";
+
+	g_debug( "%s: connection=%p, remote_peer_vanished=%s",
+			thisfn, ( void * ) connection, remote_peer_vanished ? "True":"False" );
+
+	g_mutex_lock( &st_mutex );
+	names_reset();
+	g_mutex_unlock( &st_mutex );
+}
+
+/*
+ * the mutex is expected to be locked by the caller
+ */
+static void
+names_reset( void )
+{
+	if( st_connection ){
+		if( st_subscription ){
+			g_dbus_connection_signal_unsubscribe( st_connection, st_subscription );
+			st_subscription = 0;
+		}
+		g_signal_handlers_disconnect_by_func( st_connection, on_connection_closed, NULL );
+		g_object_unref( st_connection );
+		st_connection = NULL;
+	}
+	if( st_names ){
+		g_hash_table_destroy( st_names );
+		st_names = NULL;
+	}
+	if( st_released ){
+		g_hash_table_destroy( st_released );
+		st_released = NULL;
+	}
+	st_status = NAMES_NONE;
+}
@@ -0,0 +1,61 @@
+/*
+ * FileManager-Actions
+ * A file-manager extension which offers configurable context menu actions.
+ *
+ * Copyright (C) 2005 The GNOME Foundation
+ * Copyright (C) 2006-2008 Frederic Ruaudel and others (see AUTHORS)
+ * Copyright (C) 2009-2015 Pierre Wieser and others (see AUTHORS)
+ *
+ * FileManager-Actions is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * FileManager-Actions is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FileManager-Actions; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Frederic Ruaudel <grumz@grumz.net>
+ *   Rodrigo Moya <rodrigo@gnome-db.org>
+ *   Pierre Wieser <pwieser@trychlos.org>
+ *   ... and many others (see AUTHORS)
+ */
+
+#ifndef __CORE_FMA_DBUS_NAMES_H__
+#define __CORE_FMA_DBUS_NAMES_H__
+
+/* @title: FMADBusNames
+ * @short_description: The set of the names owned on the session bus
+ * @include: core/fma-dbus-names.h
+ *
+ * ShowIfRegistered conditions check whether a given name is owned on
+ * the D-Bus session bus. Rather than asking the bus daemon each time a
+ * menu is built, we maintain a process-wide set of the owned names:
+ * the set is first filled with the reply to ListNames, then kept up
+ * to date by subscribing to the NameOwnerChanged signal.
+ *
+ * Both are asynchronous: until the reply to ListNames is received, the
+ * names which have not been seen yet are said not owned.
+ *
+ * All functions are thread-safe, but the first call to one of them
+ * should be done from the main thread, as the D-Bus callbacks are
+ * dispatched in the thread-default main context of this first caller.
+ */
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+void     fma_dbus_names_init     ( void );
+
+gboolean fma_dbus_names_has_owner( const gchar *name );
+
+G_END_DECLS
+
+#endif /* __CORE_FMA_DBUS_NAMES_H__ */
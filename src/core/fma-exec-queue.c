@@ -0,0 +1,812 @@
+/*
+ * FileManager-Actions
+ * A file-manager extension which offers configurable context menu actions.
+ *
+ * Copyright (C) 2005 The GNOME Foundation
+ * Copyright (C) 2006-2008 Frederic Ruaudel and others (see AUTHORS)
+ * Copyright (C) 2009-2015 Pierre Wieser and others (see AUTHORS)
+ *
+ * FileManager-Actions is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * FileManager-Actions is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FileManager-Actions; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Frederic Ruaudel <grumz@grumz.net>
+ *   Rodrigo Moya <rodrigo@gnome-db.org>
+ *   Pierre Wieser <pwieser@trychlos.org>
+ *   ... and many others (see AUTHORS)
+ */
+
+/* the posix_spawn_file_actions_add*_np() functions are GNU extensions
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/* posix_spawnp() lets the libc use vfork() or clone(CLONE_VM), and so
+ * avoid duplicating the page tables of the whole file manager for each
+ * child; it is only used when the inherited descriptors can be closed
+ */
+#if defined( HAVE_POSIX_SPAWNP ) && defined( HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP )
+#define EXEC_QUEUE_POSIX_SPAWN
+#include <signal.h>
+#include <spawn.h>
+
+extern char **environ;
+#endif
+
+#include <glib/gi18n.h>
+#include <string.h>
+
+#include "fma-exec-queue.h"
+#include "fma-settings.h"
+
+/* private class data
+ */
+struct _FMAExecQueueClassPrivate {
+	void *empty;						/* so that gcc -pedantic is happy */
+};
+
+/* private instance data
+ */
+struct _FMAExecQueuePrivate {
+	gboolean dispose_has_run;
+	GQueue  *pending;					/* ExecJob, in the order they have been pushed */
+	guint    running;
+	guint    total;						/* count of jobs pushed in the current batch */
+	guint    done;						/* count of jobs handled in the current batch */
+	guint    cancelled;
+};
+
+/* the size of the chunks read from the captured output
+ */
+#define EXEC_READ_SIZE					4096
+
+typedef struct _ExecJob ExecJob;
+
+/* a captured output stream, read into a ring buffer
+ */
+typedef struct {
+	ExecJob    *job;
+	gint        fd;							/* 1 for stdout, 2 for stderr */
+	GIOChannel *channel;
+	guint       source_id;
+	gchar      *data;						/* allocated on first read */
+	gsize       size;
+	gsize       head;						/* where the next byte is written */
+	gsize       length;
+	gulong      dropped;					/* count of overwritten bytes */
+}
+	ExecReader;
+
+/* a command to be run
+ */
+struct _ExecJob {
+	FMAExecQueue          *queue;
+	gchar                **argv;
+	gchar                 *wdir;
+	gchar                 *command;
+	gboolean               capture;
+	FMAExecQueueOutputFunc output;
+	FMAExecQueueDoneFunc   done;
+	gpointer               user_data;
+	ExecReader            *readers[2];		/* stdout, stderr */
+	guint                  waited;			/* the child, and its captured streams */
+	gint                   status;
+};
+
+/* signals
+ */
+enum {
+	PROGRESS,
+	FINISHED,
+	LAST_SIGNAL
+};
+
+static GObjectClass *st_parent_class           = NULL;
+static gint          st_signals[ LAST_SIGNAL ] = { 0 };
+static FMAExecQueue *st_queue                  = NULL;
+
+static GType    register_type( void );
+static void     class_init( FMAExecQueueClass *klass );
+static void     instance_init( GTypeInstance *instance, gpointer klass );
+static void     instance_dispose( GObject *object );
+static void     instance_finalize( GObject *object );
+
+static guint    get_max_children( void );
+static void     queue_drain( FMAExecQueue *queue );
+static gboolean queue_spawn( FMAExecQueue *queue, ExecJob *job );
+static gboolean queue_spawn_posix( ExecJob *job, GPid *child_pid, GError **error );
+static void     queue_job_done( FMAExecQueue *queue, ExecJob *job, gint status );
+static void     queue_check_finished( FMAExecQueue *queue );
+static void     child_watch_fn( GPid pid, gint status, ExecJob *job );
+static void     job_part_done( ExecJob *job );
+static void     job_free( ExecJob *job );
+
+static ExecReader *reader_new( ExecJob *job, gint fd, gint pipe );
+static gboolean    reader_watch_fn( GIOChannel *channel, GIOCondition condition, ExecReader *reader );
+static void        reader_write( ExecReader *reader, const gchar *data, gsize count );
+static gchar      *reader_get_content( const ExecReader *reader );
+static void        reader_free( ExecReader *reader );
+
+GType
+fma_exec_queue_get_type( void )
+{
+	static GType object_type = 0;
+
+	if( !object_type ){
+		object_type = register_type();
+	}
+
+	return( object_type );
+}
+
+static GType
+register_type( void )
+{
+	static const gchar *thisfn = "fma_exec_queue_register_type";
+	GType type;
+
+	static GTypeInfo info = {
+		sizeof( FMAExecQueueClass ),
+		( GBaseInitFunc ) NULL,
+		( GBaseFinalizeFunc ) NULL,
+		( GClassInitFunc ) class_init,
+		NULL,
+		NULL,
+		sizeof( FMAExecQueue ),
+		0,
+		( GInstanceInitFunc ) instance_init
+	};
+
+	g_debug( "%s", thisfn );
+
+	type = g_type_register_static( G_TYPE_OBJECT, "FMAExecQueue", &info, 0 );
+
+	return( type );
+}
+
+static void
+class_init( FMAExecQueueClass *klass )
+{
+	static const gchar *thisfn = "fma_exec_queue_class_init";
+	GObjectClass *object_class;
+
+	g_debug( "%s: klass=%p", thisfn, ( void * ) klass );
+
+	st_parent_class = g_type_class_peek_parent( klass );
+
+	object_class = G_OBJECT_CLASS( klass );
+	object_class->dispose = instance_dispose;
+	object_class->finalize = instance_finalize;
+
+	klass->private = g_new0( FMAExecQueueClassPrivate, 1 );
+
+	/*
+	 * FMAExecQueue::exec-queue-progress:
+	 *
+	 * This signal is sent each time a command of the queue has been
+	 * handled, whether it has been run or has failed to be spawned.
+	 *
+	 * Signal args:
+	 * - the count of handled commands in the current batch
+	 * - the count of commands pushed in the current batch
+	 */
+	st_signals[ PROGRESS ] = g_signal_new(
+				EXEC_QUEUE_SIGNAL_PROGRESS,
+				FMA_TYPE_EXEC_QUEUE,
+				G_SIGNAL_RUN_LAST,
+				0,									/* no default handler */
+				NULL,
+				NULL,
+				NULL,
+				G_TYPE_NONE,
+				2,
+				G_TYPE_UINT, G_TYPE_UINT );
+
+	/*
+	 * FMAExecQueue::exec-queue-finished:
+	 *
+	 * This signal is sent when the queue becomes idle, i.e. when there
+	 * is no more pending command nor running child.
+	 *
+	 * Signal args:
+	 * - the count of handled commands in the batch
+	 * - the count of cancelled commands in the batch
+	 */
+	st_signals[ FINISHED ] = g_signal_new(
+				EXEC_QUEUE_SIGNAL_FINISHED,
+				FMA_TYPE_EXEC_QUEUE,
+				G_SIGNAL_RUN_LAST,
+				0,									/* no default handler */
+				NULL,
+				NULL,
+				NULL,
+				G_TYPE_NONE,
+				2,
+				G_TYPE_UINT, G_TYPE_UINT );
+}
+
+static void
+instance_init( GTypeInstance *instance, gpointer klass )
+{
+	static const gchar *thisfn = "fma_exec_queue_instance_init";
+	FMAExecQueue *self;
+
+	g_return_if_fail( FMA_IS_EXEC_QUEUE( instance ));
+
+	g_debug( "%s: instance=%p (%s), klass=%p",
+			thisfn, ( void * ) instance, G_OBJECT_TYPE_NAME( instance ), ( void * ) klass );
+
+	self = FMA_EXEC_QUEUE( instance );
+
+	self->private = g_new0( FMAExecQueuePrivate, 1 );
+
+	self->private->pending = g_queue_new();
+	self->private->running = 0;
+	self->private->total = 0;
+	self->private->done = 0;
+	self->private->cancelled = 0;
+
+	self->private->dispose_has_run = FALSE;
+}
+
+static void
+instance_dispose( GObject *object )
+{
+	static const gchar *thisfn = "fma_exec_queue_instance_dispose";
+	FMAExecQueue *self;
+
+	g_return_if_fail( FMA_IS_EXEC_QUEUE( object ));
+
+	self = FMA_EXEC_QUEUE( object );
+
+	if( !self->private->dispose_has_run ){
+
+		g_debug( "%s: object=%p (%s)", thisfn, ( void * ) object, G_OBJECT_TYPE_NAME( object ));
+
+		self->private->dispose_has_run = TRUE;
+
+		if( G_OBJECT_CLASS( st_parent_class )->dispose ){
+			G_OBJECT_CLASS( st_parent_class )->dispose( object );
+		}
+	}
+}
+
+static void
+instance_finalize( GObject *object )
+{
+	static const gchar *thisfn = "fma_exec_queue_instance_finalize";
+	FMAExecQueue *self;
+
+	g_return_if_fail( FMA_IS_EXEC_QUEUE( object ));
+
+	g_debug( "%s: object=%p (%s)", thisfn, ( void * ) object, G_OBJECT_TYPE_NAME( object ));
+
+	self = FMA_EXEC_QUEUE( object );
+
+	g_queue_free_full( self->private->pending, ( GDestroyNotify ) job_free );
+
+	g_free( self->private );
+
+	/* chain call to parent class */
+	if( G_OBJECT_CLASS( st_parent_class )->finalize ){
+		G_OBJECT_CLASS( st_parent_class )->finalize( object );
+	}
+}
+
+/*
+ * fma_exec_queue_get_default:
+ *
+ * Returns: the execution queue of the process, which is allocated on
+ * first call; the returned reference is owned by the queue itself, and
+ * should not be released by the caller.
+ */
+FMAExecQueue *
+fma_exec_queue_get_default( void )
+{
+	if( !st_queue ){
+		st_queue = g_object_new( FMA_TYPE_EXEC_QUEUE, NULL );
+	}
+
+	return( st_queue );
+}
+
+/*
+ * fma_exec_queue_push:
+ * @queue: this #FMAExecQueue.
+ * @argv: the command to be spawned, as a %NULL-terminated array of strings.
+ * @wdir: (allow-none): the working directory of the child.
+ * @command: the command as a string, for display purpose.
+ * @capture: whether the standard output and error of the child have to
+ *  be captured.
+ * @output: (allow-none): the function to be called each time a chunk of
+ *  the captured output has been read.
+ * @done: (allow-none): the function to be called when the child exits.
+ * @user_data: the data to be passed to the @output and @done functions.
+ *
+ * Pushes a copy of the command at the end of the queue, and spawns it
+ * immediately if less than the maximum count of children are running.
+ */
+void
+fma_exec_queue_push( FMAExecQueue *queue, gchar **argv, const gchar *wdir, const gchar *command, gboolean capture, FMAExecQueueOutputFunc output, FMAExecQueueDoneFunc done, gpointer user_data )
+{
+	ExecJob *job;
+
+	g_return_if_fail( FMA_IS_EXEC_QUEUE( queue ));
+	g_return_if_fail( argv && argv[0] );
+
+	if( !queue->private->dispose_has_run ){
+
+		job = g_new0( ExecJob, 1 );
+		job->queue = queue;
+		job->argv = g_strdupv( argv );
+		job->wdir = g_strdup( wdir );
+		job->command = g_strdup( command );
+		job->capture = capture;
+		job->output = output;
+		job->done = done;
+		job->user_data = user_data;
+
+		g_queue_push_tail( queue->private->pending, job );
+		queue->private->total += 1;
+
+		queue_drain( queue );
+	}
+}
+
+/*
+ * fma_exec_queue_cancel:
+ * @queue: this #FMAExecQueue.
+ *
+ * Drops the pending commands. The children which are already running
+ * are left untouched.
+ */
+void
+fma_exec_queue_cancel( FMAExecQueue *queue )
+{
+	static const gchar *thisfn = "fma_exec_queue_cancel";
+
+	g_return_if_fail( FMA_IS_EXEC_QUEUE( queue ));
+
+	if( !queue->private->dispose_has_run ){
+
+		g_debug( "%s: queue=%p, pending=%u, running=%u",
+				thisfn, ( void * ) queue, g_queue_get_length( queue->private->pending ), queue->private->running );
+
+		queue->private->cancelled += g_queue_get_length( queue->private->pending );
+		g_queue_free_full( queue->private->pending, ( GDestroyNotify ) job_free );
+		queue->private->pending = g_queue_new();
+
+		queue_check_finished( queue );
+	}
+}
+
+/*
+ * fma_exec_queue_is_idle:
+ * @queue: this #FMAExecQueue.
+ *
+ * Returns: %TRUE if there is neither pending command nor running child.
+ */
+gboolean
+fma_exec_queue_is_idle( const FMAExecQueue *queue )
+{
+	g_return_val_if_fail( FMA_IS_EXEC_QUEUE( queue ), TRUE );
+
+	return( !queue->private->running && g_queue_is_empty( queue->private->pending ));
+}
+
+/*
+ * the preference is read each time the queue is drained, so that a
+ * change is taken into account without having to restart
+ */
+static guint
+get_max_children( void )
+{
+	guint max;
+
+	max = fma_settings_get_uint( IPREFS_EXEC_MAX_CHILDREN, NULL, NULL );
+
+	return( max ? max : MAX( 1, g_get_num_processors()));
+}
+
+static void
+queue_drain( FMAExecQueue *queue )
+{
+	ExecJob *job;
+	guint max;
+
+	max = get_max_children();
+
+	while( queue->private->running < max && !g_queue_is_empty( queue->private->pending )){
+		job = ( ExecJob * ) g_queue_pop_head( queue->private->pending );
+
+		if( queue_spawn( queue, job )){
+			queue->private->running += 1;
+
+		} else {
+			queue_job_done( queue, job, -1 );
+		}
+	}
+
+	queue_check_finished( queue );
+}
+
+/*
+ * it appears that at least mplayer does not support g_spawn_async_with_pipes
+ * (at least when not run in '-quiet' mode) while, e.g., totem and vlc rightly
+ * support this function
+ * So only use g_spawn_async_with_pipes when we really need to get back
+ * the content of output and error streams
+ * See https://bugzilla.gnome.org/show_bug.cgi?id=644289.
+ */
+static gboolean
+queue_spawn( FMAExecQueue *queue, ExecJob *job )
+{
+	static const gchar *thisfn = "fma_exec_queue_spawn";
+	GError *error;
+	GPid child_pid;
+	gint fd_stdout, fd_stderr;
+
+	error = NULL;
+	child_pid = ( GPid ) 0;
+
+	g_debug( "%s: command=%s, wdir=%s", thisfn, job->command, job->wdir );
+
+	if( job->capture ){
+		g_spawn_async_with_pipes(
+				job->wdir,
+				job->argv,
+				NULL,
+				G_SPAWN_SEARCH_PATH | G_SPAWN_DO_NOT_REAP_CHILD,
+				NULL,
+				NULL,
+				&child_pid,
+				NULL,
+				&fd_stdout,
+				&fd_stderr,
+				&error );
+
+	} else if( !queue_spawn_posix( job, &child_pid, &error )){
+		g_spawn_async(
+				job->wdir,
+				job->argv,
+				NULL,
+				G_SPAWN_SEARCH_PATH | G_SPAWN_DO_NOT_REAP_CHILD,
+				NULL,
+				NULL,
+				&child_pid,
+				&error );
+	}
+
+	if( error ){
+		g_warning( "%s: g_spawn_async: %s", thisfn, error->message );
+		g_error_free( error );
+		return( FALSE );
+	}
+
+	/* the output is read while the child is running, so that it never
+	 * blocks on a full pipe
+	 */
+	if( job->capture ){
+		job->readers[0] = reader_new( job, 1, fd_stdout );
+		job->readers[1] = reader_new( job, 2, fd_stderr );
+		job->waited = 3;
+
+	} else {
+		job->waited = 1;
+	}
+
+	g_child_watch_add( child_pid, ( GChildWatchFunc ) child_watch_fn, job );
+
+	return( TRUE );
+}
+
+/*
+ * spawns the job with posix_spawnp(), resetting the signal mask and the
+ * handlers as g_spawn_async() does, and closing the descriptors above
+ * stderr
+ *
+ * Returns: %TRUE if the job has been handled here, the @error being set
+ * if the spawn has failed, or %FALSE if it has to be spawned by GLib.
+ */
+static gboolean
+queue_spawn_posix( ExecJob *job, GPid *child_pid, GError **error )
+{
+#ifdef EXEC_QUEUE_POSIX_SPAWN
+	posix_spawnattr_t attr;
+	posix_spawn_file_actions_t actions;
+	sigset_t sigs;
+	pid_t pid;
+	gint ret;
+
+#ifndef HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP
+	if( job->wdir ){
+		return( FALSE );
+	}
+#endif
+
+	posix_spawnattr_init( &attr );
+	posix_spawn_file_actions_init( &actions );
+
+	sigemptyset( &sigs );
+	posix_spawnattr_setsigmask( &attr, &sigs );
+	sigaddset( &sigs, SIGPIPE );
+	sigaddset( &sigs, SIGCHLD );
+	sigaddset( &sigs, SIGHUP );
+	sigaddset( &sigs, SIGINT );
+	sigaddset( &sigs, SIGQUIT );
+	sigaddset( &sigs, SIGTERM );
+	posix_spawnattr_setsigdefault( &attr, &sigs );
+	posix_spawnattr_setflags( &attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF );
+
+	posix_spawn_file_actions_addclosefrom_np( &actions, 3 );
+#ifdef HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP
+	if( job->wdir ){
+		posix_spawn_file_actions_addchdir_np( &actions, job->wdir );
+	}
+#endif
+
+	ret = posix_spawnp( &pid, job->argv[0], &actions, &attr, job->argv, environ );
+
+	posix_spawn_file_actions_destroy( &actions );
+	posix_spawnattr_destroy( &attr );
+
+	if( ret ){
+		g_set_error( error, G_SPAWN_ERROR, G_SPAWN_ERROR_FAILED, "%s: %s", job->argv[0], g_strerror( ret ));
+	} else {
+		*child_pid = ( GPid ) pid;
+	}
+
+	return( TRUE );
+#else
+	return( FALSE );
+#endif
+}
+
+/*
+ * the job has been handled: either the child has exited, or it has
+ * failed to be spawned (status is then -1)
+ */
+static void
+queue_job_done( FMAExecQueue *queue, ExecJob *job, gint status )
+{
+	gchar *std_output, *std_error;
+
+	if( job->done && status != -1 ){
+		std_output = job->readers[0] ? reader_get_content( job->readers[0] ) : NULL;
+		std_error = job->readers[1] ? reader_get_content( job->readers[1] ) : NULL;
+
+		job->done( job->command, status, std_output, std_error, job->user_data );
+
+		g_free( std_output );
+		g_free( std_error );
+	}
+
+	job_free( job );
+
+	queue->private->done += 1;
+	g_signal_emit_by_name( queue, EXEC_QUEUE_SIGNAL_PROGRESS, queue->private->done, queue->private->total );
+}
+
+static void
+queue_check_finished( FMAExecQueue *queue )
+{
+	static const gchar *thisfn = "fma_exec_queue_check_finished";
+	guint done, cancelled;
+
+	if( fma_exec_queue_is_idle( queue ) && ( queue->private->total || queue->private->cancelled )){
+
+		done = queue->private->done;
+		cancelled = queue->private->cancelled;
+
+		queue->private->total = 0;
+		queue->private->done = 0;
+		queue->private->cancelled = 0;
+
+		g_debug( "%s: done=%u, cancelled=%u", thisfn, done, cancelled );
+		g_signal_emit_by_name( queue, EXEC_QUEUE_SIGNAL_FINISHED, done, cancelled );
+	}
+}
+
+static void
+child_watch_fn( GPid pid, gint status, ExecJob *job )
+{
+	static const gchar *thisfn = "fma_exec_queue_child_watch_fn";
+
+	g_debug( "%s: pid=%u, status=%d", thisfn, ( guint ) pid, status );
+	g_spawn_close_pid( pid );
+
+	job->status = status;
+	job_part_done( job );
+}
+
+/*
+ * the job is only done when the child has exited and its captured
+ * output has been fully read, whatever the order
+ */
+static void
+job_part_done( ExecJob *job )
+{
+	FMAExecQueue *queue;
+
+	job->waited -= 1;
+
+	if( !job->waited ){
+		queue = job->queue;
+		queue->private->running -= 1;
+
+		queue_job_done( queue, job, job->status );
+		queue_drain( queue );
+	}
+}
+
+static void
+job_free( ExecJob *job )
+{
+	if( job->readers[0] ){
+		reader_free( job->readers[0] );
+	}
+	if( job->readers[1] ){
+		reader_free( job->readers[1] );
+	}
+	g_strfreev( job->argv );
+	g_free( job->wdir );
+	g_free( job->command );
+	g_free( job );
+}
+
+/*
+ * the ring buffer is bounded by the preference, read when the child is
+ * spawned
+ */
+static ExecReader *
+reader_new( ExecJob *job, gint fd, gint pipe )
+{
+	ExecReader *reader;
+
+	reader = g_new0( ExecReader, 1 );
+	reader->job = job;
+	reader->fd = fd;
+	reader->size = MAX( 1, fma_settings_get_uint( IPREFS_EXEC_OUTPUT_MAX, NULL, NULL ));
+
+	reader->channel = g_io_channel_unix_new( pipe );
+	g_io_channel_set_close_on_unref( reader->channel, TRUE );
+	g_io_channel_set_encoding( reader->channel, NULL, NULL );
+	g_io_channel_set_buffered( reader->channel, FALSE );
+	g_io_channel_set_flags( reader->channel, G_IO_FLAG_NONBLOCK, NULL );
+
+	reader->source_id = g_io_add_watch(
+			reader->channel, G_IO_IN | G_IO_HUP | G_IO_ERR, ( GIOFunc ) reader_watch_fn, reader );
+
+	return( reader );
+}
+
+static gboolean
+reader_watch_fn( GIOChannel *channel, GIOCondition condition, ExecReader *reader )
+{
+	static const gchar *thisfn = "fma_exec_queue_reader_watch_fn";
+	gchar buf[EXEC_READ_SIZE];
+	gsize count;
+	GIOStatus status;
+	GError *error;
+	ExecJob *job;
+
+	job = reader->job;
+	error = NULL;
+	count = 0;
+	status = g_io_channel_read_chars( channel, buf, sizeof( buf ), &count, &error );
+
+	if( count ){
+		reader_write( reader, buf, count );
+		if( job->output ){
+			job->output( job->command, reader->fd, buf, count, job->user_data );
+		}
+	}
+
+	if( status == G_IO_STATUS_NORMAL || status == G_IO_STATUS_AGAIN ){
+		return( TRUE );
+	}
+
+	if( error ){
+		g_warning( "%s: g_io_channel_read_chars: %s", thisfn, error->message );
+		g_error_free( error );
+	}
+
+	g_debug( "%s: command=%s, fd=%d, length=%lu, dropped=%lu",
+			thisfn, job->command, reader->fd, ( gulong ) reader->length, reader->dropped );
+
+	reader->source_id = 0;
+	job_part_done( job );
+
+	return( FALSE );
+}
+
+/*
+ * only keeps the last bytes when the output exceeds the size of the buffer
+ */
+static void
+reader_write( ExecReader *reader, const gchar *data, gsize count )
+{
+	gsize first;
+
+	if( !reader->data ){
+		reader->data = g_malloc( reader->size );
+	}
+
+	if( count >= reader->size ){
+		reader->dropped += reader->length + count - reader->size;
+		memcpy( reader->data, data + count - reader->size, reader->size );
+		reader->head = 0;
+		reader->length = reader->size;
+		return;
+	}
+
+	first = MIN( count, reader->size - reader->head );
+	memcpy( reader->data + reader->head, data, first );
+	memcpy( reader->data, data + first, count - first );
+	reader->head = ( reader->head + count ) % reader->size;
+
+	if( reader->length + count > reader->size ){
+		reader->dropped += reader->length + count - reader->size;
+		reader->length = reader->size;
+
+	} else {
+		reader->length += count;
+	}
+}
+
+static gchar *
+reader_get_content( const ExecReader *reader )
+{
+	GString *content;
+	gsize start, length, first;
+
+	content = g_string_sized_new( reader->length + 64 );
+	length = reader->length;
+	start = length ? ( reader->head + reader->size - length ) % reader->size : 0;
+
+	if( reader->dropped ){
+		g_string_append_printf( content, _( "[... %lu bytes truncated ...]" ), reader->dropped );
+		content = g_string_append_c( content, '\n' );
+
+		/* do not begin with the end of a truncated UTF-8 character */
+		while( length && ( reader->data[start] & 0xc0 ) == 0x80 ){
+			start = ( start + 1 ) % reader->size;
+			length -= 1;
+		}
+	}
+
+	if( length ){
+		first = MIN( length, reader->size - start );
+		content = g_string_append_len( content, reader->data + start, first );
+		content = g_string_append_len( content, reader->data, length - first );
+	}
+
+	return( g_string_free( content, FALSE ));
+}
+
+static void
+reader_free( ExecReader *reader )
+{
+	if( reader->source_id ){
+		g_source_remove( reader->source_id );
+	}
+	g_io_channel_unref( reader->channel );
+	g_free( reader->data );
+	g_free( reader );
+}
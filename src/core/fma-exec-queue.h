@@ -0,0 +1,126 @@
+/*
+ * FileManager-Actions
+ * A file-manager extension which offers configurable context menu actions.
+ *
+ * Copyright (C) 2005 The GNOME Foundation
+ * Copyright (C) 2006-2008 Frederic Ruaudel and others (see AUTHORS)
+ * Copyright (C) 2009-2015 Pierre Wieser and others (see AUTHORS)
+ *
+ * FileManager-Actions is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * FileManager-Actions is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FileManager-Actions; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Frederic Ruaudel <grumz@grumz.net>
+ *   Rodrigo Moya <rodrigo@gnome-db.org>
+ *   Pierre Wieser <pwieser@trychlos.org>
+ *   ... and many others (see AUTHORS)
+ */
+
+#ifndef __CORE_FMA_EXEC_QUEUE_H__
+#define __CORE_FMA_EXEC_QUEUE_H__
+
+/* @title: FMAExecQueue
+ * @short_description: The scheduler of the executed commands
+ * @include: core/fma-exec-queue.h
+ *
+ * The commands of the executed actions are not spawned as soon as they
+ * are expanded, but pushed to a FIFO queue: at most a configurable count
+ * of children run at the same time, the next pending command being
+ * spawned each time a child exits. A singular-form action executed on
+ * thousands of files so does not start thousands of processes at once.
+ *
+ * The maximum count of concurrent children is read from the
+ * 'exec-max-children' preference, and defaults to the count of
+ * processors.
+ *
+ * The pending commands may be cancelled; the commands which are already
+ * running are left untouched.
+ *
+ * The queue emits a progress signal each time a command has been
+ * handled (whether it has been run or has failed to be spawned), and a
+ * finished signal when the queue becomes idle again. The counters are
+ * then reset for the next batch.
+ *
+ * When the output of a command is captured, its standard output and
+ * error are read as soon as the child has been spawned, without blocking
+ * the main loop, so that a chatty child never stalls on a full pipe. Each
+ * stream is kept in a ring buffer bounded by the 'exec-output-max'
+ * preference: only the last bytes are kept, a marker telling how many
+ * bytes have been truncated. The read chunks may also be forwarded as
+ * they come to an output function.
+ *
+ * The queue relies on the default GLib main context to be notified of
+ * the end of the children and of their output.
+ */
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define FMA_TYPE_EXEC_QUEUE                ( fma_exec_queue_get_type())
+#define FMA_EXEC_QUEUE( object )           ( G_TYPE_CHECK_INSTANCE_CAST( object, FMA_TYPE_EXEC_QUEUE, FMAExecQueue ))
+#define FMA_EXEC_QUEUE_CLASS( klass )      ( G_TYPE_CHECK_CLASS_CAST( klass, FMA_TYPE_EXEC_QUEUE, FMAExecQueueClass ))
+#define FMA_IS_EXEC_QUEUE( object )        ( G_TYPE_CHECK_INSTANCE_TYPE( object, FMA_TYPE_EXEC_QUEUE ))
+#define FMA_IS_EXEC_QUEUE_CLASS( klass )   ( G_TYPE_CHECK_CLASS_TYPE(( klass ), FMA_TYPE_EXEC_QUEUE ))
+#define FMA_EXEC_QUEUE_GET_CLASS( object ) ( G_TYPE_INSTANCE_GET_CLASS(( object ), FMA_TYPE_EXEC_QUEUE, FMAExecQueueClass ))
+
+typedef struct _FMAExecQueuePrivate       FMAExecQueuePrivate;
+
+typedef struct {
+	/*< private >*/
+	GObject              parent;
+	FMAExecQueuePrivate *private;
+}
+	FMAExecQueue;
+
+typedef struct _FMAExecQueueClassPrivate  FMAExecQueueClassPrivate;
+
+typedef struct {
+	/*< private >*/
+	GObjectClass              parent;
+	FMAExecQueueClassPrivate *private;
+}
+	FMAExecQueueClass;
+
+/* signals
+ *
+ * progress: ( FMAExecQueue *queue, guint done, guint total, gpointer user_data )
+ * finished: ( FMAExecQueue *queue, guint done, guint cancelled, gpointer user_data )
+ */
+#define EXEC_QUEUE_SIGNAL_PROGRESS				"exec-queue-progress"
+#define EXEC_QUEUE_SIGNAL_FINISHED				"exec-queue-finished"
+
+/* the function called when a child has exited, and its output has been
+ * fully read
+ * @std_output and @std_error are only set when the command has been
+ * pushed with its output being captured
+ */
+typedef void ( *FMAExecQueueDoneFunc )  ( const gchar *command, gint status, const gchar *std_output, const gchar *std_error, gpointer user_data );
+
+/* the function called each time a chunk of a captured output has been
+ * read; @fd is 1 for the standard output, 2 for the standard error
+ */
+typedef void ( *FMAExecQueueOutputFunc )( const gchar *command, gint fd, const gchar *data, gsize length, gpointer user_data );
+
+GType         fma_exec_queue_get_type   ( void );
+
+FMAExecQueue *fma_exec_queue_get_default( void );
+
+void          fma_exec_queue_push       ( FMAExecQueue *queue, gchar **argv, const gchar *wdir, const gchar *command, gboolean capture, FMAExecQueueOutputFunc output, FMAExecQueueDoneFunc done, gpointer user_data );
+void          fma_exec_queue_cancel     ( FMAExecQueue *queue );
+gboolean      fma_exec_queue_is_idle    ( const FMAExecQueue *queue );
+
+G_END_DECLS
+
+#endif /* __CORE_FMA_EXEC_QUEUE_H__ */
@@ -44,6 +44,7 @@
 
 #include "fma-factory-object.h"
 #include "fma-factory-provider.h"
+#include "fma-icontext-program.h"
 
 typedef gboolean ( *FMADataDefIterFunc )( FMADataDef *def, void *user_data );
 
@@ -827,6 +828,12 @@ fma_factory_object_set_from_value( FMAIFactoryObject *object, const gchar *name,
 			attach_boxed_to_object( object, boxed );
 		}
 	}
+
+	/* the compiled conditions are no more up to date
+	 */
+	if( FMA_IS_ICONTEXT( object )){
+		fma_icontext_program_reset( FMA_ICONTEXT( object ));
+	}
 }
 
 /*
@@ -859,6 +866,12 @@ fma_factory_object_set_from_void( FMAIFactoryObject *object, const gchar *name,
 			attach_boxed_to_object( object, boxed );
 		}
 	}
+
+	/* the compiled conditions are no more up to date
+	 */
+	if( FMA_IS_ICONTEXT( object )){
+		fma_icontext_program_reset( FMA_ICONTEXT( object ));
+	}
 }
 
 static FMADataGroup *
@@ -0,0 +1,248 @@
+/*
+ * FileManager-Actions
+ * A file-manager extension which offers configurable context menu actions.
+ *
+ * Copyright (C) 2005 The GNOME Foundation
+ * Copyright (C) 2006-2008 Frederic Ruaudel and others (see AUTHORS)
+ * Copyright (C) 2009-2015 Pierre Wieser and others (see AUTHORS)
+ *
+ * FileManager-Actions is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * FileManager-Actions is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FileManager-Actions; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Frederic Ruaudel <grumz@grumz.net>
+ *   Rodrigo Moya <rodrigo@gnome-db.org>
+ *   Pierre Wieser <pwieser@trychlos.org>
+ *   ... and many others (see AUTHORS)
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include "fma-folder-trie.h"
+
+/* a node of the trie
+ * the path of a node is made of the components which lead to it, each
+ * being followed by a slash
+ */
+typedef struct {
+	GHashTable *children;				/* component -> TrieNode */
+	GSList     *leaves;					/* TrieLeaf */
+}
+	TrieNode;
+
+/* a pattern, attached to the node which holds its leading components
+ * rest is the part of the pattern which follows the path of the node
+ * spec is only set if this rest embeds a wildcard
+ */
+typedef struct {
+	gchar        *rest;
+	GPatternSpec *spec;
+	guint         id;
+}
+	TrieLeaf;
+
+struct _FMAFolderTrie {
+	TrieNode *root;
+};
+
+static TrieNode *node_new( void );
+static void      node_free( TrieNode *node );
+static TrieNode *node_child( TrieNode *node, const gchar *component, gssize length, gboolean create );
+static void      leaf_free( TrieLeaf *leaf );
+static gboolean  leaf_match( const TrieLeaf *leaf, const gchar *rest );
+
+/*
+ * fma_folder_trie_new:
+ *
+ * Returns: a newly allocated, empty, #FMAFolderTrie, which should be
+ * fma_folder_trie_free() by the caller.
+ */
+FMAFolderTrie *
+fma_folder_trie_new( void )
+{
+	FMAFolderTrie *trie;
+
+	trie = g_new0( FMAFolderTrie, 1 );
+	trie->root = node_new();
+
+	return( trie );
+}
+
+/*
+ * fma_folder_trie_free:
+ * @trie: this #FMAFolderTrie.
+ *
+ * Releases the @trie.
+ */
+void
+fma_folder_trie_free( FMAFolderTrie *trie )
+{
+	if( trie ){
+		node_free( trie->root );
+		g_free( trie );
+	}
+}
+
+/*
+ * fma_folder_trie_add:
+ * @trie: this #FMAFolderTrie.
+ * @pattern: a Folders pattern, as an UTF-8 string.
+ * @id: the identifier of the @pattern, which will be passed back by
+ *  fma_folder_trie_match().
+ *
+ * The pattern is attached to the node of its components which precede
+ * the first wildcard, if any.
+ */
+void
+fma_folder_trie_add( FMAFolderTrie *trie, const gchar *pattern, guint id )
+{
+	TrieNode *node;
+	TrieLeaf *leaf;
+	gsize literal;
+	const gchar *begin, *slash, *cut;
+
+	g_return_if_fail( trie );
+	g_return_if_fail( pattern );
+
+	/* as the Folders conditions have always been, only the '*' is a
+	 * wildcard, a '?' being a literal character
+	 */
+	literal = strcspn( pattern, "*" );
+	cut = g_strrstr_len( pattern, literal, "/" );
+
+	node = trie->root;
+	begin = pattern;
+
+	if( cut ){
+		while( begin <= cut ){
+			slash = strchr( begin, '/' );
+			node = node_child( node, begin, slash-begin, TRUE );
+			begin = slash+1;
+		}
+	}
+
+	leaf = g_new0( TrieLeaf, 1 );
+	leaf->rest = g_strdup( begin );
+	leaf->spec = pattern[literal] ? g_pattern_spec_new( leaf->rest ) : NULL;
+	leaf->id = id;
+
+	node->leaves = g_slist_prepend( node->leaves, leaf );
+}
+
+/*
+ * fma_folder_trie_match:
+ * @trie: this #FMAFolderTrie.
+ * @path: the path of a directory, as an UTF-8 string.
+ * @func: the function to be called with the identifier of each
+ *  pattern which matches the @path.
+ * @user_data: data to be passed to @func.
+ */
+void
+fma_folder_trie_match( const FMAFolderTrie *trie, const gchar *path, FMAFolderTrieFunc func, void *user_data )
+{
+	TrieNode *node;
+	const gchar *rest, *slash;
+	GSList *it;
+
+	g_return_if_fail( trie );
+	g_return_if_fail( path );
+
+	node = trie->root;
+	rest = path;
+
+	while( node ){
+		for( it = node->leaves ; it ; it = it->next ){
+			if( leaf_match(( const TrieLeaf * ) it->data, rest )){
+				( *func )((( const TrieLeaf * ) it->data )->id, user_data );
+			}
+		}
+
+		slash = strchr( rest, '/' );
+		if( !slash ){
+			break;
+		}
+
+		node = node_child( node, rest, slash-rest, FALSE );
+		rest = slash+1;
+	}
+}
+
+static TrieNode *
+node_new( void )
+{
+	return( g_new0( TrieNode, 1 ));
+}
+
+static void
+node_free( TrieNode *node )
+{
+	if( node->children ){
+		g_hash_table_destroy( node->children );
+	}
+	g_slist_free_full( node->leaves, ( GDestroyNotify ) leaf_free );
+	g_free( node );
+}
+
+/*
+ * returns the child of the @node for the @component of @length bytes,
+ * or NULL if it does not exist and should not be created
+ */
+static TrieNode *
+node_child( TrieNode *node, const gchar *component, gssize length, gboolean create )
+{
+	TrieNode *child;
+	gchar *key;
+
+	key = g_strndup( component, length );
+	child = node->children ? ( TrieNode * ) g_hash_table_lookup( node->children, key ) : NULL;
+
+	if( !child && create ){
+		if( !node->children ){
+			node->children = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, ( GDestroyNotify ) node_free );
+		}
+		child = node_new();
+		g_hash_table_insert( node->children, key, child );
+		key = NULL;
+	}
+
+	g_free( key );
+
+	return( child );
+}
+
+static void
+leaf_free( TrieLeaf *leaf )
+{
+	if( leaf->spec ){
+		g_pattern_spec_free( leaf->spec );
+	}
+	g_free( leaf->rest );
+	g_free( leaf );
+}
+
+/*
+ * as the path of the node is literal, matching the rest of the path
+ * against the rest of the pattern is the same than matching the whole
+ * path against the whole pattern
+ */
+static gboolean
+leaf_match( const TrieLeaf *leaf, const gchar *rest )
+{
+	return(( leaf->spec && g_pattern_match_string( leaf->spec, rest )) ||
+			g_str_has_prefix( rest, leaf->rest ));
+}
@@ -0,0 +1,65 @@
+/*
+ * FileManager-Actions
+ * A file-manager extension which offers configurable context menu actions.
+ *
+ * Copyright (C) 2005 The GNOME Foundation
+ * Copyright (C) 2006-2008 Frederic Ruaudel and others (see AUTHORS)
+ * Copyright (C) 2009-2015 Pierre Wieser and others (see AUTHORS)
+ *
+ * FileManager-Actions is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * FileManager-Actions is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FileManager-Actions; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Frederic Ruaudel <grumz@grumz.net>
+ *   Rodrigo Moya <rodrigo@gnome-db.org>
+ *   Pierre Wieser <pwieser@trychlos.org>
+ *   ... and many others (see AUTHORS)
+ */
+
+#ifndef __CORE_FMA_FOLDER_TRIE_H__
+#define __CORE_FMA_FOLDER_TRIE_H__
+
+/* @title: FMAFolderTrie
+ * @short_description: A path-component trie of Folders patterns
+ * @include: core/fma-folder-trie.h
+ *
+ * A Folders condition is satisfied by a directory either when the
+ * pattern is a prefix of the directory path, or, if the pattern embeds
+ * a '*' wildcard, when the whole path matches the pattern. A '?' is not
+ * a wildcard, but a literal character.
+ *
+ * The trie is indexed on the literal leading components of the
+ * patterns: walking it once along the components of a path gives all
+ * the patterns which may match, and only the last component of the
+ * literal patterns, or the wildcarded remainder of the others, has to
+ * be actually checked.
+ */
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _FMAFolderTrie FMAFolderTrie;
+
+typedef void ( *FMAFolderTrieFunc )( guint id, void *user_data );
+
+FMAFolderTrie *fma_folder_trie_new  ( void );
+void           fma_folder_trie_free ( FMAFolderTrie *trie );
+
+void           fma_folder_trie_add  ( FMAFolderTrie *trie, const gchar *pattern, guint id );
+void           fma_folder_trie_match( const FMAFolderTrie *trie, const gchar *path, FMAFolderTrieFunc func, void *user_data );
+
+G_END_DECLS
+
+#endif /* __CORE_FMA_FOLDER_TRIE_H__ */
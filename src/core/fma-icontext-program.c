@@ -0,0 +1,2633 @@
+/*
+ * FileManager-Actions
+ * A file-manager extension which offers configurable context menu actions.
+ *
+ * Copyright (C) 2005 The GNOME Foundation
+ * Copyright (C) 2006-2008 Frederic Ruaudel and others (see AUTHORS)
+ * Copyright (C) 2009-2015 Pierre Wieser and others (see AUTHORS)
+ *
+ * FileManager-Actions is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * FileManager-Actions is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FileManager-Actions; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Frederic Ruaudel <grumz@grumz.net>
+ *   Rodrigo Moya <rodrigo@gnome-db.org>
+ *   Pierre Wieser <pwieser@trychlos.org>
+ *   ... and many others (see AUTHORS)
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <api/fma-core-utils.h>
+#include <api/fma-object-api.h>
+
+#include "fma-content-type.h"
+#include "fma-dbus-names.h"
+#include "fma-desktop-environment.h"
+#include "fma-icontext-program.h"
+#include "fma-proc-snapshot.h"
+#include "fma-selection-classes.h"
+#include "fma-settings.h"
+
+/* the key of the program attached to the FMAIContext object
+ */
+#define FMA_ICONTEXT_DATA_PROGRAM		"fma-icontext-data-program"
+
+/* the kind of a mimetype condition
+ */
+enum {
+	MIMETYPE_ALL = 1,					/* '*', '* / *', 'all/all', ... */
+	MIMETYPE_FILES,						/* 'allfiles' and variants */
+	MIMETYPE_OTHER
+};
+
+/* the status of a TryExec check
+ */
+enum {
+	TRY_EXEC_UNKNOWN = 0,
+	TRY_EXEC_OK,
+	TRY_EXEC_KO
+};
+
+/* a compiled mimetype condition
+ */
+typedef struct {
+	gchar       *mimetype;				/* without the negation */
+	const gchar *content_type;			/* interned */
+	guint        kind;
+	gboolean     positive;
+}
+	MimetypeCond;
+
+/* a compiled basename, scheme or folder condition
+ */
+typedef struct {
+	gchar        *pattern;				/* UTF-8, without the negation */
+	GPatternSpec *spec;					/* NULL if the pattern cannot be converted */
+	gboolean      has_wildcard;
+	gboolean      positive;
+}
+	PatternCond;
+
+/* the static part of the program, which may be shared between a source
+ * object and the objects derived from it
+ */
+typedef struct {
+	gint          ref_count;
+
+	gboolean      is_action;
+	gboolean      target_location;
+	gboolean      target_toolbar;
+	gboolean      target_selection;
+
+	gboolean      show_in;				/* whether OnlyShowIn/NotShowIn accept the current desktop */
+
+	gboolean      all_mimetypes;
+	MimetypeCond *mimetypes;
+	guint         n_mimetypes;
+
+	PatternCond  *basenames;			/* NULL if '*' */
+	guint         n_basenames;
+	gboolean      matchcase;
+	GHashTable   *extensions;			/* pure-extension basenames, e.g. '*.jpg' */
+
+	gchar         count_op;				/* '\0' if not set */
+	gint          count_limit;
+
+	PatternCond  *schemes;				/* NULL if '*' */
+	guint         n_schemes;
+
+	PatternCond  *folders;				/* NULL if '/' */
+	guint         n_folders;
+
+	guint         caps_required;
+	guint         caps_forbidden;
+	gboolean      caps_never;			/* an unknown positive capability */
+}
+	ProgramConditions;
+
+/* the bits of the extensions hash values
+ */
+enum {
+	EXTENSION_POSITIVE = 1 << 0,
+	EXTENSION_NEGATIVE = 1 << 1
+};
+
+/* the TryExec condition
+ * when the path does not embed any parameter, the result of the check is
+ * kept until the file is modified; the check may so be shared between a
+ * source object and the objects derived from it
+ */
+typedef struct {
+	gint          ref_count;
+	gchar        *path;
+	gboolean      cacheable;
+	guint         status;
+	GFileMonitor *monitor;
+	gulong        handler;
+}
+	TryExecCheck;
+
+/* the program attached to an object
+ */
+typedef struct {
+	ProgramConditions *conditions;
+	gboolean           never;			/* cannot be candidate in this session */
+	TryExecCheck      *try_exec;		/* NULL if not set */
+	gchar             *show_if_registered;
+	gchar             *show_if_true;
+	gchar             *show_if_running;	/* basename of the searched process */
+}
+	FMAIContextProgram;
+
+/* the expensive conditions (ShowIfTrue, ShowIfRunning) are evaluated in
+ * a dedicated pool of EXPENSIVE_THREADS workers, so that slow commands
+ * never hold the threads shared with the file manager; their last
+ * result is kept, so that a condition which has not finished in time
+ * may still be answered at the next request
+ */
+enum {
+	EXPENSIVE_SHOW_IF_TRUE = 1,
+	EXPENSIVE_SHOW_IF_RUNNING
+};
+
+#define EXPENSIVE_MAX					256
+#define EXPENSIVE_THREADS				4
+#define EXPENSIVE_OUTPUT_MAX			64
+#define EXPENSIVE_TIMEOUT				( 5 * G_TIME_SPAN_SECOND )
+
+typedef struct {
+	gchar   *key;
+	guint    kind;
+	gchar   *arg;						/* the command or the process name */
+	gboolean running;					/* a worker is evaluating it */
+	guint    waiters;					/* count of threads waiting for it */
+	gboolean available;					/* whether result is set */
+	gboolean result;
+	gint64   stamp;						/* monotonic time of the result */
+}
+	ExpensiveCond;
+
+/* the data of an asynchronous evaluation, once the cheap conditions
+ * have been checked
+ */
+typedef struct {
+	gchar *show_if_true;
+	gchar *show_if_running;
+}
+	AsyncData;
+
+/* the conditions of the candidate chain, after the target and the
+ * desktop environment ones; each of them keeps its cumulative cost and
+ * the count of objects it has rejected, so that the selective and cheap
+ * ones can be checked first
+ *
+ * ShowIfTrue and ShowIfRunning are always checked last, but their
+ * statistics are kept too
+ *
+ * only one run in STEP_SAMPLE_PERIOD is timed and recorded, the other
+ * ones only read the current order, which is packed in a single integer
+ * (four bits per step) so that it can be read without locking
+ */
+enum {
+	STEP_SELECTION_COUNT = 0,
+	STEP_SCHEMES,
+	STEP_FOLDERS,
+	STEP_CAPABILITIES,
+	STEP_MIMETYPES,
+	STEP_BASENAMES,
+	STEP_TRY_EXEC,
+	STEP_SHOW_IF_REGISTERED,
+	STEP_SHOW_IF_TRUE,
+	STEP_SHOW_IF_RUNNING,
+	STEP_N
+};
+
+#define STEP_N_ORDERED					STEP_SHOW_IF_TRUE
+#define STEP_BIT( step )				( 1 << ( step ))
+#define STEPS_CHEAP						( STEP_BIT( STEP_N_ORDERED ) - 1 )
+
+/* the steps which only depend on the compiled conditions and on the
+ * selection, and which may so be checked from any thread
+ */
+#define STEPS_PURE						( STEP_BIT( STEP_SELECTION_COUNT ) | \
+										  STEP_BIT( STEP_SCHEMES ) | \
+										  STEP_BIT( STEP_FOLDERS ) | \
+										  STEP_BIT( STEP_CAPABILITIES ) | \
+										  STEP_BIT( STEP_MIMETYPES ) | \
+										  STEP_BIT( STEP_BASENAMES ))
+#define STEP_SAMPLE_PERIOD				16
+#define STEP_REORDER_PERIOD				32
+#define STEPS_ORDER_INITIAL				0x76543210
+
+typedef struct {
+	const gchar *name;
+	gboolean     side_effects;			/* keeps its order relative to the other ones */
+	guint64      calls;
+	guint64      rejects;
+	gint64       cost;					/* cumulative, in microseconds */
+}
+	StepStats;
+
+static StepStats st_steps[STEP_N] = {
+	{ "SelectionCount",   FALSE },
+	{ "Schemes",          FALSE },
+	{ "Folders",          FALSE },
+	{ "Capabilities",     FALSE },
+	{ "MimeTypes",        FALSE },
+	{ "Basenames",        FALSE },
+	{ "TryExec",          TRUE  },
+	{ "ShowIfRegistered", FALSE },
+	{ "ShowIfTrue",       TRUE  },
+	{ "ShowIfRunning",    TRUE  }
+};
+
+static GMutex      st_steps_mutex;
+static guint       st_steps_order       = STEPS_ORDER_INITIAL;
+static guint       st_steps_runs        = 0;
+static gint        st_steps_sample      = 0;
+
+/* the checks of the objects against one selection, see
+ * fma_icontext_program_scope_new()
+ */
+struct _FMAIContextProgramScope {
+	guint                target;
+	FMASelection        *selection;		/* reffed */
+	FMASelectionClasses *classes;		/* may be NULL */
+	GHashTable          *pure;			/* ProgramConditions -> PURE_xxx, NULL until evaluated */
+};
+
+/* the results of the pure steps, as evaluated in parallel for the
+ * current menu; they are keyed by the compiled conditions, which are
+ * shared between an object and the objects derived from it
+ */
+enum {
+	PURE_UNKNOWN = 0,
+	PURE_REJECTED,
+	PURE_ACCEPTED
+};
+
+#define PURE_MIN_SLICE					16
+
+/* the index of the i-th file to be checked, as returned by
+ * selection_files()
+ */
+#define FILE_AT( files, i )				(( files ) ? ( files )[i] : ( i ))
+
+typedef struct {
+	guint  pending;						/* count of slices not yet evaluated */
+	GMutex mutex;
+	GCond  cond;
+}
+	PureBatch;
+
+typedef struct {
+	PureBatch           *batch;
+	FMAIContextProgram **programs;
+	guint8              *results;
+	guint                start;
+	guint                end;
+	const FMAIContextProgramScope *scope;
+}
+	PureSlice;
+
+static GThreadPool *st_pure_pool       = NULL;
+
+static GMutex       st_expensive_mutex;
+static GCond        st_expensive_cond;
+static GHashTable  *st_expensive             = NULL;
+static GThreadPool *st_expensive_pool        = NULL;
+static gint64       st_deadline              = 0;
+static gboolean     st_fallback              = FALSE;
+static gint64       st_show_if_true_ttl      = 0;
+static gint64       st_show_if_true_timeout  = EXPENSIVE_TIMEOUT;
+
+static gboolean            program_run_cheap( FMAIContextProgram *program, const FMAIContextProgramScope *scope );
+static gboolean            program_run_steps( FMAIContextProgram *program, const FMAIContextProgramScope *scope, guint mask, gboolean prefix );
+static gboolean            program_run_step( FMAIContextProgram *program, guint step, const FMAIContextProgramScope *scope );
+static gboolean            program_run_timed( FMAIContextProgram *program, guint step, const FMAIContextProgramScope *scope );
+static gboolean            steps_is_sampled( void );
+static void                steps_get_order( guint *order );
+static void                steps_record( const guint *steps, const gint64 *costs, guint count, gboolean ok );
+static void                steps_reorder( void );
+static gdouble             steps_rank( const StepStats *stats );
+static void                steps_dump( void );
+static FMAIContextProgram *program_get( const FMAIContext *context, gboolean *temporary );
+static FMAIContextProgram *program_new( const FMAIContext *context, const FMAIContextProgram *source, gboolean attached );
+static void                program_free( FMAIContextProgram *program );
+static ProgramConditions  *conditions_new( const FMAIContext *context );
+static ProgramConditions  *conditions_ref( ProgramConditions *conditions );
+static void                conditions_unref( ProgramConditions *conditions );
+static gboolean            compile_show_in( const FMAIContext *context );
+static TryExecCheck       *try_exec_new( gchar *path, gboolean attached );
+static TryExecCheck       *try_exec_ref( TryExecCheck *check );
+static void                try_exec_unref( TryExecCheck *check );
+static gboolean            try_exec_evaluate( const gchar *path );
+static void                on_try_exec_changed( GFileMonitor *monitor, GFile *file, GFile *other, GFileMonitorEvent event, TryExecCheck *check );
+static MimetypeCond       *compile_mimetypes( GSList *list, guint *count );
+static PatternCond        *compile_patterns( GSList *list, const gchar *all, gboolean lowercase, guint *count );
+static void                free_patterns( PatternCond *patterns, guint count );
+static void                compile_extensions( ProgramConditions *conditions );
+static const gchar        *pattern_extension( const gchar *pattern );
+static void                compile_capabilities( ProgramConditions *conditions, GSList *list );
+static guint               compile_mimetype_kind( const gchar *mimetype );
+static gchar              *compile_string( gchar *str );
+static gboolean            is_positive_assertion( const gchar *assertion );
+
+static const guint        *selection_files( const FMAIContextProgramScope *scope, guint kind, guint *count );
+static gboolean            run_target( const ProgramConditions *conditions, guint target );
+static gboolean            run_show_in( const ProgramConditions *conditions );
+static gboolean            run_selection_count( const ProgramConditions *conditions, const FMAIContextProgramScope *scope );
+static gboolean            run_schemes( const ProgramConditions *conditions, const FMAIContextProgramScope *scope );
+static gboolean            run_folders( const ProgramConditions *conditions, const FMAIContextProgramScope *scope );
+static gboolean            run_capabilities( const ProgramConditions *conditions, const FMAIContextProgramScope *scope );
+static gboolean            run_mimetypes( const ProgramConditions *conditions, const FMAIContextProgramScope *scope );
+static gboolean            is_mimetype_of( const MimetypeCond *cond, const gchar *file_mimetype, gboolean is_regular );
+static gboolean            run_basenames( const ProgramConditions *conditions, const FMAIContextProgramScope *scope );
+static gboolean            run_try_exec( FMAIContextProgram *program );
+static gboolean            run_show_if_registered( const FMAIContextProgram *program );
+static gboolean            run_show_if_true( const FMAIContextProgram *program );
+static gboolean            run_show_if_running( const FMAIContextProgram *program );
+static gboolean            expensive_get( guint kind, const gchar *arg, gint64 deadline, gboolean fallback );
+static ExpensiveCond      *expensive_lookup( guint kind, const gchar *arg );
+static void                expensive_start( ExpensiveCond *cond );
+static void                expensive_thread( ExpensiveCond *cond, gpointer user_data );
+static void                expensive_purge( void );
+static void                expensive_free( ExpensiveCond *cond );
+static gboolean            expensive_show_if_true( const gchar *command, gint64 timeout );
+static gboolean            expensive_show_if_running( const gchar *name );
+static void                pure_prefetch( const FMAIContextProgramScope *scope, FMAIContextProgram **programs, guint count );
+static void                pure_thread( PureSlice *slice, gpointer user_data );
+static void                async_thread( GTask *task, gpointer source_object, AsyncData *data, GCancellable *cancellable );
+static void                async_data_free( AsyncData *data );
+
+/*
+ * fma_icontext_program_attach:
+ * @context: the #FMAIContext object.
+ *
+ * Compiles the conditions of the @context, and attaches the program to
+ * the object, replacing a possible previous one.
+ */
+void
+fma_icontext_program_attach( FMAIContext *context )
+{
+	FMAIContextProgram *program;
+
+	g_return_if_fail( FMA_IS_ICONTEXT( context ));
+
+	program = program_new( context, NULL, TRUE );
+	g_object_set_data_full( G_OBJECT( context ), FMA_ICONTEXT_DATA_PROGRAM, program, ( GDestroyNotify ) program_free );
+}
+
+/*
+ * fma_icontext_program_attach_tree:
+ * @tree: a list of #FMAObjectItem items, as loaded by the #FMAPivot.
+ *
+ * Compiles the conditions of all the items of the @tree, recursively
+ * descending into menus, and into the profiles of the actions.
+ */
+void
+fma_icontext_program_attach_tree( GList *tree )
+{
+	GList *it, *ip;
+
+	for( it = tree ; it ; it = it->next ){
+		fma_icontext_program_attach( FMA_ICONTEXT( it->data ));
+
+		if( FMA_IS_OBJECT_MENU( it->data )){
+			fma_icontext_program_attach_tree( fma_object_get_items( it->data ));
+
+		} else if( FMA_IS_OBJECT_ACTION( it->data )){
+			for( ip = fma_object_get_items( it->data ) ; ip ; ip = ip->next ){
+				fma_icontext_program_attach( FMA_ICONTEXT( ip->data ));
+			}
+		}
+	}
+}
+
+/*
+ * fma_icontext_program_derive:
+ * @context: the #FMAIContext object, duplicated from @source.
+ * @source: the source #FMAIContext object.
+ *
+ * Attaches to @context a program which shares the compiled conditions
+ * of the @source, but the TryExec, ShowIfRegistered, ShowIfTrue and
+ * ShowIfRunning ones which are read from the @context itself.
+ */
+void
+fma_icontext_program_derive( FMAIContext *context, const FMAIContext *source )
+{
+	FMAIContextProgram *source_program, *program;
+	gboolean temporary;
+
+	g_return_if_fail( FMA_IS_ICONTEXT( context ));
+	g_return_if_fail( FMA_IS_ICONTEXT( source ));
+
+	source_program = program_get( source, &temporary );
+	program = program_new( context, source_program, FALSE );
+	g_object_set_data_full( G_OBJECT( context ), FMA_ICONTEXT_DATA_PROGRAM, program, ( GDestroyNotify ) program_free );
+
+	if( temporary ){
+		program_free( source_program );
+	}
+}
+
+/*
+ * fma_icontext_program_reset:
+ * @context: the #FMAIContext object.
+ *
+ * Drops the program attached to the @context, if any.
+ *
+ * This is called each time a data of the object is modified.
+ */
+void
+fma_icontext_program_reset( FMAIContext *context )
+{
+	g_return_if_fail( FMA_IS_ICONTEXT( context ));
+
+	if( g_object_get_data( G_OBJECT( context ), FMA_ICONTEXT_DATA_PROGRAM )){
+		g_object_set_data( G_OBJECT( context ), FMA_ICONTEXT_DATA_PROGRAM, NULL );
+	}
+}
+
+/*
+ * fma_icontext_program_is_candidate:
+ * @context: the #FMAIContext object.
+ * @scope: the current #FMAIContextProgramScope.
+ *
+ * Runs the program attached to the @context, compiling a temporary one
+ * if the object does not have one yet.
+ *
+ * All conditions are ANDed; the external commands are only run when
+ * everything else matches. The other conditions are checked in the order
+ * which has been the cheapest until now, i.e. the one which puts first
+ * the conditions which reject the most objects for the least cost.
+ *
+ * ShowIfTrue and ShowIfRunning conditions are evaluated in worker
+ * threads, and only waited for until the deadline set by
+ * fma_icontext_program_set_deadline().
+ *
+ * Returns: %TRUE if the @context satisfies all its conditions, %FALSE else.
+ */
+gboolean
+fma_icontext_program_is_candidate( const FMAIContext *context, const FMAIContextProgramScope *scope )
+{
+	FMAIContextProgram *program;
+	gboolean temporary;
+	gboolean ok;
+
+	g_return_val_if_fail( FMA_IS_ICONTEXT( context ), FALSE );
+	g_return_val_if_fail( scope, FALSE );
+
+	program = program_get( context, &temporary );
+
+	ok =
+		program_run_cheap( program, scope ) &&
+		program_run_timed( program, STEP_SHOW_IF_TRUE, scope ) &&
+		program_run_timed( program, STEP_SHOW_IF_RUNNING, scope );
+
+	if( temporary ){
+		program_free( program );
+	}
+
+	return( ok );
+}
+
+/*
+ * fma_icontext_program_is_candidate_async:
+ * @context: the #FMAIContext object.
+ * @scope: the current #FMAIContextProgramScope.
+ * @task: the #GTask to be returned.
+ *
+ * Checks the cheap conditions of the @context synchronously, then waits
+ * for the ShowIfTrue and ShowIfRunning ones in a worker thread, without
+ * any deadline.
+ *
+ * The boolean result is returned through the @task.
+ */
+void
+fma_icontext_program_is_candidate_async( const FMAIContext *context, const FMAIContextProgramScope *scope, GTask *task )
+{
+	FMAIContextProgram *program;
+	AsyncData *data;
+	gboolean temporary;
+
+	g_return_if_fail( FMA_IS_ICONTEXT( context ));
+	g_return_if_fail( scope );
+	g_return_if_fail( G_IS_TASK( task ));
+
+	program = program_get( context, &temporary );
+
+	if( !program_run_cheap( program, scope )){
+		g_task_return_boolean( task, FALSE );
+
+	} else if( !program->show_if_true && !program->show_if_running ){
+		g_task_return_boolean( task, TRUE );
+
+	} else {
+		data = g_new0( AsyncData, 1 );
+		data->show_if_true = g_strdup( program->show_if_true );
+		data->show_if_running = g_strdup( program->show_if_running );
+		g_task_set_task_data( task, data, ( GDestroyNotify ) async_data_free );
+		g_task_run_in_thread( task, ( GTaskThreadFunc ) async_thread );
+	}
+
+	if( temporary ){
+		program_free( program );
+	}
+}
+
+/*
+ * fma_icontext_program_scope_new:
+ * @target: the current target.
+ * @selection: the current #FMASelection.
+ * @classes: (allow-none): the equivalence classes of the @selection, or
+ *  %NULL.
+ *
+ * A scope gathers what the checks of a set of objects against the same
+ * selection share: when @classes are provided, the per-file conditions
+ * are only checked against the representatives of the classes; the
+ * results of fma_icontext_program_evaluate_pure() are kept here.
+ *
+ * The @classes, if any, are expected to live at least as long as the
+ * scope.
+ *
+ * Returns: a new #FMAIContextProgramScope, which should be
+ * fma_icontext_program_scope_free() by the caller.
+ */
+FMAIContextProgramScope *
+fma_icontext_program_scope_new( guint target, FMASelection *selection, FMASelectionClasses *classes )
+{
+	FMAIContextProgramScope *scope;
+
+	g_return_val_if_fail( selection, NULL );
+	g_return_val_if_fail( !classes || fma_selection_classes_is_for( classes, selection ), NULL );
+
+	scope = g_new0( FMAIContextProgramScope, 1 );
+	scope->target = target;
+	scope->selection = fma_selection_ref( selection );
+	scope->classes = classes;
+
+	return( scope );
+}
+
+/*
+ * fma_icontext_program_scope_free:
+ * @scope: (allow-none): a #FMAIContextProgramScope.
+ *
+ * Releases the @scope.
+ */
+void
+fma_icontext_program_scope_free( FMAIContextProgramScope *scope )
+{
+	if( scope ){
+		if( scope->pure ){
+			g_hash_table_destroy( scope->pure );
+		}
+		fma_selection_unref( scope->selection );
+		g_free( scope );
+	}
+}
+
+/*
+ * fma_icontext_program_evaluate_pure:
+ * @scope: the current #FMAIContextProgramScope.
+ * @contexts: a #GPtrArray of #FMAIContext objects, in the tree order.
+ * @threads: the count of worker threads.
+ *
+ * Evaluates the conditions of the @contexts which only depend on the
+ * selection (target, mimetypes, basenames, schemes, folders, selection
+ * count and capabilities) in a pool of worker threads, each of them
+ * taking a slice of the @contexts.
+ *
+ * The attributes of the files these conditions depend on are queried
+ * beforehand, from the calling thread, so that the worker threads never
+ * have to wait for the file system.
+ *
+ * The results are merged back into the @scope, in the order of the
+ * @contexts, once all the slices have been evaluated. The next checks of
+ * these objects, or of objects derived from them, in this @scope, only
+ * have to evaluate the remaining conditions.
+ *
+ * Only the objects which have an attached program are evaluated.
+ *
+ * This is expected to be called from the main thread, around the
+ * building of a menu.
+ */
+void
+fma_icontext_program_evaluate_pure( FMAIContextProgramScope *scope, GPtrArray *contexts, guint threads )
+{
+	static const gchar *thisfn = "fma_icontext_program_evaluate_pure";
+	FMAIContextProgram **programs;
+	guint8 *results;
+	PureBatch batch;
+	PureSlice *slice;
+	guint i, size, rejected;
+	gint64 elapsed;
+
+	g_return_if_fail( scope );
+	g_return_if_fail( contexts );
+
+	if( scope->pure ){
+		g_hash_table_destroy( scope->pure );
+		scope->pure = NULL;
+	}
+
+	if( !contexts->len || threads < 2 ){
+		return;
+	}
+
+	elapsed = g_get_monotonic_time();
+
+	programs = g_new( FMAIContextProgram *, contexts->len );
+	results = g_new0( guint8, contexts->len );
+
+	for( i = 0 ; i < contexts->len ; ++i ){
+		programs[i] = ( FMAIContextProgram * )
+				g_object_get_data( G_OBJECT( g_ptr_array_index( contexts, i )), FMA_ICONTEXT_DATA_PROGRAM );
+	}
+
+	pure_prefetch( scope, programs, contexts->len );
+
+	if( !st_pure_pool ){
+		st_pure_pool = g_thread_pool_new(( GFunc ) pure_thread, NULL, threads, FALSE, NULL );
+	} else {
+		g_thread_pool_set_max_threads( st_pure_pool, threads, NULL );
+	}
+
+	/* a few slices per thread, so that they end up about the same time
+	 */
+	size = MAX( PURE_MIN_SLICE, contexts->len / ( 4 * threads ) + 1 );
+
+	g_mutex_init( &batch.mutex );
+	g_cond_init( &batch.cond );
+	batch.pending = ( contexts->len + size - 1 ) / size;
+
+	for( i = 0 ; i < contexts->len ; i += size ){
+		slice = g_new0( PureSlice, 1 );
+		slice->batch = &batch;
+		slice->programs = programs;
+		slice->results = results;
+		slice->start = i;
+		slice->end = MIN( i + size, contexts->len );
+		slice->scope = scope;
+		g_thread_pool_push( st_pure_pool, slice, NULL );
+	}
+
+	g_mutex_lock( &batch.mutex );
+	while( batch.pending ){
+		g_cond_wait( &batch.cond, &batch.mutex );
+	}
+	g_mutex_unlock( &batch.mutex );
+
+	g_mutex_clear( &batch.mutex );
+	g_cond_clear( &batch.cond );
+
+	scope->pure = g_hash_table_new( g_direct_hash, g_direct_equal );
+	rejected = 0;
+
+	for( i = 0 ; i < contexts->len ; ++i ){
+		if( results[i] != PURE_UNKNOWN && !g_hash_table_contains( scope->pure, programs[i]->conditions )){
+			g_hash_table_insert( scope->pure, programs[i]->conditions, GUINT_TO_POINTER(( guint ) results[i] ));
+			rejected += ( results[i] == PURE_REJECTED ) ? 1 : 0;
+		}
+	}
+
+	g_free( results );
+	g_free( programs );
+
+	g_debug( "%s: contexts=%u, threads=%u, slice=%u, rejected=%u, elapsed=%" G_GINT64_FORMAT "us",
+			thisfn, contexts->len, threads, size, rejected, g_get_monotonic_time() - elapsed );
+}
+
+/*
+ * fma_icontext_program_set_deadline:
+ * @deadline: the monotonic time until which the expensive conditions may
+ *  be waited for, or zero to wait without limit.
+ * @fallback: the result of an expensive condition which has not finished
+ *  in time, and whose result is not known from a previous evaluation.
+ *
+ * Sets the latency budget of the next synchronous evaluations.
+ *
+ * This is expected to be called from the main thread, around the
+ * building of a menu.
+ */
+void
+fma_icontext_program_set_deadline( gint64 deadline, gboolean fallback )
+{
+	st_deadline = deadline;
+	st_fallback = fallback;
+}
+
+/*
+ * fma_icontext_program_set_show_if_true_ttl:
+ * @ttl: the time, in microseconds, during which the result of a
+ *  ShowIfTrue command is reused without running it again.
+ *
+ * ShowIfTrue commands are identified by their command line, after the
+ * parameters have been expanded.
+ */
+void
+fma_icontext_program_set_show_if_true_ttl( gint64 ttl )
+{
+	g_mutex_lock( &st_expensive_mutex );
+	st_show_if_true_ttl = ttl;
+	g_mutex_unlock( &st_expensive_mutex );
+}
+
+/*
+ * fma_icontext_program_set_show_if_true_timeout:
+ * @timeout: the time, in microseconds, after which a ShowIfTrue command
+ *  which has not terminated is killed, or zero to restore the default.
+ *
+ * A killed command is considered as having output 'false'.
+ */
+void
+fma_icontext_program_set_show_if_true_timeout( gint64 timeout )
+{
+	g_mutex_lock( &st_expensive_mutex );
+	st_show_if_true_timeout = timeout ? timeout : EXPENSIVE_TIMEOUT;
+	g_mutex_unlock( &st_expensive_mutex );
+}
+
+/*
+ * fma_icontext_program_get_step_stats:
+ * @count: [out]: the count of steps.
+ *
+ * The statistics are those of the sampled runs, i.e. about one run in
+ * STEP_SAMPLE_PERIOD.
+ *
+ * Returns: the statistics of the steps of the candidate chain, in their
+ * current order, as a newly allocated array which should be g_free() by
+ * the caller.
+ */
+FMAIContextProgramStepStats *
+fma_icontext_program_get_step_stats( guint *count )
+{
+	FMAIContextProgramStepStats *stats;
+	guint order[STEP_N_ORDERED];
+	guint i, step;
+
+	g_return_val_if_fail( count, NULL );
+
+	stats = g_new0( FMAIContextProgramStepStats, STEP_N );
+	steps_get_order( order );
+
+	g_mutex_lock( &st_steps_mutex );
+
+	for( i = 0 ; i < STEP_N ; ++i ){
+		step = i < STEP_N_ORDERED ? order[i] : i;
+		stats[i].name = st_steps[step].name;
+		stats[i].calls = st_steps[step].calls;
+		stats[i].rejects = st_steps[step].rejects;
+		stats[i].cost = st_steps[step].cost;
+	}
+
+	g_mutex_unlock( &st_steps_mutex );
+
+	*count = STEP_N;
+
+	return( stats );
+}
+
+/*
+ * fma_icontext_program_prefetch:
+ * @context: the #FMAIContext object.
+ * @scope: the current #FMAIContextProgramScope.
+ * @tokens: (allow-none): the #FMATokens to expand the ShowIfTrue command
+ *  with, or %NULL if the command is to be run as is.
+ *
+ * If all the cheap conditions of the @context are satisfied, starts
+ * evaluating its ShowIfTrue condition in a worker thread, without
+ * waiting for it.
+ *
+ * This lets the caller have all the commands needed by a menu run
+ * concurrently, before actually checking each candidate in turn.
+ *
+ * Returns: %FALSE if the @context is known not to be candidate, %TRUE
+ * if it may be.
+ */
+gboolean
+fma_icontext_program_prefetch( const FMAIContext *context, const FMAIContextProgramScope *scope, const FMATokens *tokens )
+{
+	FMAIContextProgram *program;
+	gboolean temporary;
+	gboolean ok;
+	gchar *command;
+	ExpensiveCond *cond;
+
+	g_return_val_if_fail( FMA_IS_ICONTEXT( context ), FALSE );
+	g_return_val_if_fail( scope, FALSE );
+
+	program = program_get( context, &temporary );
+	ok = !program->never;
+
+	/* the cheap conditions are only checked when there is something
+	 * to be started
+	 */
+	if( ok && program->show_if_true ){
+		ok = program_run_cheap( program, scope );
+	}
+
+	if( ok && program->show_if_true ){
+		command = tokens
+				? fma_tokens_parse_for_display( tokens, program->show_if_true, FALSE )
+				: g_strdup( program->show_if_true );
+
+		if( command && strlen( command )){
+			g_mutex_lock( &st_expensive_mutex );
+			cond = expensive_lookup( EXPENSIVE_SHOW_IF_TRUE, command );
+			expensive_start( cond );
+			g_mutex_unlock( &st_expensive_mutex );
+		}
+
+		g_free( command );
+	}
+
+	if( temporary ){
+		program_free( program );
+	}
+
+	return( ok );
+}
+
+/*
+ * fma_icontext_program_is_never_candidate:
+ * @context: the #FMAIContext object.
+ *
+ * The conditions which do not depend on the selection are evaluated when
+ * the program is compiled: an object which does not satisfy them cannot
+ * be candidate during this session. This is also the case of an action
+ * whose all profiles cannot be candidate.
+ *
+ * Returns: %TRUE if the @context cannot be candidate, whatever be the
+ * selection, %FALSE else.
+ */
+gboolean
+fma_icontext_program_is_never_candidate( const FMAIContext *context )
+{
+	FMAIContextProgram *program;
+	gboolean temporary;
+	gboolean never;
+	GList *ip;
+
+	g_return_val_if_fail( FMA_IS_ICONTEXT( context ), FALSE );
+
+	program = program_get( context, &temporary );
+	never = program->never;
+
+	if( temporary ){
+		program_free( program );
+	}
+
+	if( !never && FMA_IS_OBJECT_ACTION( context )){
+		never = TRUE;
+		for( ip = fma_object_get_items( context ) ; ip && never ; ip = ip->next ){
+			never = fma_icontext_program_is_never_candidate( FMA_ICONTEXT( ip->data ));
+		}
+	}
+
+	return( never );
+}
+
+/*
+ * fma_icontext_program_foreach_key:
+ * @context: the #FMAIContext object.
+ * @func: the function to be called.
+ * @user_data: data to be passed to @func.
+ *
+ * Calls @func for each key a selected item must have for the @context
+ * to have a chance of being candidate: each file of the selection must
+ * match at least one of the mimetype keys, and one of the scheme keys.
+ *
+ * If no mimetype key is enumerated, then no file may ever match the
+ * mimetypes conditions of the @context; the same for the schemes.
+ */
+void
+fma_icontext_program_foreach_key( const FMAIContext *context, FMAIContextProgramKeyFunc func, void *user_data )
+{
+	FMAIContextProgram *program;
+	const ProgramConditions *conditions;
+	gboolean temporary;
+	guint i;
+
+	g_return_if_fail( FMA_IS_ICONTEXT( context ));
+
+	program = program_get( context, &temporary );
+	conditions = program->conditions;
+
+	if( conditions->all_mimetypes ){
+		( *func )( context, ICONTEXT_KEY_MIMETYPE_ANY, NULL, user_data );
+
+	} else {
+		for( i = 0 ; i < conditions->n_mimetypes ; ++i ){
+			if( conditions->mimetypes[i].positive ){
+				switch( conditions->mimetypes[i].kind ){
+					case MIMETYPE_ALL:
+						( *func )( context, ICONTEXT_KEY_MIMETYPE_ANY, NULL, user_data );
+						break;
+					case MIMETYPE_FILES:
+						( *func )( context, ICONTEXT_KEY_MIMETYPE_FILES, NULL, user_data );
+						break;
+					default:
+						if( conditions->mimetypes[i].content_type ){
+							( *func )( context, ICONTEXT_KEY_MIMETYPE, conditions->mimetypes[i].content_type, user_data );
+						}
+						break;
+				}
+			}
+		}
+	}
+
+	if( !conditions->schemes ){
+		( *func )( context, ICONTEXT_KEY_SCHEME_ANY, NULL, user_data );
+
+	} else {
+		for( i = 0 ; i < conditions->n_schemes ; ++i ){
+			if( conditions->schemes[i].positive && conditions->schemes[i].pattern ){
+				if( !strcmp( conditions->schemes[i].pattern, "*" )){
+					( *func )( context, ICONTEXT_KEY_SCHEME_ANY, NULL, user_data );
+				} else {
+					( *func )( context, ICONTEXT_KEY_SCHEME, conditions->schemes[i].pattern, user_data );
+				}
+			}
+		}
+	}
+
+	for( i = 0 ; i < conditions->n_folders ; ++i ){
+		if( conditions->folders[i].positive ){
+			( *func )( context, ICONTEXT_KEY_FOLDER, conditions->folders[i].pattern, user_data );
+
+		} else if( conditions->folders[i].pattern ){
+			( *func )( context, ICONTEXT_KEY_NOT_FOLDER, conditions->folders[i].pattern, user_data );
+		}
+	}
+
+	if( temporary ){
+		program_free( program );
+	}
+}
+
+/*
+ * all the conditions but ShowIfTrue and ShowIfRunning
+ *
+ * when the pure steps have already been evaluated in parallel, only the
+ * remaining ones are checked here
+ */
+static gboolean
+program_run_cheap( FMAIContextProgram *program, const FMAIContextProgramScope *scope )
+{
+	guint verdict;
+
+	verdict = scope->pure
+			? GPOINTER_TO_UINT( g_hash_table_lookup( scope->pure, program->conditions ))
+			: PURE_UNKNOWN;
+
+	switch( verdict ){
+		case PURE_REJECTED:
+			return( FALSE );
+
+		case PURE_ACCEPTED:
+			return( program_run_steps( program, scope, STEPS_CHEAP & ~STEPS_PURE, FALSE ));
+	}
+
+	return( program_run_steps( program, scope, STEPS_CHEAP, TRUE ));
+}
+
+/*
+ * @mask: the steps to be run.
+ * @prefix: whether the target and the desktop environment have to be
+ *  checked.
+ *
+ * the target and the desktop environment are always checked first, as
+ * they do not cost anything; the other conditions are checked in the
+ * current order of the chain, and timed when the run is sampled
+ */
+static gboolean
+program_run_steps( FMAIContextProgram *program, const FMAIContextProgramScope *scope, guint mask, gboolean prefix )
+{
+	guint order[STEP_N_ORDERED];
+	guint steps[STEP_N_ORDERED];
+	gint64 costs[STEP_N_ORDERED];
+	gint64 start, now;
+	gboolean ok, sampled;
+	guint i, count;
+
+	if( prefix && (
+			program->never ||
+			!run_target( program->conditions, scope->target ) ||
+			!run_show_in( program->conditions ))){
+		return( FALSE );
+	}
+
+	steps_get_order( order );
+	sampled = steps_is_sampled();
+
+	ok = TRUE;
+	count = 0;
+	start = sampled ? g_get_monotonic_time() : 0;
+
+	for( i = 0 ; i < STEP_N_ORDERED && ok ; ++i ){
+		if( mask & STEP_BIT( order[i] )){
+			ok = program_run_step( program, order[i], scope );
+			if( sampled ){
+				now = g_get_monotonic_time();
+				steps[count] = order[i];
+				costs[count] = now - start;
+				count += 1;
+				start = now;
+			}
+		}
+	}
+
+	if( sampled ){
+		steps_record( steps, costs, count, ok );
+	}
+
+	return( ok );
+}
+
+static gboolean
+program_run_step( FMAIContextProgram *program, guint step, const FMAIContextProgramScope *scope )
+{
+	gboolean ok = TRUE;
+
+	switch( step ){
+		case STEP_SELECTION_COUNT:
+			ok = run_selection_count( program->conditions, scope );
+			break;
+		case STEP_SCHEMES:
+			ok = run_schemes( program->conditions, scope );
+			break;
+		case STEP_FOLDERS:
+			ok = run_folders( program->conditions, scope );
+			break;
+		case STEP_CAPABILITIES:
+			ok = run_capabilities( program->conditions, scope );
+			break;
+		case STEP_MIMETYPES:
+			ok = run_mimetypes( program->conditions, scope );
+			break;
+		case STEP_BASENAMES:
+			ok = run_basenames( program->conditions, scope );
+			break;
+		case STEP_TRY_EXEC:
+			ok = run_try_exec( program );
+			break;
+		case STEP_SHOW_IF_REGISTERED:
+			ok = run_show_if_registered( program );
+			break;
+		case STEP_SHOW_IF_TRUE:
+			ok = run_show_if_true( program );
+			break;
+		case STEP_SHOW_IF_RUNNING:
+			ok = run_show_if_running( program );
+			break;
+	}
+
+	return( ok );
+}
+
+/*
+ * runs a single step, and times it when the run is sampled
+ */
+static gboolean
+program_run_timed( FMAIContextProgram *program, guint step, const FMAIContextProgramScope *scope )
+{
+	gint64 cost;
+	gboolean ok;
+
+	if( !steps_is_sampled()){
+		return( program_run_step( program, step, scope ));
+	}
+
+	cost = g_get_monotonic_time();
+	ok = program_run_step( program, step, scope );
+	cost = g_get_monotonic_time() - cost;
+
+	steps_record( &step, &cost, 1, ok );
+
+	return( ok );
+}
+
+static gboolean
+steps_is_sampled( void )
+{
+	return(( g_atomic_int_add( &st_steps_sample, 1 ) & ( STEP_SAMPLE_PERIOD-1 )) == 0 );
+}
+
+static void
+steps_get_order( guint *order )
+{
+	guint packed, i;
+
+	packed = ( guint ) g_atomic_int_get(( gint * ) &st_steps_order );
+
+	for( i = 0 ; i < STEP_N_ORDERED ; ++i ){
+		order[i] = ( packed >> ( 4*i )) & 0xf;
+	}
+}
+
+/*
+ * @steps: the steps which have been run, in this order.
+ * @costs: their respective costs.
+ * @count: the count of run steps.
+ * @ok: whether the last run step has accepted the object.
+ *
+ * the chain is reordered after each STEP_REORDER_PERIOD sampled runs
+ */
+static void
+steps_record( const guint *steps, const gint64 *costs, guint count, gboolean ok )
+{
+	guint i;
+
+	if( !count ){
+		return;
+	}
+
+	g_mutex_lock( &st_steps_mutex );
+
+	for( i = 0 ; i < count ; ++i ){
+		st_steps[steps[i]].calls += 1;
+		st_steps[steps[i]].cost += costs[i];
+	}
+	if( !ok ){
+		st_steps[steps[count-1]].rejects += 1;
+	}
+
+	if( steps[0] < STEP_N_ORDERED && ++st_steps_runs >= STEP_REORDER_PERIOD ){
+		st_steps_runs = 0;
+		steps_reorder();
+		steps_dump();
+	}
+
+	g_mutex_unlock( &st_steps_mutex );
+}
+
+/*
+ * the expected cost of a chain of ANDed conditions is minimal when they
+ * are sorted by decreasing rejection probability per cost unit
+ *
+ * the steps with side effects are then put back in their original
+ * relative order, in the slots they have got
+ *
+ * this is called with the mutex held
+ */
+static void
+steps_reorder( void )
+{
+	guint current[STEP_N_ORDERED];
+	guint order[STEP_N_ORDERED];
+	gdouble ranks[STEP_N];
+	guint i, j, n, step, packed;
+
+	for( i = 0 ; i < STEP_N_ORDERED ; ++i ){
+		ranks[i] = steps_rank( &st_steps[i] );
+	}
+
+	steps_get_order( current );
+
+	for( i = 0 ; i < STEP_N_ORDERED ; ++i ){
+		step = current[i];
+		for( j = i ; j > 0 && ranks[order[j-1]] < ranks[step] ; --j ){
+			order[j] = order[j-1];
+		}
+		order[j] = step;
+	}
+
+	for( i = 0, n = 0 ; i < STEP_N_ORDERED ; ++i ){
+		if( st_steps[order[i]].side_effects ){
+			for( ; !st_steps[n].side_effects ; ++n )
+				;
+			order[i] = n++;
+		}
+	}
+
+	for( i = 0, packed = 0 ; i < STEP_N_ORDERED ; ++i ){
+		packed |= order[i] << ( 4*i );
+	}
+
+	g_atomic_int_set(( gint * ) &st_steps_order, ( gint ) packed );
+}
+
+/*
+ * the rejection rate divided by the mean cost, i.e. the count of rejects
+ * divided by the cumulative cost; both are offset by one so that a step
+ * which has not been measured yet still has a chance to be tried first
+ */
+static gdouble
+steps_rank( const StepStats *stats )
+{
+	return(( gdouble )( stats->rejects + 1 ) / ( gdouble )( stats->cost + 1 ));
+}
+
+/*
+ * this is called with the mutex held
+ */
+static void
+steps_dump( void )
+{
+	static const gchar *thisfn = "fma_icontext_program_steps_dump";
+	guint order[STEP_N_ORDERED];
+	guint i, step;
+
+	steps_get_order( order );
+
+	for( i = 0 ; i < STEP_N ; ++i ){
+		step = i < STEP_N_ORDERED ? order[i] : i;
+		g_debug( "%s: %-16s calls=%" G_GUINT64_FORMAT ", rejects=%" G_GUINT64_FORMAT ", cost=%" G_GINT64_FORMAT "us",
+				thisfn, st_steps[step].name, st_steps[step].calls, st_steps[step].rejects, st_steps[step].cost );
+	}
+}
+
+static FMAIContextProgram *
+program_get( const FMAIContext *context, gboolean *temporary )
+{
+	FMAIContextProgram *program;
+
+	program = ( FMAIContextProgram * ) g_object_get_data( G_OBJECT( context ), FMA_ICONTEXT_DATA_PROGRAM );
+	*temporary = ( program == NULL );
+
+	if( !program ){
+		program = program_new( context, NULL, FALSE );
+	}
+
+	return( program );
+}
+
+/*
+ * if @source is set, then the new program shares its compiled conditions,
+ * and its TryExec check if the path is the same
+ *
+ * the selection-independent conditions are evaluated here, and TryExec
+ * is monitored, only for programs which are attached to their object
+ */
+static FMAIContextProgram *
+program_new( const FMAIContext *context, const FMAIContextProgram *source, gboolean attached )
+{
+	static const gchar *thisfn = "fma_icontext_program_new";
+	FMAIContextProgram *program;
+	gchar *try_exec, *running;
+
+	program = g_new0( FMAIContextProgram, 1 );
+	program->conditions = source ? conditions_ref( source->conditions ) : conditions_new( context );
+
+	try_exec = compile_string( fma_object_get_try_exec( context ));
+	if( try_exec ){
+		if( source && source->try_exec && !strcmp( source->try_exec->path, try_exec )){
+			program->try_exec = try_exec_ref( source->try_exec );
+			g_free( try_exec );
+		} else {
+			program->try_exec = try_exec_new( try_exec, attached );
+		}
+	}
+
+	program->show_if_registered = compile_string( fma_object_get_show_if_registered( context ));
+	if( program->show_if_registered ){
+		fma_dbus_names_init();
+	}
+	program->show_if_true = compile_string( fma_object_get_show_if_true( context ));
+
+	running = compile_string( fma_object_get_show_if_running( context ));
+	if( running ){
+		program->show_if_running = g_path_get_basename( running );
+		g_free( running );
+	}
+
+	program->never = !program->conditions->show_in;
+
+	if( program->never && attached ){
+		g_debug( "%s: context=%p (%s) cannot be candidate in this session",
+				thisfn, ( void * ) context, G_OBJECT_TYPE_NAME( context ));
+	}
+
+	return( program );
+}
+
+static void
+program_free( FMAIContextProgram *program )
+{
+	conditions_unref( program->conditions );
+	if( program->try_exec ){
+		try_exec_unref( program->try_exec );
+	}
+	g_free( program->show_if_registered );
+	g_free( program->show_if_true );
+	g_free( program->show_if_running );
+	g_free( program );
+}
+
+static ProgramConditions *
+conditions_new( const FMAIContext *context )
+{
+	ProgramConditions *conditions;
+	GSList *list;
+	gchar *str;
+
+	conditions = g_new0( ProgramConditions, 1 );
+	conditions->ref_count = 1;
+
+	conditions->is_action = FMA_IS_OBJECT_ACTION( context );
+	if( conditions->is_action ){
+		conditions->target_location = fma_object_is_target_location( context );
+		conditions->target_toolbar = fma_object_is_target_toolbar( context );
+		conditions->target_selection = fma_object_is_target_selection( context );
+	}
+
+	conditions->show_in = compile_show_in( context );
+
+	conditions->all_mimetypes = fma_object_get_all_mimetypes( context );
+	if( !conditions->all_mimetypes ){
+		list = fma_object_get_mimetypes( context );
+		conditions->mimetypes = compile_mimetypes( list, &conditions->n_mimetypes );
+		fma_core_utils_slist_free( list );
+	}
+
+	conditions->matchcase = fma_object_get_matchcase( context );
+	list = fma_object_get_basenames( context );
+	conditions->basenames = compile_patterns( list, "*", !conditions->matchcase, &conditions->n_basenames );
+	compile_extensions( conditions );
+	fma_core_utils_slist_free( list );
+
+	str = compile_string( fma_object_get_selection_count( context ));
+	if( str ){
+		conditions->count_op = str[0];
+		conditions->count_limit = atoi( str+1 );
+		g_free( str );
+	}
+
+	list = fma_object_get_schemes( context );
+	conditions->schemes = compile_patterns( list, "*", FALSE, &conditions->n_schemes );
+	fma_core_utils_slist_free( list );
+
+	list = fma_object_get_folders( context );
+	conditions->folders = compile_patterns( list, "/", FALSE, &conditions->n_folders );
+	fma_core_utils_slist_free( list );
+
+	list = fma_object_get_capabilities( context );
+	compile_capabilities( conditions, list );
+	fma_core_utils_slist_free( list );
+
+	return( conditions );
+}
+
+static ProgramConditions *
+conditions_ref( ProgramConditions *conditions )
+{
+	conditions->ref_count += 1;
+
+	return( conditions );
+}
+
+static void
+conditions_unref( ProgramConditions *conditions )
+{
+	guint i;
+
+	conditions->ref_count -= 1;
+
+	if( !conditions->ref_count ){
+		for( i = 0 ; i < conditions->n_mimetypes ; ++i ){
+			g_free( conditions->mimetypes[i].mimetype );
+		}
+		g_free( conditions->mimetypes );
+
+		free_patterns( conditions->basenames, conditions->n_basenames );
+		if( conditions->extensions ){
+			g_hash_table_destroy( conditions->extensions );
+		}
+		free_patterns( conditions->schemes, conditions->n_schemes );
+		free_patterns( conditions->folders, conditions->n_folders );
+
+		g_free( conditions );
+	}
+}
+
+/*
+ * only show in / not show in
+ * only one of these two data may be set
+ *
+ * the desktop environment does not change during the session
+ */
+static gboolean
+compile_show_in( const FMAIContext *context )
+{
+	static const gchar *thisfn = "fma_icontext_program_compile_show_in";
+	static gchar *environment = NULL;
+	gboolean ok = TRUE;
+	GSList *only_in = fma_object_get_only_show_in( context );
+	GSList *not_in = fma_object_get_not_show_in( context );
+
+	/* there is a memory leak here when desktop comes from user preferences
+	 * because it is never freed (because it may come from runtime detection)
+	 * but this occurs only once..
+	 */
+	if( !environment && ( only_in || not_in )){
+		environment = fma_settings_get_string( IPREFS_DESKTOP_ENVIRONMENT, NULL, NULL );
+		if( !environment || !strlen( environment )){
+			environment = ( gchar * ) fma_desktop_environment_detect_running_desktop();
+		}
+		g_debug( "%s: found %s desktop", thisfn, environment );
+	}
+
+	if( only_in && g_slist_length( only_in )){
+		ok = ( fma_core_utils_slist_count( only_in, environment ) > 0 );
+	} else if( not_in && g_slist_length( not_in )){
+		ok = ( fma_core_utils_slist_count( not_in, environment ) == 0 );
+	}
+
+	if( !ok ){
+		gchar *only_str = fma_core_utils_slist_to_text( only_in );
+		gchar *not_str = fma_core_utils_slist_to_text( not_in );
+		g_debug( "%s: object is not candidate because OnlyShowIn=%s, NotShowIn=%s", thisfn, only_str, not_str );
+		g_free( not_str );
+		g_free( only_str );
+	}
+
+	fma_core_utils_slist_free( not_in );
+	fma_core_utils_slist_free( only_in );
+
+	return( ok );
+}
+
+/*
+ * takes ownership of @path
+ *
+ * a path which embeds parameters cannot be checked before they are
+ * expanded, and is so checked each time
+ */
+static TryExecCheck *
+try_exec_new( gchar *path, gboolean attached )
+{
+	TryExecCheck *check;
+	GFile *file;
+
+	check = g_new0( TryExecCheck, 1 );
+	check->ref_count = 1;
+	check->path = path;
+	check->cacheable = attached && ( strchr( path, '%' ) == NULL );
+	check->status = TRY_EXEC_UNKNOWN;
+
+	if( check->cacheable ){
+		check->status = try_exec_evaluate( path ) ? TRY_EXEC_OK : TRY_EXEC_KO;
+
+		file = g_file_new_for_path( path );
+		check->monitor = g_file_monitor_file( file, G_FILE_MONITOR_NONE, NULL, NULL );
+		if( check->monitor ){
+			check->handler = g_signal_connect( check->monitor, "changed", G_CALLBACK( on_try_exec_changed ), check );
+		}
+		g_object_unref( file );
+	}
+
+	return( check );
+}
+
+static TryExecCheck *
+try_exec_ref( TryExecCheck *check )
+{
+	check->ref_count += 1;
+
+	return( check );
+}
+
+static void
+try_exec_unref( TryExecCheck *check )
+{
+	check->ref_count -= 1;
+
+	if( !check->ref_count ){
+		if( check->monitor ){
+			g_signal_handler_disconnect( check->monitor, check->handler );
+			g_file_monitor_cancel( check->monitor );
+			g_object_unref( check->monitor );
+		}
+		g_free( check->path );
+		g_free( check );
+	}
+}
+
+/*
+ * if the data is set, it should be the path of an executable file
+ */
+static gboolean
+try_exec_evaluate( const gchar *path )
+{
+	static const gchar *thisfn = "fma_icontext_program_try_exec_evaluate";
+	gboolean ok = FALSE;
+	GError *error = NULL;
+	GFile *file;
+	GFileInfo *info;
+
+	file = g_file_new_for_path( path );
+	info = g_file_query_info( file, G_FILE_ATTRIBUTE_ACCESS_CAN_EXECUTE, G_FILE_QUERY_INFO_NONE, NULL, &error );
+	if( error ){
+		g_debug( "%s: %s", thisfn, error->message );
+		g_error_free( error );
+
+	} else {
+		ok = g_file_info_get_attribute_boolean( info, G_FILE_ATTRIBUTE_ACCESS_CAN_EXECUTE );
+	}
+
+	if( info ){
+		g_object_unref( info );
+	}
+
+	g_object_unref( file );
+
+	return( ok );
+}
+
+/*
+ * the TryExec file has been created, deleted or modified: it will be
+ * checked again on next request
+ */
+static void
+on_try_exec_changed( GFileMonitor *monitor, GFile *file, GFile *other, GFileMonitorEvent event, TryExecCheck *check )
+{
+	static const gchar *thisfn = "fma_icontext_program_on_try_exec_changed";
+
+	g_debug( "%s: path=%s, event=%d", thisfn, check->path, ( gint ) event );
+
+	check->status = TRY_EXEC_UNKNOWN;
+}
+
+static MimetypeCond *
+compile_mimetypes( GSList *list, guint *count )
+{
+	MimetypeCond *mimetypes;
+	const gchar *imtype;
+	GSList *it;
+	guint i;
+
+	*count = g_slist_length( list );
+	mimetypes = g_new0( MimetypeCond, *count );
+
+	for( it = list, i = 0 ; it ; it = it->next, ++i ){
+		imtype = ( const gchar * ) it->data;
+		mimetypes[i].positive = is_positive_assertion( imtype );
+		mimetypes[i].mimetype = g_strdup( mimetypes[i].positive ? imtype : imtype+1 );
+		mimetypes[i].kind = compile_mimetype_kind( mimetypes[i].mimetype );
+		if( mimetypes[i].kind != MIMETYPE_ALL ){
+			mimetypes[i].content_type = fma_content_type_intern( mimetypes[i].mimetype );
+		}
+	}
+
+	return( mimetypes );
+}
+
+/*
+ * returns NULL if the list is empty, or only contains the @all pattern
+ *
+ * when @lowercase is set, the negation is checked on the lowered pattern,
+ * as the conditions on basenames have always done
+ */
+static PatternCond *
+compile_patterns( GSList *list, const gchar *all, gboolean lowercase, guint *count )
+{
+	PatternCond *patterns;
+	gchar *pattern;
+	GSList *it;
+	guint i;
+
+	patterns = NULL;
+	*count = 0;
+
+	if( list && ( strcmp( list->data, all ) != 0 || g_slist_length( list ) > 1 )){
+		*count = g_slist_length( list );
+		patterns = g_new0( PatternCond, *count );
+
+		for( it = list, i = 0 ; it ; it = it->next, ++i ){
+			pattern = lowercase ?
+				g_utf8_strdown(( const gchar * ) it->data, -1 ) :
+				g_strdup(( const gchar * ) it->data );
+			patterns[i].positive = is_positive_assertion( pattern );
+			patterns[i].pattern = g_filename_to_utf8( patterns[i].positive ? pattern : pattern+1, -1, NULL, NULL, NULL );
+			if( patterns[i].pattern ){
+				patterns[i].has_wildcard = ( g_strstr_len( patterns[i].pattern, -1, "*" ) != NULL );
+				patterns[i].spec = g_pattern_spec_new( patterns[i].pattern );
+			}
+			g_free( pattern );
+		}
+	}
+
+	return( patterns );
+}
+
+static void
+free_patterns( PatternCond *patterns, guint count )
+{
+	guint i;
+
+	for( i = 0 ; i < count ; ++i ){
+		if( patterns[i].spec ){
+			g_pattern_spec_free( patterns[i].spec );
+		}
+		g_free( patterns[i].pattern );
+	}
+
+	g_free( patterns );
+}
+
+/*
+ * the basenames patterns which only check the extension of the file
+ * are moved to a hash table, so that they are matched with a single
+ * lookup whatever be their count
+ */
+static void
+compile_extensions( ProgramConditions *conditions )
+{
+	const gchar *extension;
+	guint bits;
+	guint i, n;
+
+	for( i = 0, n = 0 ; i < conditions->n_basenames ; ++i ){
+		extension = pattern_extension( conditions->basenames[i].pattern );
+
+		if( extension ){
+			if( !conditions->extensions ){
+				conditions->extensions = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, NULL );
+			}
+			bits = GPOINTER_TO_UINT( g_hash_table_lookup( conditions->extensions, extension ));
+			bits |= conditions->basenames[i].positive ? EXTENSION_POSITIVE : EXTENSION_NEGATIVE;
+			g_hash_table_insert( conditions->extensions, g_strdup( extension ), GUINT_TO_POINTER( bits ));
+
+			g_pattern_spec_free( conditions->basenames[i].spec );
+			g_free( conditions->basenames[i].pattern );
+
+		} else {
+			conditions->basenames[n++] = conditions->basenames[i];
+		}
+	}
+
+	conditions->n_basenames = n;
+}
+
+/*
+ * '*.ext' matches exactly the basenames whose last dot is followed by
+ * 'ext', provided that 'ext' does not itself contain any dot or wildcard
+ *
+ * returns the extension, or NULL if this is not such a pattern
+ */
+static const gchar *
+pattern_extension( const gchar *pattern )
+{
+	if( !pattern || strncmp( pattern, "*.", 2 ) != 0 ){
+		return( NULL );
+	}
+	if( !pattern[2] || strpbrk( pattern+2, ".*?" )){
+		return( NULL );
+	}
+
+	return( pattern+2 );
+}
+
+/*
+ * an unknown capability never matches: so it makes the object never
+ * candidate when positive, and is just ignored when negative
+ */
+static void
+compile_capabilities( ProgramConditions *conditions, GSList *list )
+{
+	static const gchar *thisfn = "fma_icontext_program_compile_capabilities";
+	const gchar *cap, *name;
+	gboolean positive;
+	guint bit;
+	GSList *it;
+
+	for( it = list ; it ; it = it->next ){
+		cap = ( const gchar * ) it->data;
+		positive = is_positive_assertion( cap );
+		name = positive ? cap : cap+1;
+
+		if( !strcmp( name, "Owner" )){
+			bit = SELECTION_CAP_OWNER;
+		} else if( !strcmp( name, "Readable" )){
+			bit = SELECTION_CAP_READABLE;
+		} else if( !strcmp( name, "Writable" )){
+			bit = SELECTION_CAP_WRITABLE;
+		} else if( !strcmp( name, "Executable" )){
+			bit = SELECTION_CAP_EXECUTABLE;
+		} else if( !strcmp( name, "Local" )){
+			bit = SELECTION_CAP_LOCAL;
+		} else {
+			g_warning( "%s: unknown capability %s", thisfn, cap );
+			bit = 0;
+		}
+
+		if( positive ){
+			conditions->caps_required |= bit;
+			conditions->caps_never |= ( bit == 0 );
+		} else {
+			conditions->caps_forbidden |= bit;
+		}
+	}
+}
+
+static guint
+compile_mimetype_kind( const gchar *mimetype )
+{
+	if( !strcmp( mimetype, "*" ) ||
+		!strcmp( mimetype, "*/*" ) ||
+		!strcmp( mimetype, "*/all" ) ||		/* should be considered as invalid */
+		!strcmp( mimetype, "all" ) ||
+		!strcmp( mimetype, "all/*" ) ||
+		!strcmp( mimetype, "all/all" )){
+			return( MIMETYPE_ALL );
+	}
+
+	if( !strcmp( mimetype, "allfiles" ) ||
+		!strcmp( mimetype, "*/allfiles" ) ||	/* should be considered as invalid */
+		!strcmp( mimetype, "allfiles/*" ) ||
+		!strcmp( mimetype, "allfiles/all" ) ||
+		!strcmp( mimetype, "all/allfiles" )){
+			return( MIMETYPE_FILES );
+	}
+
+	return( MIMETYPE_OTHER );
+}
+
+/*
+ * takes ownership of @str
+ * returns NULL if @str is not set or empty
+ */
+static gchar *
+compile_string( gchar *str )
+{
+	if( str && !strlen( str )){
+		g_free( str );
+		str = NULL;
+	}
+
+	return( str );
+}
+
+/*
+ * "image/ *" is a positive assertion
+ * "!image/jpeg" is a negative one
+ */
+static gboolean
+is_positive_assertion( const gchar *assertion )
+{
+	gboolean positive = TRUE;
+
+	if( assertion ){
+		gchar *dupped = g_strdup( assertion );
+		const gchar *stripped = g_strstrip( dupped );
+		if( stripped ){
+			positive = ( stripped[0] != '!' );
+		}
+		g_free( dupped );
+	}
+
+	return( positive );
+}
+
+/*
+ * returns the indexes of the files a per-file condition of this kind has
+ * to be checked against, or NULL if this is the whole selection
+ *
+ * the SELECTION_CLASS_N kind is used for the conditions which cannot be
+ * checked per class
+ */
+static const guint *
+selection_files( const FMAIContextProgramScope *scope, guint kind, guint *count )
+{
+	if( scope->classes ){
+		return( kind < SELECTION_CLASS_N
+				? fma_selection_classes_get( scope->classes, kind, count )
+				: fma_selection_classes_get_files( scope->classes, count ));
+	}
+
+	*count = fma_selection_get_count( scope->selection );
+
+	return( NULL );
+}
+
+/*
+ * whether the given FMAIContext object is candidate for this target
+ * target is context menu for location, context menu for selection or toolbar for location
+ * only actions are concerned by this check
+ */
+static gboolean
+run_target( const ProgramConditions *conditions, guint target )
+{
+	static const gchar *thisfn = "fma_icontext_program_run_target";
+	gboolean ok = TRUE;
+
+	if( conditions->is_action ){
+		switch( target ){
+			case ITEM_TARGET_LOCATION:
+				ok = conditions->target_location;
+				break;
+
+			case ITEM_TARGET_TOOLBAR:
+				ok = conditions->target_toolbar;
+				break;
+
+			case ITEM_TARGET_SELECTION:
+				ok = conditions->target_selection;
+				break;
+
+			case ITEM_TARGET_ANY:
+				ok = TRUE;
+				break;
+
+			default:
+				g_warning( "%s: unknonw target=%d", thisfn, target );
+				ok = FALSE;
+		}
+	}
+
+	if( !ok ){
+		g_debug( "%s: object is not candidate because target doesn't match (asked=%d)", thisfn, target );
+	}
+
+	return( ok );
+}
+
+/*
+ * only show in / not show in have been evaluated at compile time
+ */
+static gboolean
+run_show_in( const ProgramConditions *conditions )
+{
+	return( conditions->show_in );
+}
+
+static gboolean
+run_selection_count( const ProgramConditions *conditions, const FMAIContextProgramScope *scope )
+{
+	static const gchar *thisfn = "fma_icontext_program_run_selection_count";
+	gboolean ok = TRUE;
+	guint count;
+
+	if( conditions->count_op ){
+		count = fma_selection_get_count( scope->selection );
+		ok = FALSE;
+
+		switch( conditions->count_op ){
+			case '<':
+				ok = ( count < conditions->count_limit );
+				break;
+			case '=':
+				ok = ( count == conditions->count_limit );
+				break;
+			case '>':
+				ok = ( count > conditions->count_limit );
+				break;
+			default:
+				break;
+		}
+
+		if( !ok ){
+			g_debug( "%s: object is not candidate because SelectionCount=%c%d",
+					thisfn, conditions->count_op, conditions->count_limit );
+		}
+	}
+
+	return( ok );
+}
+
+/*
+ * it is likely that all selected items have the same scheme, because they
+ * are all in the same location and the scheme mainly depends on location
+ * so we do not check again a scheme which is the same than the previous
+ * selected item
+ */
+static gboolean
+run_schemes( const ProgramConditions *conditions, const FMAIContextProgramScope *scope )
+{
+	static const gchar *thisfn = "fma_icontext_program_run_schemes";
+	gboolean ok = TRUE;
+	const gchar *scheme, *previous;
+	const PatternCond *cond;
+	gboolean match;
+	const guint *files;
+	guint i, j, count;
+
+	if( conditions->schemes ){
+		previous = NULL;
+		files = selection_files( scope, SELECTION_CLASS_SCHEME, &count );
+
+		for( j = 0 ; j < count && ok ; ++j ){
+			scheme = fma_selection_peek_scheme( scope->selection, FILE_AT( files, j ));
+
+			if( !j || g_strcmp0( previous, scheme ) != 0 ){
+				match = FALSE;
+
+				for( i = 0 ; i < conditions->n_schemes && ok ; ++i ){
+					cond = &conditions->schemes[i];
+
+					if( !cond->positive || !match ){
+						if( cond->pattern && ( !strcmp( cond->pattern, "*" ) || !g_strcmp0( cond->pattern, scheme ))){
+							if( cond->positive ){
+								match = TRUE;
+							} else {
+								ok = FALSE;
+							}
+						}
+					}
+				}
+
+				ok &= match;
+
+				if( !ok ){
+					g_debug( "%s: object is not candidate because of scheme %s", thisfn, scheme );
+				}
+			}
+
+			previous = scheme;
+		}
+	}
+
+	return( ok );
+}
+
+/*
+ * assuming here the same sort of optimization than for schemes
+ *
+ * note that each folder condition must be satisfied, i.e. the selected
+ * dirname must match all positive folders
+ */
+static gboolean
+run_folders( const ProgramConditions *conditions, const FMAIContextProgramScope *scope )
+{
+	static const gchar *thisfn = "fma_icontext_program_run_folders";
+	gboolean ok = TRUE;
+	const gchar *dirname, *previous;
+	const gchar *dirname_utf8;
+	const PatternCond *cond;
+	gboolean match;
+	const guint *files;
+	guint i, j, count;
+
+	if( conditions->folders ){
+		previous = NULL;
+		files = selection_files( scope, SELECTION_CLASS_DIRNAME, &count );
+
+		for( j = 0 ; j < count && ok ; ++j ){
+			dirname = fma_selection_peek_dirname( scope->selection, FILE_AT( files, j ));
+
+			if( !j || g_strcmp0( previous, dirname ) != 0 ){
+				dirname_utf8 = fma_selection_peek_dirname_utf8( scope->selection, FILE_AT( files, j ));
+
+				for( i = 0 ; i < conditions->n_folders && ok ; ++i ){
+					cond = &conditions->folders[i];
+					match = FALSE;
+
+					if( cond->pattern && dirname_utf8 ){
+						match = ( cond->has_wildcard && g_pattern_match_string( cond->spec, dirname_utf8 )) ||
+								g_str_has_prefix( dirname_utf8, cond->pattern );
+					}
+
+					ok &= ( match && cond->positive ) || ( !match && !cond->positive );
+				}
+
+				if( !ok ){
+					g_debug( "%s: object is not candidate because of folder %s", thisfn, dirname );
+				}
+			}
+
+			previous = dirname;
+		}
+	}
+
+	return( ok );
+}
+
+static gboolean
+run_capabilities( const ProgramConditions *conditions, const FMAIContextProgramScope *scope )
+{
+	static const gchar *thisfn = "fma_icontext_program_run_capabilities";
+	gboolean ok = TRUE;
+	guint checked, caps;
+	const guint *files;
+	guint j, count;
+
+	checked = conditions->caps_required | conditions->caps_forbidden;
+
+	if( checked || conditions->caps_never ){
+		files = selection_files( scope, SELECTION_CLASS_CAPABILITIES, &count );
+
+		for( j = 0 ; j < count && ok ; ++j ){
+			caps = fma_selection_classes_capabilities( scope->selection, FILE_AT( files, j ), checked );
+
+			ok = !conditions->caps_never &&
+					( caps & conditions->caps_required ) == conditions->caps_required &&
+					( caps & conditions->caps_forbidden ) == 0;
+		}
+
+		if( !ok ){
+			g_debug( "%s: object is not candidate because Capabilities do not match", thisfn );
+		}
+	}
+
+	return( ok );
+}
+
+/*
+ * file mimetype must be compatible with at least one positive assertion
+ * (they are ORed), while not being of any negative assertions (they are
+ * ANDed)
+ *
+ * while we have not found a match among positive conditions, we have
+ * to check all negative conditions to verify that the current examined
+ * mimetype never match these
+ */
+static gboolean
+run_mimetypes( const ProgramConditions *conditions, const FMAIContextProgramScope *scope )
+{
+	static const gchar *thisfn = "fma_icontext_program_run_mimetypes";
+	gboolean ok = TRUE;
+	const gchar *ftype;
+	gboolean regular, match;
+	const MimetypeCond *cond;
+	const guint *files;
+	guint i, j, count;
+
+	if( !conditions->all_mimetypes ){
+		files = selection_files( scope, SELECTION_CLASS_MIMETYPE, &count );
+
+		for( j = 0 ; j < count && ok ; ++j ){
+			match = FALSE;
+			ftype = fma_selection_peek_mimetype( scope->selection, FILE_AT( files, j ));
+			regular = ( fma_selection_get_file_type( scope->selection, FILE_AT( files, j )) == G_FILE_TYPE_REGULAR );
+
+			if( ftype ){
+				for( i = 0 ; i < conditions->n_mimetypes && ok ; ++i ){
+					cond = &conditions->mimetypes[i];
+
+					if( !cond->positive || !match ){
+						if( is_mimetype_of( cond, ftype, regular )){
+							g_debug( "%s: condition=%s, positive=%s, ftype=%s, matched",
+									thisfn, cond->mimetype, cond->positive ? "True":"False", ftype );
+							if( cond->positive ){
+								match = TRUE;
+							} else {
+								ok = FALSE;
+							}
+						}
+					}
+				}
+
+				if( !match ){
+					g_debug( "%s: no positive match found for %s", thisfn, ftype );
+					ok = FALSE;
+				}
+
+			} else {
+				g_warning( "%s: null mimetype found for %s",
+						thisfn, fma_selection_peek_uri( scope->selection, FILE_AT( files, j )));
+				ok = FALSE;
+			}
+		}
+	}
+
+	return( ok );
+}
+
+/*
+ * does the file have a content type which is 'a sort of' the condition
+ * one ? for example, "image/jpeg" is clearly a sort of "image/ *"
+ *
+ * content type if the same as the mime type in *nix;
+ * this is not true on Win32 platforms
+ *
+ * the relation is memoized by FMAContentType
+ */
+static gboolean
+is_mimetype_of( const MimetypeCond *cond, const gchar *file_mimetype, gboolean is_regular )
+{
+	if( cond->kind == MIMETYPE_ALL ){
+		return( TRUE );
+	}
+
+	if( cond->kind == MIMETYPE_FILES && is_regular ){
+		return( TRUE );
+	}
+
+	return( cond->content_type && fma_content_type_is_a( file_mimetype, cond->content_type ));
+}
+
+static gboolean
+run_basenames( const ProgramConditions *conditions, const FMAIContextProgramScope *scope )
+{
+	static const gchar *thisfn = "fma_icontext_program_run_basenames";
+	gboolean ok = TRUE;
+	const gchar *bname, *dot;
+	const PatternCond *cond;
+	gboolean match;
+	guint bits;
+	const guint *files;
+	guint i, j, count;
+
+	if( conditions->basenames ){
+		files = selection_files( scope, SELECTION_CLASS_N, &count );
+
+		for( j = 0 ; j < count && ok ; ++j ){
+			bname = fma_selection_peek_basename_utf8( scope->selection, FILE_AT( files, j ), !conditions->matchcase );
+			match = FALSE;
+
+			if( bname && conditions->extensions ){
+				dot = strrchr( bname, '.' );
+				bits = dot ? GPOINTER_TO_UINT( g_hash_table_lookup( conditions->extensions, dot+1 )) : 0;
+				if( bits & EXTENSION_NEGATIVE ){
+					g_debug( "%s: negative extension condition matched for %s", thisfn, bname );
+					ok = FALSE;
+				}
+				if( bits & EXTENSION_POSITIVE ){
+					match = TRUE;
+				}
+			}
+
+			for( i = 0 ; i < conditions->n_basenames && ok && bname ; ++i ){
+				cond = &conditions->basenames[i];
+
+				if( !cond->positive || !match ){
+					if( cond->spec && g_pattern_match_string( cond->spec, bname )){
+						g_debug( "%s: condition=%s, positive=%s, basename=%s: matched",
+								thisfn, cond->pattern, cond->positive ? "True":"False", bname );
+						if( cond->positive ){
+							match = TRUE;
+						} else {
+							ok = FALSE;
+						}
+					}
+				}
+			}
+
+			if( !match ){
+				g_debug( "%s: no positive match found for %s", thisfn, bname );
+				ok = FALSE;
+			}
+		}
+	}
+
+	return( ok );
+}
+
+/*
+ * a cacheable TryExec is only checked again after the file has changed
+ */
+static gboolean
+run_try_exec( FMAIContextProgram *program )
+{
+	static const gchar *thisfn = "fma_icontext_program_run_try_exec";
+	TryExecCheck *check;
+	guint status;
+
+	if( !program->try_exec ){
+		return( TRUE );
+	}
+
+	check = program->try_exec;
+	status = check->status;
+
+	if( status == TRY_EXEC_UNKNOWN ){
+		status = try_exec_evaluate( check->path ) ? TRY_EXEC_OK : TRY_EXEC_KO;
+		if( check->cacheable ){
+			check->status = status;
+		}
+	}
+
+	if( status != TRY_EXEC_OK ){
+		g_debug( "%s: object is not candidate because TryExec=%s", thisfn, check->path );
+	}
+
+	return( status == TRY_EXEC_OK );
+}
+
+static gboolean
+run_show_if_registered( const FMAIContextProgram *program )
+{
+	static const gchar *thisfn = "fma_icontext_program_run_show_if_registered";
+	gboolean ok = TRUE;
+
+	if( program->show_if_registered ){
+		ok = fma_dbus_names_has_owner( program->show_if_registered );
+
+		if( !ok ){
+			g_debug( "%s: object is not candidate because ShowIfRegistered=%s", thisfn, program->show_if_registered );
+		}
+	}
+
+	return( ok );
+}
+
+static gboolean
+run_show_if_true( const FMAIContextProgram *program )
+{
+	static const gchar *thisfn = "fma_icontext_program_run_show_if_true";
+	gboolean ok = TRUE;
+
+	if( program->show_if_true ){
+		ok = expensive_get( EXPENSIVE_SHOW_IF_TRUE, program->show_if_true, st_deadline, st_fallback );
+
+		if( !ok ){
+			g_debug( "%s: object is not candidate because ShowIfTrue=%s", thisfn, program->show_if_true );
+		}
+	}
+
+	return( ok );
+}
+
+static gboolean
+run_show_if_running( const FMAIContextProgram *program )
+{
+	static const gchar *thisfn = "fma_icontext_program_run_show_if_running";
+	gboolean ok = TRUE;
+
+	if( program->show_if_running ){
+		ok = expensive_get( EXPENSIVE_SHOW_IF_RUNNING, program->show_if_running, st_deadline, st_fallback );
+
+		if( !ok ){
+			g_debug( "%s: object is not candidate because ShowIfRunning=%s", thisfn, program->show_if_running );
+		}
+	}
+
+	return( ok );
+}
+
+/*
+ * returns the result of the expensive condition, waiting for it until
+ * @deadline (or without limit if zero)
+ *
+ * the evaluation always happens in a worker thread; if it has not
+ * finished in time, the last known result is returned, or @fallback if
+ * the condition has never been evaluated yet: the worker keeps running
+ * and its result will be available for the next request
+ */
+static gboolean
+expensive_get( guint kind, const gchar *arg, gint64 deadline, gboolean fallback )
+{
+	static const gchar *thisfn = "fma_icontext_program_expensive_get";
+	ExpensiveCond *cond;
+	gboolean result;
+
+	g_mutex_lock( &st_expensive_mutex );
+
+	cond = expensive_lookup( kind, arg );
+	expensive_start( cond );
+	cond->waiters += 1;
+
+	while( cond->running ){
+		if( deadline ){
+			if( !g_cond_wait_until( &st_expensive_cond, &st_expensive_mutex, deadline )){
+				break;
+			}
+		} else {
+			g_cond_wait( &st_expensive_cond, &st_expensive_mutex );
+		}
+	}
+
+	cond->waiters -= 1;
+
+	if( !cond->running || cond->available ){
+		result = cond->result;
+
+	} else {
+		result = fallback;
+		g_debug( "%s: %s has not been evaluated in time, defaulting to %s",
+				thisfn, cond->arg, result ? "True":"False" );
+	}
+
+	g_mutex_unlock( &st_expensive_mutex );
+
+	return( result );
+}
+
+/*
+ * returns the condition, allocating it if needed
+ *
+ * the expensive mutex is expected to be locked by the caller
+ */
+static ExpensiveCond *
+expensive_lookup( guint kind, const gchar *arg )
+{
+	ExpensiveCond *cond;
+	gchar *key;
+
+	if( !st_expensive ){
+		st_expensive = g_hash_table_new_full( g_str_hash, g_str_equal, NULL, ( GDestroyNotify ) expensive_free );
+	}
+
+	key = g_strdup_printf( "%u:%s", kind, arg );
+	cond = ( ExpensiveCond * ) g_hash_table_lookup( st_expensive, key );
+
+	if( cond ){
+		g_free( key );
+
+	} else {
+		expensive_purge();
+		cond = g_new0( ExpensiveCond, 1 );
+		cond->key = key;
+		cond->kind = kind;
+		cond->arg = g_strdup( arg );
+		g_hash_table_insert( st_expensive, cond->key, cond );
+	}
+
+	return( cond );
+}
+
+/*
+ * queues the condition to the expensive pool, unless it is already
+ * running, or the known result of a ShowIfTrue command is still fresh
+ *
+ * the condition is said running as soon as it is queued, so that it is
+ * not queued twice while all the workers are busy
+ *
+ * the expensive mutex is expected to be locked by the caller
+ */
+static void
+expensive_start( ExpensiveCond *cond )
+{
+	if( cond->running ){
+		return;
+	}
+
+	if( cond->available &&
+			cond->kind == EXPENSIVE_SHOW_IF_TRUE &&
+			g_get_monotonic_time() - cond->stamp < st_show_if_true_ttl ){
+		return;
+	}
+
+	if( !st_expensive_pool ){
+		st_expensive_pool = g_thread_pool_new(( GFunc ) expensive_thread, NULL, EXPENSIVE_THREADS, FALSE, NULL );
+	}
+
+	cond->running = TRUE;
+	g_thread_pool_push( st_expensive_pool, cond, NULL );
+}
+
+/*
+ * a command which has been killed on timeout is recorded as failed, and
+ * is no more running: it will be spawned again once its result is stale
+ */
+static void
+expensive_thread( ExpensiveCond *cond, gpointer user_data )
+{
+	gboolean result;
+	gint64 timeout;
+
+	/* the key and the argument are never modified while the
+	 * condition is running, so do not need to be locked
+	 */
+	if( cond->kind == EXPENSIVE_SHOW_IF_TRUE ){
+		g_mutex_lock( &st_expensive_mutex );
+		timeout = st_show_if_true_timeout;
+		g_mutex_unlock( &st_expensive_mutex );
+		result = expensive_show_if_true( cond->arg, timeout );
+	} else {
+		result = expensive_show_if_running( cond->arg );
+	}
+
+	g_mutex_lock( &st_expensive_mutex );
+	cond->result = result;
+	cond->available = TRUE;
+	cond->stamp = g_get_monotonic_time();
+	cond->running = FALSE;
+	g_cond_broadcast( &st_expensive_cond );
+	g_mutex_unlock( &st_expensive_mutex );
+}
+
+/*
+ * the conditions are keyed by their command or process name, which may
+ * embed expanded parameters: do not let the table grow without limit
+ *
+ * the expensive mutex is expected to be locked by the caller
+ */
+static void
+expensive_purge( void )
+{
+	GHashTableIter iter;
+	ExpensiveCond *cond;
+
+	if( g_hash_table_size( st_expensive ) >= EXPENSIVE_MAX ){
+		g_hash_table_iter_init( &iter, st_expensive );
+		while( g_hash_table_iter_next( &iter, NULL, ( gpointer * ) &cond )){
+			if( !cond->running && !cond->waiters ){
+				g_hash_table_iter_remove( &iter );
+			}
+		}
+	}
+}
+
+static void
+expensive_free( ExpensiveCond *cond )
+{
+	g_free( cond->key );
+	g_free( cond->arg );
+	g_free( cond );
+}
+
+/*
+ * ShowIfTrue: the command must output the 'true' string
+ *
+ * the command is killed if it has not terminated after @timeout
+ * microseconds, and is then considered as having failed: a hung script
+ * must not hold its worker forever
+ */
+static gboolean
+expensive_show_if_true( const gchar *command, gint64 timeout )
+{
+	static const gchar *thisfn = "fma_icontext_program_expensive_show_if_true";
+	gboolean ok = FALSE;
+	gchar **argv = NULL;
+	GError *error = NULL;
+	GPid pid;
+	gint out_fd;
+	GString *output;
+	gchar buffer[EXPENSIVE_OUTPUT_MAX];
+	struct pollfd pfd;
+	gint64 deadline, remaining;
+	gssize len;
+	gint status;
+	gboolean exited;
+
+	if( !g_shell_parse_argv( command, NULL, &argv, &error ) ||
+			!g_spawn_async_with_pipes( NULL, argv, NULL,
+					G_SPAWN_SEARCH_PATH | G_SPAWN_DO_NOT_REAP_CHILD, NULL, NULL,
+					&pid, NULL, &out_fd, NULL, &error )){
+		g_debug( "%s: %s: %s", thisfn, command, error->message );
+		g_error_free( error );
+		g_strfreev( argv );
+		return( FALSE );
+	}
+	g_strfreev( argv );
+
+	deadline = g_get_monotonic_time() + timeout;
+	output = g_string_new( "" );
+	pfd.fd = out_fd;
+	pfd.events = POLLIN;
+
+	/* only the beginning of the output is kept, which is enough to
+	 * compare it with 'true'
+	 */
+	while(( remaining = deadline - g_get_monotonic_time()) > 0 ){
+		if( poll( &pfd, 1, ( gint )(( remaining + 999 ) / 1000 )) <= 0 ){
+			continue;
+		}
+		len = read( out_fd, buffer, sizeof( buffer ));
+		if( len < 0 && errno == EINTR ){
+			continue;
+		}
+		if( len <= 0 ){
+			break;
+		}
+		if( output->len < EXPENSIVE_OUTPUT_MAX ){
+			g_string_append_len( output, buffer, MIN(( gsize ) len, EXPENSIVE_OUTPUT_MAX - output->len ));
+		}
+	}
+	close( out_fd );
+
+	/* the standard output may have been closed before the command
+	 * terminates
+	 */
+	while( !( exited = ( waitpid( pid, &status, WNOHANG ) == pid )) && g_get_monotonic_time() < deadline ){
+		g_usleep( 10 * G_TIME_SPAN_MILLISECOND );
+	}
+
+	if( exited ){
+		ok = !strcmp( output->str, "true" );
+
+	} else {
+		kill( pid, SIGKILL );
+		waitpid( pid, &status, 0 );
+		g_debug( "%s: %s has not terminated in %" G_GINT64_FORMAT "ms, killed",
+				thisfn, command, timeout / G_TIME_SPAN_MILLISECOND );
+	}
+
+	g_spawn_close_pid( pid );
+	g_string_free( output, TRUE );
+
+	return( ok );
+}
+
+/*
+ * ShowIfRunning: the running processes are searched for in a snapshot
+ * which is shared by all the conditions
+ */
+static gboolean
+expensive_show_if_running( const gchar *name )
+{
+	return( fma_proc_snapshot_is_running( name ));
+}
+
+/*
+ * the asynchronous evaluation only waits for the expensive conditions
+ * in a worker thread, and without any deadline
+ */
+static void
+async_thread( GTask *task, gpointer source_object, AsyncData *data, GCancellable *cancellable )
+{
+	gboolean ok = TRUE;
+
+	if( data->show_if_true ){
+		ok = expensive_get( EXPENSIVE_SHOW_IF_TRUE, data->show_if_true, 0, FALSE );
+	}
+
+	if( ok && data->show_if_running && !g_cancellable_is_cancelled( cancellable )){
+		ok = expensive_get( EXPENSIVE_SHOW_IF_RUNNING, data->show_if_running, 0, FALSE );
+	}
+
+	if( !g_task_return_error_if_cancelled( task )){
+		g_task_return_boolean( task, ok );
+	}
+}
+
+static void
+async_data_free( AsyncData *data )
+{
+	g_free( data->show_if_true );
+	g_free( data->show_if_running );
+	g_free( data );
+}
+
+/*
+ * queries, from the calling thread, the attributes the pure steps of the
+ * @programs may need: the mimetype and the type for the mimetypes
+ * conditions, the access rights and the owner for the capabilities
+ * ones; with classes, they are computed here, and so query the
+ * attributes of the representatives; the other per-file conditions only
+ * depend on the URI
+ */
+static void
+pure_prefetch( const FMAIContextProgramScope *scope, FMAIContextProgram **programs, guint count )
+{
+	gboolean mimetypes, capabilities;
+	const guint *files;
+	guint i, n;
+
+	mimetypes = FALSE;
+	capabilities = FALSE;
+
+	for( i = 0 ; i < count ; ++i ){
+		if( programs[i] && !programs[i]->never ){
+			mimetypes |= !programs[i]->conditions->all_mimetypes;
+			capabilities |= ( programs[i]->conditions->caps_required ||
+					programs[i]->conditions->caps_forbidden ||
+					programs[i]->conditions->caps_never );
+		}
+	}
+
+	if( mimetypes ){
+		files = selection_files( scope, SELECTION_CLASS_MIMETYPE, &n );
+		for( i = 0 ; i < n ; ++i ){
+			fma_selection_peek_mimetype( scope->selection, FILE_AT( files, i ));
+			fma_selection_get_file_type( scope->selection, FILE_AT( files, i ));
+		}
+	}
+
+	if( capabilities ){
+		files = selection_files( scope, SELECTION_CLASS_CAPABILITIES, &n );
+		for( i = 0 ; i < n ; ++i ){
+			fma_selection_classes_capabilities( scope->selection, FILE_AT( files, i ), SELECTION_CAP_ALL );
+		}
+	}
+}
+
+/*
+ * evaluates the pure steps of a slice of the programs
+ */
+static void
+pure_thread( PureSlice *slice, gpointer user_data )
+{
+	guint i;
+
+	for( i = slice->start ; i < slice->end ; ++i ){
+		if( slice->programs[i] ){
+			slice->results[i] = program_run_steps(
+					slice->programs[i], slice->scope, STEPS_PURE, TRUE ) ? PURE_ACCEPTED : PURE_REJECTED;
+		}
+	}
+
+	g_mutex_lock( &slice->batch->mutex );
+	slice->batch->pending -= 1;
+	if( !slice->batch->pending ){
+		g_cond_signal( &slice->batch->cond );
+	}
+	g_mutex_unlock( &slice->batch->mutex );
+
+	g_free( slice );
+}
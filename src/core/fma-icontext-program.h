@@ -0,0 +1,140 @@
+/*
+ * FileManager-Actions
+ * A file-manager extension which offers configurable context menu actions.
+ *
+ * Copyright (C) 2005 The GNOME Foundation
+ * Copyright (C) 2006-2008 Frederic Ruaudel and others (see AUTHORS)
+ * Copyright (C) 2009-2015 Pierre Wieser and others (see AUTHORS)
+ *
+ * FileManager-Actions is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * FileManager-Actions is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FileManager-Actions; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Frederic Ruaudel <grumz@grumz.net>
+ *   Rodrigo Moya <rodrigo@gnome-db.org>
+ *   Pierre Wieser <pwieser@trychlos.org>
+ *   ... and many others (see AUTHORS)
+ */
+
+#ifndef __CORE_FMA_ICONTEXT_PROGRAM_H__
+#define __CORE_FMA_ICONTEXT_PROGRAM_H__
+
+/* @title: FMAIContextProgram
+ * @short_description: The compiled form of FMAIContext conditions
+ * @include: core/fma-icontext-program.h
+ *
+ * The conditions of an action, a profile or a menu are compiled once
+ * into an immutable program which is attached to the #FMAIContext
+ * object, so that checking whether the object is candidate for a given
+ * selection does not have to read, duplicate and parse again each
+ * condition.
+ *
+ * The program is compiled when the #FMAPivot loads its items, or else
+ * on first use, and is dropped as soon as any data of the object is
+ * modified.
+ *
+ * The conditions which do not depend on the selection are evaluated at
+ * compile time: OnlyShowIn and NotShowIn against the current desktop,
+ * and TryExec when its path does not embed any parameter. This later is
+ * monitored, and checked again after the file has changed.
+ *
+ * ShowIfRegistered is checked against the set of the names owned on the
+ * session bus, which is maintained by #FMADBusNames.
+ *
+ * A program may also be derived for an object which has been duplicated
+ * from an already compiled one, and whose only the TryExec, ShowIfRegistered,
+ * ShowIfTrue and ShowIfRunning conditions may have been modified (e.g.
+ * when expanding parameters): the derived program shares the compiled
+ * conditions of the source object.
+ *
+ * ShowIfTrue and ShowIfRunning conditions, which have to run an external
+ * command or to scan the running processes, are evaluated in worker
+ * threads: the caller may set a deadline after which a not yet finished
+ * condition resolves to its last known result, or to a default value.
+ * The result of a ShowIfTrue command is reused for a configurable time.
+ *
+ * The checks of a set of objects against the same selection share a
+ * #FMAIContextProgramScope. The conditions which only depend on the
+ * selection may be evaluated for a whole set of objects in a pool of
+ * worker threads, before the menu is actually built; their results are
+ * kept in the scope.
+ *
+ * The conditions of the candidate chain are reordered by their observed
+ * cost and selectivity, as measured on a sample of the runs; these
+ * statistics may be read with fma_icontext_program_get_step_stats().
+ */
+
+#include <api/fma-icontext.h>
+
+#include "fma-selection-classes.h"
+#include "fma-tokens.h"
+
+G_BEGIN_DECLS
+
+/* the keys of the positive mimetype and scheme conditions, and of the
+ * folders conditions, as enumerated by fma_icontext_program_foreach_key()
+ */
+enum {
+	ICONTEXT_KEY_MIMETYPE_ANY = 1,		/* any mimetype may match */
+	ICONTEXT_KEY_MIMETYPE_FILES,		/* any regular file may match */
+	ICONTEXT_KEY_MIMETYPE,				/* files of this content type may match */
+	ICONTEXT_KEY_SCHEME_ANY,			/* any scheme may match */
+	ICONTEXT_KEY_SCHEME,				/* this scheme may match */
+	ICONTEXT_KEY_FOLDER,				/* this folder must match (NULL if invalid) */
+	ICONTEXT_KEY_NOT_FOLDER				/* this folder must not match */
+};
+
+typedef struct _FMAIContextProgramScope FMAIContextProgramScope;
+
+typedef void ( *FMAIContextProgramKeyFunc )( const FMAIContext *context, guint type, const gchar *key, void *user_data );
+
+/* the statistics of a step of the candidate chain, as returned by
+ * fma_icontext_program_get_step_stats()
+ */
+typedef struct {
+	const gchar *name;
+	guint64      calls;
+	guint64      rejects;
+	gint64       cost;					/* cumulative, in microseconds */
+}
+	FMAIContextProgramStepStats;
+
+void     fma_icontext_program_attach               ( FMAIContext *context );
+void     fma_icontext_program_attach_tree          ( GList *tree );
+void     fma_icontext_program_derive               ( FMAIContext *context, const FMAIContext *source );
+void     fma_icontext_program_reset                ( FMAIContext *context );
+
+FMAIContextProgramScope *
+         fma_icontext_program_scope_new            ( guint target, FMASelection *selection, FMASelectionClasses *classes );
+void     fma_icontext_program_scope_free           ( FMAIContextProgramScope *scope );
+
+gboolean fma_icontext_program_is_candidate         ( const FMAIContext *context, const FMAIContextProgramScope *scope );
+gboolean fma_icontext_program_is_never_candidate   ( const FMAIContext *context );
+void     fma_icontext_program_is_candidate_async   ( const FMAIContext *context, const FMAIContextProgramScope *scope, GTask *task );
+
+void     fma_icontext_program_evaluate_pure        ( FMAIContextProgramScope *scope, GPtrArray *contexts, guint threads );
+
+gboolean fma_icontext_program_prefetch             ( const FMAIContext *context, const FMAIContextProgramScope *scope, const FMATokens *tokens );
+
+void     fma_icontext_program_set_deadline         ( gint64 deadline, gboolean fallback );
+void     fma_icontext_program_set_show_if_true_ttl ( gint64 ttl );
+void     fma_icontext_program_set_show_if_true_timeout( gint64 timeout );
+
+void     fma_icontext_program_foreach_key          ( const FMAIContext *context, FMAIContextProgramKeyFunc func, void *user_data );
+
+FMAIContextProgramStepStats *fma_icontext_program_get_step_stats( guint *count );
+
+G_END_DECLS
+
+#endif /* __CORE_FMA_ICONTEXT_PROGRAM_H__ */
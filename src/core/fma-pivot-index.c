@@ -0,0 +1,525 @@
+/*
+ * FileManager-Actions
+ * A file-manager extension which offers configurable context menu actions.
+ *
+ * Copyright (C) 2005 The GNOME Foundation
+ * Copyright (C) 2006-2008 Frederic Ruaudel and others (see AUTHORS)
+ * Copyright (C) 2009-2015 Pierre Wieser and others (see AUTHORS)
+ *
+ * FileManager-Actions is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * FileManager-Actions is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FileManager-Actions; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Frederic Ruaudel <grumz@grumz.net>
+ *   Rodrigo Moya <rodrigo@gnome-db.org>
+ *   Pierre Wieser <pwieser@trychlos.org>
+ *   ... and many others (see AUTHORS)
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include <api/fma-object-api.h>
+
+#include "fma-content-type.h"
+#include "fma-folder-trie.h"
+#include "fma-icontext-program.h"
+#include "fma-pivot-index.h"
+#include "fma-selection.h"
+
+/* the index itself
+ * each indexed object has a dense identifier, which is its bit number
+ * in the bitsets
+ */
+struct _FMAPivotIndex {
+	guint       count;					/* count of indexed objects */
+	guint       words;					/* size of a bitset */
+	GHashTable *ids;					/* FMAIContext -> identifier + 1 */
+	guint32    *mimetype_any;			/* objects which accept any mimetype */
+	guint32    *mimetype_files;			/* objects which accept any regular file */
+	GHashTable *mimetypes;				/* content type of a condition -> bitset */
+	guint32    *scheme_any;				/* objects which accept any scheme */
+	GHashTable *schemes;				/* scheme of a condition -> bitset */
+	guint32    *folders_any;			/* objects without folders condition */
+	FMAFolderTrie *folders;			/* folder pattern -> rule identifier */
+	GArray     *rules;					/* rule identifier -> FolderRule */
+	guint      *n_positive;				/* object -> count of positive folders */
+};
+
+/* a folder condition of an object
+ */
+typedef struct {
+	guint    id;						/* the identifier of the object + 1 */
+	gboolean positive;
+}
+	FolderRule;
+
+/* the data of a walk along the folder trie
+ * the buffers are allocated once per selection, and cleared before each
+ * directory
+ */
+typedef struct {
+	const FMAPivotIndex *index;
+	guint               *matched;		/* object -> count of matched positive folders */
+	guint32             *excluded;		/* objects which match a negative folder */
+	guint32             *matching;		/* objects whose folders conditions are satisfied */
+}
+	FolderWalk;
+
+/* the result of a selection
+ */
+struct _FMAPivotIndexSet {
+	const FMAPivotIndex *index;
+	guint32             *bits;
+};
+
+#define BITSET_WORD( id )			(( id ) / 32 )
+#define BITSET_MASK( id )			(( guint32 ) 1 << (( id ) % 32 ))
+
+static void     collect_contexts( GList *tree, GPtrArray *contexts );
+static void     on_context_key( const FMAIContext *context, guint type, const gchar *key, FMAPivotIndex *index );
+static guint32 *bitset_new( const FMAPivotIndex *index );
+static guint32 *bitset_lookup( const FMAPivotIndex *index, GHashTable *table, const gchar *key );
+static void     bitset_set( const FMAPivotIndex *index, guint32 *bitset, const FMAIContext *context );
+static void     bitset_or( const FMAPivotIndex *index, guint32 *bitset, const guint32 *other );
+static void     bitset_and( const FMAPivotIndex *index, guint32 *bitset, const guint32 *other );
+static void     select_mimetype( FMAPivotIndex *index, guint32 *bits, const gchar *mimetype, gboolean is_regular );
+static void     select_scheme( FMAPivotIndex *index, guint32 *bits, const gchar *scheme );
+static void     select_folder( FolderWalk *walk, guint32 *bits, const gchar *dirname_utf8 );
+static void     on_folder_matched( guint rule, FolderWalk *walk );
+static gboolean has_context( const FMAPivotIndexSet *set, const FMAIContext *context );
+
+/*
+ * fma_pivot_index_new:
+ * @tree: the tree of items, as loaded by the FMAPivot.
+ *
+ * Returns: a newly allocated #FMAPivotIndex, which should be
+ * fma_pivot_index_free() by the caller.
+ */
+FMAPivotIndex *
+fma_pivot_index_new( GList *tree )
+{
+	static const gchar *thisfn = "fma_pivot_index_new";
+	FMAPivotIndex *index;
+	GPtrArray *contexts;
+	guint i;
+
+	contexts = g_ptr_array_new();
+	collect_contexts( tree, contexts );
+
+	index = g_new0( FMAPivotIndex, 1 );
+	index->count = contexts->len;
+	index->words = ( contexts->len + 31 ) / 32;
+	index->ids = g_hash_table_new( g_direct_hash, g_direct_equal );
+	index->mimetype_any = bitset_new( index );
+	index->mimetype_files = bitset_new( index );
+	index->mimetypes = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, g_free );
+	index->scheme_any = bitset_new( index );
+	index->schemes = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, g_free );
+	index->folders_any = bitset_new( index );
+	memset( index->folders_any, 0xff, index->words * sizeof( guint32 ));
+	index->folders = fma_folder_trie_new();
+	index->rules = g_array_new( FALSE, FALSE, sizeof( FolderRule ));
+	index->n_positive = g_new0( guint, MAX( index->count, 1 ));
+
+	for( i = 0 ; i < contexts->len ; ++i ){
+		g_hash_table_insert( index->ids, g_ptr_array_index( contexts, i ), GUINT_TO_POINTER( i+1 ));
+	}
+
+	for( i = 0 ; i < contexts->len ; ++i ){
+		fma_icontext_program_foreach_key(
+				FMA_ICONTEXT( g_ptr_array_index( contexts, i )), ( FMAIContextProgramKeyFunc ) on_context_key, index );
+	}
+
+	g_debug( "%s: index=%p, count=%u, mimetypes=%u, schemes=%u, folders=%u",
+			thisfn, ( void * ) index, index->count,
+			g_hash_table_size( index->mimetypes ), g_hash_table_size( index->schemes ), index->rules->len );
+
+	g_ptr_array_free( contexts, TRUE );
+
+	return( index );
+}
+
+/*
+ * fma_pivot_index_free:
+ * @index: this #FMAPivotIndex.
+ *
+ * Releases the @index.
+ */
+void
+fma_pivot_index_free( FMAPivotIndex *index )
+{
+	if( index ){
+		g_hash_table_destroy( index->ids );
+		g_free( index->mimetype_any );
+		g_free( index->mimetype_files );
+		g_hash_table_destroy( index->mimetypes );
+		g_free( index->scheme_any );
+		g_hash_table_destroy( index->schemes );
+		g_free( index->folders_any );
+		fma_folder_trie_free( index->folders );
+		g_array_free( index->rules, TRUE );
+		g_free( index->n_positive );
+		g_free( index );
+	}
+}
+
+/*
+ * fma_pivot_index_select:
+ * @index: this #FMAPivotIndex.
+ * @classes: the equivalence classes of the current selection.
+ *
+ * Each file of the selection must match at least one mimetype and one
+ * scheme of an object, and its directory must satisfy all the folders
+ * conditions of the object, for this later to be selected. We only have
+ * to check one representative of each class.
+ *
+ * Returns: the set of the objects which may be candidate for the
+ * selection, to be fma_pivot_index_set_free() by the caller.
+ */
+FMAPivotIndexSet *
+fma_pivot_index_select( FMAPivotIndex *index, FMASelectionClasses *classes )
+{
+	FMAPivotIndexSet *set;
+	FMASelection *selection;
+	const guint *representatives;
+	FolderWalk walk;
+	guint i, count;
+
+	g_return_val_if_fail( index, NULL );
+
+	set = g_new0( FMAPivotIndexSet, 1 );
+	set->index = index;
+	set->bits = bitset_new( index );
+	memset( set->bits, 0xff, index->words * sizeof( guint32 ));
+
+	selection = fma_selection_classes_get_selection( classes );
+
+	representatives = fma_selection_classes_get( classes, SELECTION_CLASS_MIMETYPE, &count );
+	for( i = 0 ; i < count ; ++i ){
+		select_mimetype( index, set->bits,
+				fma_selection_peek_mimetype( selection, representatives[i] ),
+				fma_selection_get_file_type( selection, representatives[i] ) == G_FILE_TYPE_REGULAR );
+	}
+
+	representatives = fma_selection_classes_get( classes, SELECTION_CLASS_SCHEME, &count );
+	for( i = 0 ; i < count ; ++i ){
+		select_scheme( index, set->bits, fma_selection_peek_scheme( selection, representatives[i] ));
+	}
+
+	if( index->rules->len ){
+		walk.index = index;
+		walk.matched = g_new( guint, MAX( index->count, 1 ));
+		walk.excluded = bitset_new( index );
+		walk.matching = bitset_new( index );
+
+		representatives = fma_selection_classes_get( classes, SELECTION_CLASS_DIRNAME, &count );
+		for( i = 0 ; i < count ; ++i ){
+			select_folder( &walk, set->bits, fma_selection_peek_dirname_utf8( selection, representatives[i] ));
+		}
+
+		g_free( walk.matched );
+		g_free( walk.excluded );
+		g_free( walk.matching );
+	}
+
+	return( set );
+}
+
+/*
+ * fma_pivot_index_has:
+ * @set: the #FMAPivotIndexSet returned by fma_pivot_index_select().
+ * @context: a #FMAIContext object.
+ *
+ * An action is only selected if at least one of its profiles is itself
+ * selected.
+ *
+ * Returns: %TRUE if the @context may be candidate, %FALSE if it cannot.
+ * An object which is not known from the index is always said to be
+ * possibly candidate.
+ */
+gboolean
+fma_pivot_index_has( const FMAPivotIndexSet *set, const FMAIContext *context )
+{
+	gboolean has;
+	GList *ip;
+
+	g_return_val_if_fail( FMA_IS_ICONTEXT( context ), FALSE );
+
+	if( !set ){
+		return( TRUE );
+	}
+
+	has = has_context( set, context );
+
+	if( has && FMA_IS_OBJECT_ACTION( context )){
+		has = FALSE;
+		for( ip = fma_object_get_items( context ) ; ip && !has ; ip = ip->next ){
+			has = has_context( set, FMA_ICONTEXT( ip->data ));
+		}
+	}
+
+	return( has );
+}
+
+/*
+ * fma_pivot_index_set_free:
+ * @set: the #FMAPivotIndexSet returned by fma_pivot_index_select().
+ *
+ * Releases the @set.
+ */
+void
+fma_pivot_index_set_free( FMAPivotIndexSet *set )
+{
+	if( set ){
+		g_free( set->bits );
+		g_free( set );
+	}
+}
+
+static void
+collect_contexts( GList *tree, GPtrArray *contexts )
+{
+	GList *it, *ip;
+
+	for( it = tree ; it ; it = it->next ){
+		g_ptr_array_add( contexts, it->data );
+
+		if( FMA_IS_OBJECT_MENU( it->data )){
+			collect_contexts( fma_object_get_items( it->data ), contexts );
+
+		} else if( FMA_IS_OBJECT_ACTION( it->data )){
+			for( ip = fma_object_get_items( it->data ) ; ip ; ip = ip->next ){
+				g_ptr_array_add( contexts, ip->data );
+			}
+		}
+	}
+}
+
+static void
+on_context_key( const FMAIContext *context, guint type, const gchar *key, FMAPivotIndex *index )
+{
+	FolderRule rule;
+
+	switch( type ){
+		case ICONTEXT_KEY_MIMETYPE_ANY:
+			bitset_set( index, index->mimetype_any, context );
+			break;
+
+		case ICONTEXT_KEY_MIMETYPE_FILES:
+			bitset_set( index, index->mimetype_files, context );
+			break;
+
+		case ICONTEXT_KEY_MIMETYPE:
+			bitset_set( index, bitset_lookup( index, index->mimetypes, key ), context );
+			break;
+
+		case ICONTEXT_KEY_SCHEME_ANY:
+			bitset_set( index, index->scheme_any, context );
+			break;
+
+		case ICONTEXT_KEY_SCHEME:
+			bitset_set( index, bitset_lookup( index, index->schemes, key ), context );
+			break;
+
+		/* an invalid positive folder is never matched, and so makes
+		 * the object never selected
+		 */
+		case ICONTEXT_KEY_FOLDER:
+		case ICONTEXT_KEY_NOT_FOLDER:
+			rule.id = GPOINTER_TO_UINT( g_hash_table_lookup( index->ids, context ));
+			rule.positive = ( type == ICONTEXT_KEY_FOLDER );
+			if( rule.id ){
+				index->folders_any[BITSET_WORD( rule.id-1 )] &= ~BITSET_MASK( rule.id-1 );
+				if( rule.positive ){
+					index->n_positive[rule.id-1] += 1;
+				}
+				if( key ){
+					fma_folder_trie_add( index->folders, key, index->rules->len );
+					g_array_append_val( index->rules, rule );
+				}
+			}
+			break;
+	}
+}
+
+static guint32 *
+bitset_new( const FMAPivotIndex *index )
+{
+	return( g_new0( guint32, MAX( index->words, 1 )));
+}
+
+/*
+ * returns the bitset associated to the @key in the @table, creating it
+ * if it does not exist yet
+ */
+static guint32 *
+bitset_lookup( const FMAPivotIndex *index, GHashTable *table, const gchar *key )
+{
+	guint32 *bitset;
+
+	bitset = ( guint32 * ) g_hash_table_lookup( table, key );
+
+	if( !bitset ){
+		bitset = bitset_new( index );
+		g_hash_table_insert( table, g_strdup( key ), bitset );
+	}
+
+	return( bitset );
+}
+
+static void
+bitset_set( const FMAPivotIndex *index, guint32 *bitset, const FMAIContext *context )
+{
+	guint id;
+
+	id = GPOINTER_TO_UINT( g_hash_table_lookup( index->ids, context ));
+
+	if( id ){
+		bitset[BITSET_WORD( id-1 )] |= BITSET_MASK( id-1 );
+	}
+}
+
+static void
+bitset_or( const FMAPivotIndex *index, guint32 *bitset, const guint32 *other )
+{
+	guint i;
+
+	for( i = 0 ; i < index->words ; ++i ){
+		bitset[i] |= other[i];
+	}
+}
+
+static void
+bitset_and( const FMAPivotIndex *index, guint32 *bitset, const guint32 *other )
+{
+	guint i;
+
+	for( i = 0 ; i < index->words ; ++i ){
+		bitset[i] &= other[i];
+	}
+}
+
+/*
+ * the objects whose mimetype conditions may match a file of this type
+ * are those which accept any mimetype, those which accept any regular
+ * file if the file is regular, and those which have a condition the
+ * content type of the file is a sort of
+ *
+ * the relations between content types are remembered by FMAContentType,
+ * which forgets them when the shared-mime-info database changes
+ */
+static void
+select_mimetype( FMAPivotIndex *index, guint32 *bits, const gchar *mimetype, gboolean is_regular )
+{
+	guint32 *matching;
+	GHashTableIter iter;
+	gpointer key, value;
+
+	matching = bitset_new( index );
+	bitset_or( index, matching, index->mimetype_any );
+
+	if( is_regular ){
+		bitset_or( index, matching, index->mimetype_files );
+	}
+
+	if( mimetype ){
+		g_hash_table_iter_init( &iter, index->mimetypes );
+		while( g_hash_table_iter_next( &iter, &key, &value )){
+			if( fma_content_type_is_a( mimetype, ( const gchar * ) key )){
+				bitset_or( index, matching, ( const guint32 * ) value );
+			}
+		}
+	}
+
+	bitset_and( index, bits, matching );
+	g_free( matching );
+}
+
+static void
+select_scheme( FMAPivotIndex *index, guint32 *bits, const gchar *scheme )
+{
+	guint32 *matching, *bitset;
+
+	matching = bitset_new( index );
+	bitset_or( index, matching, index->scheme_any );
+
+	bitset = scheme ? ( guint32 * ) g_hash_table_lookup( index->schemes, scheme ) : NULL;
+	if( bitset ){
+		bitset_or( index, matching, bitset );
+	}
+
+	bitset_and( index, bits, matching );
+	g_free( matching );
+}
+
+/*
+ * the objects whose folders conditions are satisfied by this directory
+ * are those which do not have any folders condition, and those whose all
+ * positive folders, and none of the negative ones, match the directory
+ */
+static void
+select_folder( FolderWalk *walk, guint32 *bits, const gchar *dirname_utf8 )
+{
+	const FMAPivotIndex *index;
+	guint i;
+
+	index = walk->index;
+	memset( walk->matched, '\0', MAX( index->count, 1 ) * sizeof( guint ));
+	memset( walk->excluded, '\0', MAX( index->words, 1 ) * sizeof( guint32 ));
+	memset( walk->matching, '\0', MAX( index->words, 1 ) * sizeof( guint32 ));
+	bitset_or( index, walk->matching, index->folders_any );
+
+	/* a directory which cannot be converted does not match any folder
+	 */
+	if( dirname_utf8 ){
+		fma_folder_trie_match( index->folders, dirname_utf8, ( FMAFolderTrieFunc ) on_folder_matched, walk );
+	}
+
+	for( i = 0 ; i < index->count ; ++i ){
+		if( walk->matched[i] == index->n_positive[i] &&
+				!( walk->excluded[BITSET_WORD( i )] & BITSET_MASK( i ))){
+			walk->matching[BITSET_WORD( i )] |= BITSET_MASK( i );
+		}
+	}
+
+	bitset_and( index, bits, walk->matching );
+}
+
+static void
+on_folder_matched( guint rule, FolderWalk *walk )
+{
+	const FolderRule *folder;
+
+	folder = &g_array_index( walk->index->rules, FolderRule, rule );
+
+	if( folder->positive ){
+		walk->matched[folder->id-1] += 1;
+	} else {
+		walk->excluded[BITSET_WORD( folder->id-1 )] |= BITSET_MASK( folder->id-1 );
+	}
+}
+
+static gboolean
+has_context( const FMAPivotIndexSet *set, const FMAIContext *context )
+{
+	guint id;
+
+	id = GPOINTER_TO_UINT( g_hash_table_lookup( set->index->ids, context ));
+
+	return( !id || ( set->bits[BITSET_WORD( id-1 )] & BITSET_MASK( id-1 )) != 0 );
+}
@@ -0,0 +1,70 @@
+/*
+ * FileManager-Actions
+ * A file-manager extension which offers configurable context menu actions.
+ *
+ * Copyright (C) 2005 The GNOME Foundation
+ * Copyright (C) 2006-2008 Frederic Ruaudel and others (see AUTHORS)
+ * Copyright (C) 2009-2015 Pierre Wieser and others (see AUTHORS)
+ *
+ * FileManager-Actions is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * FileManager-Actions is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FileManager-Actions; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Frederic Ruaudel <grumz@grumz.net>
+ *   Rodrigo Moya <rodrigo@gnome-db.org>
+ *   Pierre Wieser <pwieser@trychlos.org>
+ *   ... and many others (see AUTHORS)
+ */
+
+#ifndef __CORE_FMA_PIVOT_INDEX_H__
+#define __CORE_FMA_PIVOT_INDEX_H__
+
+/* @title: FMAPivotIndex
+ * @short_description: An inverted index of the FMAPivot items
+ * @include: core/fma-pivot-index.h
+ *
+ * The index maps the content types and the URI schemes which appear in
+ * the positive conditions of the items and profiles of the FMAPivot
+ * tree to the set of objects which may match them.
+ *
+ * Intersecting these sets for the distinct content types and schemes of
+ * the selection gives the objects which are worth being fully checked;
+ * all other ones cannot be candidate.
+ *
+ * The folders conditions of all the objects are loaded into a single
+ * #FMAFolderTrie, so that one walk along each distinct directory of the
+ * selection tells which objects satisfy all their folders conditions.
+ */
+
+#include <glib.h>
+
+#include <api/fma-icontext.h>
+
+#include "fma-selection-classes.h"
+
+G_BEGIN_DECLS
+
+typedef struct _FMAPivotIndex     FMAPivotIndex;
+typedef struct _FMAPivotIndexSet  FMAPivotIndexSet;
+
+FMAPivotIndex    *fma_pivot_index_new     ( GList *tree );
+void              fma_pivot_index_free    ( FMAPivotIndex *index );
+
+FMAPivotIndexSet *fma_pivot_index_select  ( FMAPivotIndex *index, FMASelectionClasses *classes );
+gboolean          fma_pivot_index_has     ( const FMAPivotIndexSet *set, const FMAIContext *context );
+void              fma_pivot_index_set_free( FMAPivotIndexSet *set );
+
+G_END_DECLS
+
+#endif /* __CORE_FMA_PIVOT_INDEX_H__ */
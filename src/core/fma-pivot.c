@@ -36,9 +36,12 @@
 #include <api/fma-core-utils.h>
 #include <api/fma-timeout.h>
 
+#include "fma-icontext-program.h"
 #include "fma-io-provider.h"
 #include "fma-module.h"
 #include "fma-pivot.h"
+#include "fma-pivot-index.h"
+#include "fma-template.h"
 
 /* private class data
  */
@@ -46,6 +49,16 @@ struct _FMAPivotClassPrivate {
 	void *empty;						/* so that gcc -pedantic is happy */
 };
 
+/* a pruned view of the tree for a given target: only the actions which
+ * are eligible for the target, and the menus which have at least one
+ * eligible descendant, are kept
+ */
+typedef struct {
+	GList      *items;					/* eligible top-level items */
+	GHashTable *submenus;				/* FMAObjectMenu -> GList of its eligible items */
+}
+	PivotTargetView;
+
 /* private instance data
  */
 struct _FMAPivotPrivate {
@@ -61,6 +74,21 @@ struct _FMAPivotPrivate {
 	 */
 	GList      *tree;
 
+	/* incremented each time the tree is replaced
+	 */
+	guint       generation;
+
+	/* inverted index of the tree, and the generation it has been built for
+	 */
+	FMAPivotIndex *index;
+	guint          index_generation;
+
+	/* pruned views of the tree, one for each target, and the generation
+	 * they have been built for
+	 */
+	PivotTargetView *views[ ITEM_TARGET_ANY ];
+	guint            views_generation;
+
 	/* timeout to manage i/o providers 'item-changed' burst
 	 */
 	FMATimeout  change_timeout;
@@ -100,6 +128,11 @@ static void           instance_finalize( GObject *object );
 
 static FMAObjectItem *get_item_from_tree( const FMAPivot *pivot, GList *tree, const gchar *id );
 
+static PivotTargetView *target_view_new( GList *tree, guint target );
+static GList          *target_view_prune( PivotTargetView *view, GList *items, guint target );
+static void            target_view_free( PivotTargetView *view );
+static void            free_target_views( FMAPivot *pivot );
+
 /* FMAIIOProvider management */
 static void           on_items_changed_timeout( FMAPivot *pivot );
 
@@ -213,6 +246,8 @@ instance_init( GTypeInstance *instance, gpointer klass )
 	self->private->loadable_set = PIVOT_LOAD_NONE;
 	self->private->modules = NULL;
 	self->private->tree = NULL;
+	self->private->generation = 0;
+	self->private->index = NULL;
 
 	/* initialize timeout parameters for 'item-changed' handler
 	 */
@@ -293,6 +328,7 @@ instance_set_property( GObject *object, guint property_id, const GValue *value,
 
 			case PIVOT_PROP_TREE_ID:
 				self->private->tree = g_value_get_pointer( value );
+				self->private->generation += 1;
 				break;
 
 			default:
@@ -327,6 +363,9 @@ instance_dispose( GObject *object )
 				( void * ) self->private->tree, g_list_length( self->private->tree ));
 		fma_object_dump_tree( self->private->tree );
 		self->private->tree = fma_object_free_items( self->private->tree );
+		fma_pivot_index_free( self->private->index );
+		self->private->index = NULL;
+		free_target_views( self );
 
 		/* release the settings */
 		fma_settings_free();
@@ -501,6 +540,92 @@ fma_pivot_get_item( const FMAPivot *pivot, const gchar *id )
 	return( object );
 }
 
+static PivotTargetView *
+target_view_new( GList *tree, guint target )
+{
+	static const gchar *thisfn = "fma_pivot_target_view_new";
+	PivotTargetView *view;
+
+	view = g_new0( PivotTargetView, 1 );
+	view->submenus = g_hash_table_new_full( g_direct_hash, g_direct_equal, NULL, ( GDestroyNotify ) g_list_free );
+	view->items = target_view_prune( view, tree, target );
+
+	g_debug( "%s: target=%u, top-level items=%u/%u, menus=%u",
+			thisfn, target, g_list_length( view->items ), g_list_length( tree ), g_hash_table_size( view->submenus ));
+
+	return( view );
+}
+
+/*
+ * returns the list of the eligible @items, recording in passing the
+ * eligible items of the menus
+ */
+static GList *
+target_view_prune( PivotTargetView *view, GList *items, guint target )
+{
+	GList *eligibles, *it, *subitems;
+	gboolean eligible;
+
+	eligibles = NULL;
+
+	for( it = items ; it ; it = it->next ){
+		eligible = FALSE;
+
+		/* items which cannot be candidate in this session are skipped */
+		if( fma_icontext_program_is_never_candidate( FMA_ICONTEXT( it->data ))){
+			continue;
+		}
+
+		if( FMA_IS_OBJECT_MENU( it->data )){
+			subitems = target_view_prune( view, fma_object_get_items( it->data ), target );
+			if( subitems ){
+				g_hash_table_insert( view->submenus, it->data, subitems );
+				eligible = TRUE;
+			}
+
+		} else if( FMA_IS_OBJECT_ACTION( it->data )){
+			switch( target ){
+				case ITEM_TARGET_SELECTION:
+					eligible = fma_object_is_target_selection( it->data );
+					break;
+				case ITEM_TARGET_LOCATION:
+					eligible = fma_object_is_target_location( it->data );
+					break;
+				case ITEM_TARGET_TOOLBAR:
+					eligible = fma_object_is_target_toolbar( it->data );
+					break;
+			}
+		}
+
+		if( eligible ){
+			eligibles = g_list_prepend( eligibles, it->data );
+		}
+	}
+
+	return( g_list_reverse( eligibles ));
+}
+
+static void
+target_view_free( PivotTargetView *view )
+{
+	g_hash_table_destroy( view->submenus );
+	g_list_free( view->items );
+	g_free( view );
+}
+
+static void
+free_target_views( FMAPivot *pivot )
+{
+	guint i;
+
+	for( i = 0 ; i < ITEM_TARGET_ANY ; ++i ){
+		if( pivot->private->views[i] ){
+			target_view_free( pivot->private->views[i] );
+			pivot->private->views[i] = NULL;
+		}
+	}
+}
+
 static FMAObjectItem *
 get_item_from_tree( const FMAPivot *pivot, GList *tree, const gchar *id )
 {
@@ -550,6 +675,117 @@ fma_pivot_get_items( const FMAPivot *pivot )
 	return( tree );
 }
 
+/*
+ * fma_pivot_get_target_items:
+ * @pivot: this #FMAPivot instance.
+ * @target: the target.
+ * @menu: [allow-none]: a #FMAObjectMenu of the tree, or %NULL.
+ *
+ * Returns: the items of the @menu (or the top-level items if @menu is
+ * %NULL) which are eligible for the @target, i.e. the actions which are
+ * flagged for the @target, and the menus which have at least one such
+ * action as descendant. The items which cannot be candidate in this
+ * session, whatever be the selection, are not eligible.
+ *
+ * The pruned views are (re)built here, once for each target, if the tree
+ * has changed since the last call.
+ *
+ * The returned list is owned by this #FMAPivot object, and should not
+ * be released by the caller.
+ */
+GList *
+fma_pivot_get_target_items( FMAPivot *pivot, guint target, const FMAObjectItem *menu )
+{
+	PivotTargetView *view;
+	GList *items;
+
+	g_return_val_if_fail( FMA_IS_PIVOT( pivot ), NULL );
+
+	items = NULL;
+
+	if( !pivot->private->dispose_has_run ){
+
+		if( target < ITEM_TARGET_SELECTION || target >= ITEM_TARGET_ANY ){
+			return( menu ? fma_object_get_items( menu ) : pivot->private->tree );
+		}
+
+		if( pivot->private->views_generation != pivot->private->generation ){
+			free_target_views( pivot );
+			pivot->private->views_generation = pivot->private->generation;
+		}
+
+		view = pivot->private->views[target];
+		if( !view ){
+			view = target_view_new( pivot->private->tree, target );
+			pivot->private->views[target] = view;
+		}
+
+		items = menu ? ( GList * ) g_hash_table_lookup( view->submenus, menu ) : view->items;
+	}
+
+	return( items );
+}
+
+/*
+ * fma_pivot_get_generation:
+ * @pivot: this #FMAPivot instance.
+ *
+ * Returns: the generation of the current configuration tree.
+ *
+ * The generation is incremented each time the tree is reloaded or
+ * replaced, so that the consumers may know when the data they have
+ * computed from the previous tree have become obsolete.
+ */
+guint
+fma_pivot_get_generation( const FMAPivot *pivot )
+{
+	guint generation;
+
+	g_return_val_if_fail( FMA_IS_PIVOT( pivot ), 0 );
+
+	generation = 0;
+
+	if( !pivot->private->dispose_has_run ){
+
+		generation = pivot->private->generation;
+	}
+
+	return( generation );
+}
+
+/*
+ * fma_pivot_get_index:
+ * @pivot: this #FMAPivot instance.
+ *
+ * Returns: the inverted index of the current configuration tree, which
+ * is (re)built here if the tree has changed since the last call.
+ *
+ * The returned index is owned by this #FMAPivot object, and is only
+ * valid until the tree is reloaded or replaced.
+ */
+FMAPivotIndex *
+fma_pivot_get_index( FMAPivot *pivot )
+{
+	FMAPivotIndex *index;
+
+	g_return_val_if_fail( FMA_IS_PIVOT( pivot ), NULL );
+
+	index = NULL;
+
+	if( !pivot->private->dispose_has_run ){
+
+		if( !pivot->private->index || pivot->private->index_generation != pivot->private->generation ){
+			fma_pivot_index_free( pivot->private->index );
+			pivot->private->index = fma_pivot_index_new( pivot->private->tree );
+			pivot->private->index_generation = pivot->private->generation;
+		}
+
+		index = pivot->private->index;
+	}
+
+	return( index );
+}
+
 /*
  * fma_pivot_load_items:
  * @pivot: this #FMAPivot instance.
@@ -571,6 +807,13 @@ fma_pivot_load_items( FMAPivot *pivot )
 		messages = NULL;
 		fma_object_free_items( pivot->private->tree );
 		pivot->private->tree = fma_io_provider_load_items( pivot, pivot->private->loadable_set, &messages );
+		pivot->private->generation += 1;
+
+		/* compile the conditions and the parameter-embedding strings
+		 * once for all
+		 */
+		fma_icontext_program_attach_tree( pivot->private->tree );
+		fma_template_compile_tree( pivot->private->tree );
 
 		for( im = messages ; im ; im = im->next ){
 			g_warning( "%s: %s", thisfn, ( const gchar * ) im->data );
@@ -602,6 +845,9 @@ fma_pivot_set_new_items( FMAPivot *pivot, GList *items )
 
 		fma_object_free_items( pivot->private->tree );
 		pivot->private->tree = items;
+		pivot->private->generation += 1;
+		fma_icontext_program_attach_tree( pivot->private->tree );
+		fma_template_compile_tree( pivot->private->tree );
 	}
 }
 
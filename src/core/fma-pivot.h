@@ -75,6 +75,7 @@
 #include <api/fma-iio-provider.h>
 #include <api/fma-object-api.h>
 
+#include "fma-pivot-index.h"
 #include "fma-settings.h"
 
 G_BEGIN_DECLS
@@ -147,6 +148,9 @@ void           fma_pivot_free_providers         ( GList *providers );
  */
 FMAObjectItem *fma_pivot_get_item               ( const FMAPivot *pivot, const gchar *id );
 GList         *fma_pivot_get_items              ( const FMAPivot *pivot );
+guint          fma_pivot_get_generation         ( const FMAPivot *pivot );
+FMAPivotIndex *fma_pivot_get_index              ( FMAPivot *pivot );
+GList         *fma_pivot_get_target_items       ( FMAPivot *pivot, guint target, const FMAObjectItem *menu );
 void           fma_pivot_load_items             ( FMAPivot *pivot );
 void           fma_pivot_set_new_items          ( FMAPivot *pivot, GList *tree );
 
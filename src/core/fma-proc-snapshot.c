@@ -0,0 +1,200 @@
+/*
+ * FileManager-Actions
+ * A file-manager extension which offers configurable context menu actions.
+ *
+ * Copyright (C) 2005 The GNOME Foundation
+ * Copyright (C) 2006-2008 Frederic Ruaudel and others (see AUTHORS)
+ * Copyright (C) 2009-2015 Pierre Wieser and others (see AUTHORS)
+ *
+ * FileManager-Actions is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * FileManager-Actions is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FileManager-Actions; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Frederic Ruaudel <grumz@grumz.net>
+ *   Rodrigo Moya <rodrigo@gnome-db.org>
+ *   Pierre Wieser <pwieser@trychlos.org>
+ *   ... and many others (see AUTHORS)
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+#include <sys/types.h>
+#include <glibtop/proclist.h>
+#include <glibtop/procstate.h>
+
+#include "fma-proc-snapshot.h"
+
+#define PROC_DIR						"/proc"
+
+static GMutex      st_mutex;
+static GHashTable *st_names = NULL;		/* the set of process names */
+static gint64      st_stamp = 0;		/* monotonic time of the snapshot */
+static gint64      st_ttl   = 0;
+
+static GHashTable *snapshot_build( void );
+static gboolean    snapshot_build_from_proc( GHashTable *names );
+static void        snapshot_build_from_gtop( GHashTable *names );
+static gchar      *read_command_name( const gchar *pid );
+
+/*
+ * fma_proc_snapshot_is_running:
+ * @name: the name of a process.
+ *
+ * Returns: %TRUE if a process of this @name was running when the current
+ * snapshot has been taken, %FALSE else.
+ *
+ * A new snapshot is taken if the current one is older than the configured
+ * time-to-live.
+ */
+gboolean
+fma_proc_snapshot_is_running( const gchar *name )
+{
+	static const gchar *thisfn = "fma_proc_snapshot_is_running";
+	gint64 now;
+	gboolean running;
+
+	g_return_val_if_fail( name && strlen( name ), FALSE );
+
+	g_mutex_lock( &st_mutex );
+
+	now = g_get_monotonic_time();
+
+	if( !st_names || now - st_stamp >= st_ttl ){
+		if( st_names ){
+			g_hash_table_destroy( st_names );
+		}
+		st_names = snapshot_build();
+		st_stamp = now;
+		g_debug( "%s: %u process names found", thisfn, g_hash_table_size( st_names ));
+	}
+
+	running = g_hash_table_contains( st_names, name );
+
+	g_mutex_unlock( &st_mutex );
+
+	return( running );
+}
+
+/*
+ * fma_proc_snapshot_set_ttl:
+ * @ttl: the time, in microseconds, during which a snapshot is reused;
+ *  zero means that a new snapshot is taken each time.
+ */
+void
+fma_proc_snapshot_set_ttl( gint64 ttl )
+{
+	g_mutex_lock( &st_mutex );
+	st_ttl = ttl;
+	g_mutex_unlock( &st_mutex );
+}
+
+static GHashTable *
+snapshot_build( void )
+{
+	GHashTable *names;
+
+	names = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, NULL );
+
+	if( !snapshot_build_from_proc( names )){
+		snapshot_build_from_gtop( names );
+	}
+
+	return( names );
+}
+
+/*
+ * the command name is the one found in /proc/<pid>/stat, i.e. the same
+ * (possibly truncated) name than the one returned by libgtop
+ */
+static gboolean
+snapshot_build_from_proc( GHashTable *names )
+{
+	GDir *dir;
+	const gchar *entry;
+	gchar *cmd;
+
+	dir = g_dir_open( PROC_DIR, 0, NULL );
+	if( !dir ){
+		return( FALSE );
+	}
+
+	while(( entry = g_dir_read_name( dir )) != NULL ){
+		if( !g_ascii_isdigit( entry[0] )){
+			continue;
+		}
+		cmd = read_command_name( entry );
+		if( cmd ){
+			g_hash_table_add( names, cmd );
+		}
+	}
+
+	g_dir_close( dir );
+
+	return( TRUE );
+}
+
+/*
+ * libgtop is not thread-safe, but it is only called with the mutex
+ * locked
+ */
+static void
+snapshot_build_from_gtop( GHashTable *names )
+{
+	glibtop_proclist proclist;
+	glibtop_proc_state procstate;
+	pid_t *pid_list;
+	guint i;
+
+	pid_list = glibtop_get_proclist( &proclist, GLIBTOP_KERN_PROC_ALL, 0 );
+
+	for( i=0 ; i<proclist.number ; ++i ){
+		glibtop_get_proc_state( &procstate, pid_list[i] );
+		g_hash_table_add( names, g_strdup( procstate.cmd ));
+	}
+
+	g_free( pid_list );
+}
+
+/*
+ * /proc/<pid>/stat is: pid (comm) state ...
+ * where comm may itself contain spaces and parentheses
+ */
+static gchar *
+read_command_name( const gchar *pid )
+{
+	gchar *fname;
+	gchar *contents;
+	gchar *begin, *end;
+	gchar *cmd;
+
+	cmd = NULL;
+	contents = NULL;
+	fname = g_build_filename( PROC_DIR, pid, "stat", NULL );
+
+	if( g_file_get_contents( fname, &contents, NULL, NULL )){
+		begin = strchr( contents, '(' );
+		end = strrchr( contents, ')' );
+		if( begin && end && end > begin ){
+			cmd = g_strndup( begin+1, end-begin-1 );
+		}
+	}
+
+	g_free( contents );
+	g_free( fname );
+
+	return( cmd );
+}
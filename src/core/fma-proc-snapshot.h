@@ -0,0 +1,59 @@
+/*
+ * FileManager-Actions
+ * A file-manager extension which offers configurable context menu actions.
+ *
+ * Copyright (C) 2005 The GNOME Foundation
+ * Copyright (C) 2006-2008 Frederic Ruaudel and others (see AUTHORS)
+ * Copyright (C) 2009-2015 Pierre Wieser and others (see AUTHORS)
+ *
+ * FileManager-Actions is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * FileManager-Actions is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FileManager-Actions; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Frederic Ruaudel <grumz@grumz.net>
+ *   Rodrigo Moya <rodrigo@gnome-db.org>
+ *   Pierre Wieser <pwieser@trychlos.org>
+ *   ... and many others (see AUTHORS)
+ */
+
+#ifndef __CORE_FMA_PROC_SNAPSHOT_H__
+#define __CORE_FMA_PROC_SNAPSHOT_H__
+
+/* @title: FMAProcSnapshot
+ * @short_description: A shared snapshot of the running processes
+ * @include: core/fma-proc-snapshot.h
+ *
+ * ShowIfRunning conditions only need to know whether a process of a
+ * given name is running. Rather than enumerating all the processes for
+ * each condition, the names of the running processes are collected once
+ * in a hash set, which is shared by all the conditions and reused during
+ * a short, configurable, time.
+ *
+ * The snapshot is built by scanning /proc when available, falling back
+ * to libgtop else.
+ *
+ * All functions are thread-safe.
+ */
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+gboolean fma_proc_snapshot_is_running( const gchar *name );
+
+void     fma_proc_snapshot_set_ttl   ( gint64 ttl );
+
+G_END_DECLS
+
+#endif /* __CORE_FMA_PROC_SNAPSHOT_H__ */
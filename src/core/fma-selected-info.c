@@ -31,11 +31,8 @@
 #include <config.h>
 #endif
 
-#include <gio/gio.h>
-#include <glib/gi18n.h>
 #include <string.h>
 
-#include "fma-gnome-vfs-uri.h"
 #include "fma-selected-info.h"
 
 /* private class data
@@ -45,24 +42,12 @@ struct _FMASelectedInfoClassPrivate {
 };
 
 /* private instance data
+ * the object is only a view on one item of a FMASelection
  */
 struct _FMASelectedInfoPrivate {
-	gboolean       dispose_has_run;
-	gchar         *uri;
-	gchar         *filename;
-	gchar         *dirname;
-	gchar         *basename;
-	gchar         *hostname;
-	gchar         *username;
-	gchar         *scheme;
-	guint          port;
-	gchar         *mimetype;
-	GFileType      file_type;
-	gboolean       can_read;
-	gboolean       can_write;
-	gboolean       can_execute;
-	gchar         *owner;
-	gboolean       attributes_are_set;
+	gboolean      dispose_has_run;
+	FMASelection *selection;
+	guint         index;
 };
 
 
@@ -74,11 +59,6 @@ static void             instance_init( GTypeInstance *instance, gpointer klass )
 static void             instance_dispose( GObject *object );
 static void             instance_finalize( GObject *object );
 
-static void             dump( const FMASelectedInfo *nsi );
-static const char      *dump_file_type( GFileType type );
-static FMASelectedInfo *new_from_uri( const gchar *uri, const gchar *mimetype, gchar **errmsg );
-static void             query_file_attributes( FMASelectedInfo *info, GFile *location, gchar **errmsg );
-
 GType
 fma_selected_info_get_type( void )
 {
@@ -149,7 +129,7 @@ instance_init( GTypeInstance *instance, gpointer klass )
 	self->private = g_new0( FMASelectedInfoPrivate, 1 );
 
 	self->private->dispose_has_run = FALSE;
-	self->private->uri = NULL;
+	self->private->selection = NULL;
 }
 
 static void
@@ -185,15 +165,7 @@ instance_finalize( GObject *object )
 
 	g_debug( "%s: object=%p (%s)", thisfn, ( void * ) object, G_OBJECT_TYPE_NAME( object ));
 
-	g_free( self->private->uri );
-	g_free( self->private->filename );
-	g_free( self->private->dirname );
-	g_free( self->private->basename );
-	g_free( self->private->hostname );
-	g_free( self->private->username );
-	g_free( self->private->scheme );
-	g_free( self->private->mimetype );
-	g_free( self->private->owner );
+	fma_selection_unref( self->private->selection );
 
 	g_free( self->private );
 
@@ -237,6 +209,52 @@ fma_selected_info_free_list( GList *files )
 	g_list_free( files );
 }
 
+/*
+ * fma_selected_info_get_selection:
+ * @files: a #GList of #FMASelectedInfo items.
+ *
+ * This is the way the #GList-based API reaches the #FMASelection-based
+ * internals.
+ *
+ * Returns: a #FMASelection whose items are the @files, in the same
+ * order, which should be fma_selection_unref() by the caller. When the
+ * @files are the views of a whole selection, this is this selection
+ * itself; else, it is a new one, which holds a copy of the items.
+ */
+FMASelection *
+fma_selected_info_get_selection( GList *files )
+{
+	FMASelection *selection;
+	FMASelectedInfoPrivate *private;
+	GList *it;
+	guint i;
+
+	selection = NULL;
+
+	for( it = files, i = 0 ; it ; it = it->next, ++i ){
+		private = FMA_SELECTED_INFO( it->data )->private;
+		if( !i ){
+			selection = private->selection;
+		}
+		if( private->selection != selection || private->index != i ){
+			break;
+		}
+	}
+
+	if( selection && !it && i == fma_selection_get_count( selection )){
+		return( fma_selection_ref( selection ));
+	}
+
+	selection = fma_selection_new();
+
+	for( it = files ; it ; it = it->next ){
+		private = FMA_SELECTED_INFO( it->data )->private;
+		fma_selection_add_copy( selection, private->selection, private->index );
+	}
+
+	return( selection );
+}
+
 /*
  * fma_selected_info_get_basename:
  * @nsi: this #FMASelectedInfo object.
@@ -256,7 +274,7 @@ fma_selected_info_get_basename( const FMASelectedInfo *nsi )
 
 	if( !nsi->private->dispose_has_run ){
 
-		basename = g_strdup( nsi->private->basename );
+		basename = g_strdup( fma_selection_peek_basename( nsi->private->selection, nsi->private->index ));
 	}
 
 	return( basename );
@@ -281,7 +299,7 @@ fma_selected_info_get_dirname( const FMASelectedInfo *nsi )
 
 	if( !nsi->private->dispose_has_run ){
 
-		dirname = g_strdup( nsi->private->dirname );
+		dirname = g_strdup( fma_selection_peek_dirname( nsi->private->selection, nsi->private->index ));
 	}
 
 	return( dirname );
@@ -305,9 +323,7 @@ fma_selected_info_get_mime_type( const FMASelectedInfo *nsi )
 
 	if( !nsi->private->dispose_has_run ){
 
-		if( nsi->private->mimetype ){
-			mimetype = g_strdup( nsi->private->mimetype );
-		}
+		mimetype = g_strdup( fma_selection_peek_mimetype( nsi->private->selection, nsi->private->index ));
 	}
 
 	return( mimetype );
@@ -331,7 +347,7 @@ fma_selected_info_get_path( const FMASelectedInfo *nsi )
 
 	if( !nsi->private->dispose_has_run ){
 
-		path = g_strdup( nsi->private->filename );
+		path = g_strdup( fma_selection_peek_filename( nsi->private->selection, nsi->private->index ));
 	}
 
 	return( path );
@@ -355,7 +371,7 @@ fma_selected_info_get_uri( const FMASelectedInfo *nsi )
 
 	if( !nsi->private->dispose_has_run ){
 
-		uri = g_strdup( nsi->private->uri );
+		uri = g_strdup( fma_selection_peek_uri( nsi->private->selection, nsi->private->index ));
 	}
 
 	return( uri );
@@ -379,7 +395,7 @@ fma_selected_info_get_uri_host( const FMASelectedInfo *nsi )
 
 	if( !nsi->private->dispose_has_run ){
 
-		host = g_strdup( nsi->private->hostname );
+		host = g_strdup( fma_selection_peek_hostname( nsi->private->selection, nsi->private->index ));
 	}
 
 	return( host );
@@ -403,7 +419,7 @@ fma_selected_info_get_uri_user( const FMASelectedInfo *nsi )
 
 	if( !nsi->private->dispose_has_run ){
 
-		user = g_strdup( nsi->private->username );
+		user = g_strdup( fma_selection_peek_username( nsi->private->selection, nsi->private->index ));
 	}
 
 	return( user );
@@ -426,7 +442,7 @@ fma_selected_info_get_uri_port( const FMASelectedInfo *nsi )
 
 	if( !nsi->private->dispose_has_run ){
 
-		port = nsi->private->port;
+		port = fma_selection_get_port( nsi->private->selection, nsi->private->index );
 	}
 
 	return( port );
@@ -450,7 +466,7 @@ fma_selected_info_get_uri_scheme( const FMASelectedInfo *nsi )
 
 	if( !nsi->private->dispose_has_run ){
 
-		scheme = g_strdup( nsi->private->scheme );
+		scheme = g_strdup( fma_selection_peek_scheme( nsi->private->selection, nsi->private->index ));
 	}
 
 	return( scheme );
@@ -473,7 +489,7 @@ fma_selected_info_is_directory( const FMASelectedInfo *nsi )
 
 	if( !nsi->private->dispose_has_run ){
 
-		is_dir = ( nsi->private->file_type == G_FILE_TYPE_DIRECTORY );
+		is_dir = ( fma_selection_get_file_type( nsi->private->selection, nsi->private->index ) == G_FILE_TYPE_DIRECTORY );
 	}
 
 	return( is_dir );
@@ -496,7 +512,7 @@ fma_selected_info_is_regular( const FMASelectedInfo *nsi )
 
 	if( !nsi->private->dispose_has_run ){
 
-		is_regular = ( nsi->private->file_type == G_FILE_TYPE_REGULAR );
+		is_regular = ( fma_selection_get_file_type( nsi->private->selection, nsi->private->index ) == G_FILE_TYPE_REGULAR );
 	}
 
 	return( is_regular );
@@ -519,7 +535,7 @@ fma_selected_info_is_executable( const FMASelectedInfo *nsi )
 
 	if( !nsi->private->dispose_has_run ){
 
-		is_exe = nsi->private->can_execute;
+		is_exe = (( fma_selection_get_access( nsi->private->selection, nsi->private->index ) & FMA_SELECTION_EXECUTABLE ) != 0 );
 	}
 
 	return( is_exe );
@@ -535,7 +551,6 @@ gboolean
 fma_selected_info_is_local( const FMASelectedInfo *nsi )
 {
 	gboolean is_local;
-	gchar *scheme;
 
 	g_return_val_if_fail( FMA_IS_SELECTED_INFO( nsi ), FALSE );
 
@@ -543,9 +558,7 @@ fma_selected_info_is_local( const FMASelectedInfo *nsi )
 
 	if( !nsi->private->dispose_has_run ){
 
-		scheme = fma_selected_info_get_uri_scheme( nsi );
-		is_local = ( strcmp( scheme, "file" ) == 0 );
-		g_free( scheme );
+		is_local = ( g_strcmp0( fma_selection_peek_scheme( nsi->private->selection, nsi->private->index ), "file" ) == 0 );
 	}
 
 	return( is_local );
@@ -569,7 +582,7 @@ fma_selected_info_is_owner( const FMASelectedInfo *nsi, const gchar *user )
 
 	if( !nsi->private->dispose_has_run ){
 
-		is_owner = ( strcmp( nsi->private->owner, user ) == 0 );
+		is_owner = ( g_strcmp0( fma_selection_peek_owner( nsi->private->selection, nsi->private->index ), user ) == 0 );
 	}
 
 	return( is_owner );
@@ -592,7 +605,7 @@ fma_selected_info_is_readable( const FMASelectedInfo *nsi )
 
 	if( !nsi->private->dispose_has_run ){
 
-		is_readable = nsi->private->can_read;
+		is_readable = (( fma_selection_get_access( nsi->private->selection, nsi->private->index ) & FMA_SELECTION_READABLE ) != 0 );
 	}
 
 	return( is_readable );
@@ -615,7 +628,7 @@ fma_selected_info_is_writable( const FMASelectedInfo *nsi )
 
 	if( !nsi->private->dispose_has_run ){
 
-		is_writable = nsi->private->can_write;
+		is_writable = (( fma_selection_get_access( nsi->private->selection, nsi->private->index ) & FMA_SELECTION_WRITABLE ) != 0 );
 	}
 
 	return( is_writable );
@@ -628,205 +641,81 @@ fma_selected_info_is_writable( const FMASelectedInfo *nsi )
  * @errmsg: a pointer to a string which will contain an error message on
  *  return.
  *
+ * All the attributes of the file are queried at once, so that an error
+ * may be reported through @errmsg.
+ *
  * Returns: a newly allocated #FMASelectedInfo object for the given @uri.
  */
 FMASelectedInfo *
 fma_selected_info_create_for_uri( const gchar *uri, const gchar *mimetype, gchar **errmsg )
 {
 	static const gchar *thisfn = "fma_selected_info_create_for_uri";
+	FMASelection *selection;
+	FMASelectedInfo *info;
+	guint index;
 
 	g_debug( "%s: uri=%s, mimetype=%s", thisfn, uri, mimetype );
 
-	FMASelectedInfo *obj = new_from_uri( uri, mimetype, errmsg );
-
-	return( obj );
-}
-
-static void
-dump( const FMASelectedInfo *nsi )
-{
-	static const gchar *thisfn = "fma_selected_info_dump";
-
-	g_debug( "%s:                uri=%s", thisfn, nsi->private->uri );
-	g_debug( "%s:           mimetype=%s", thisfn, nsi->private->mimetype );
-	g_debug( "%s:           filename=%s", thisfn, nsi->private->filename );
-	g_debug( "%s:            dirname=%s", thisfn, nsi->private->dirname );
-	g_debug( "%s:           basename=%s", thisfn, nsi->private->basename );
-	g_debug( "%s:           hostname=%s", thisfn, nsi->private->hostname );
-	g_debug( "%s:           username=%s", thisfn, nsi->private->username );
-	g_debug( "%s:             scheme=%s", thisfn, nsi->private->scheme );
-	g_debug( "%s:               port=%d", thisfn, nsi->private->port );
-	g_debug( "%s: attributes_are_set=%s", thisfn, nsi->private->attributes_are_set ? "True":"False" );
-	g_debug( "%s:          file_type=%s", thisfn, dump_file_type( nsi->private->file_type ));
-	g_debug( "%s:           can_read=%s", thisfn, nsi->private->can_read ? "True":"False" );
-	g_debug( "%s:          can_write=%s", thisfn, nsi->private->can_write ? "True":"False" );
-	g_debug( "%s:        can_execute=%s", thisfn, nsi->private->can_execute ? "True":"False" );
-	g_debug( "%s:              owner=%s", thisfn, nsi->private->owner );
-}
+	selection = fma_selection_new();
+	index = fma_selection_add_uri( selection, uri, mimetype, errmsg );
+	info = fma_selected_info_new_for_selection( selection, index );
+	fma_selection_unref( selection );
 
-static const char *
-dump_file_type( GFileType type )
-{
-	switch( type ){
-		case G_FILE_TYPE_REGULAR:
-			return( "regular" );
-		case G_FILE_TYPE_DIRECTORY:
-			return( "directory" );
-		case G_FILE_TYPE_SYMBOLIC_LINK:
-			return( "symbolic link" );
-		case G_FILE_TYPE_SPECIAL:
-			return( "special (socket, fifo, blockdev, chardev)" );
-		case G_FILE_TYPE_SHORTCUT:
-			return( "shortcut" );
-		case G_FILE_TYPE_MOUNTABLE:
-			return( "mountable" );
-		default:
-			break;
-	}
-	return( "unknown" );
+	return( info );
 }
 
 /*
- * Nautilus uses to address the desktop via the 'x-nautilus-desktop:///' URI.
- * g_filename_from_uri() complains that
- * "The URI 'x-nautilus-desktop:///' is not an absolute URI using the "file" scheme".
- * In this case, we prefer the vfs->path member wich is just a decomposition of the
- * URI, and does not try to interpret it.
- *
- * *********************************************************************************
- * Extract from RFC 2396:
- *
- * 2.4.3. Excluded US-ASCII Characters
- *
- * Although they are disallowed within the URI syntax, we include here a
- * description of those US-ASCII characters that have been excluded and
- * the reasons for their exclusion.
- *
- * The control characters in the US-ASCII coded character set are not
- * used within a URI, both because they are non-printable and because
- * they are likely to be misinterpreted by some control mechanisms.
- *
- * control = <US-ASCII coded characters 00-1F and 7F hexadecimal>
- *
- * The space character is excluded because significant spaces may
- * disappear and insignificant spaces may be introduced when URI are
- * transcribed or typeset or subjected to the treatment of word-
- * processing programs. Whitespace is also used to delimit URI in many
- * contexts.
- *
- * space = <US-ASCII coded character 20 hexadecimal>
- *
- * The angle-bracket "<" and ">" and double-quote (") characters are
- * excluded because they are often used as the delimiters around URI in
- * text documents and protocol fields. The character "#" is excluded
- * because it is used to delimit a URI from a fragment identifier in URI
- * references (Section 4). The percent character "%" is excluded because
- * it is used for the encoding of escaped characters.
- *
- * delims = "<" | ">" | "#" | "%" | <">
- *
- * Other characters are excluded because gateways and other transport
- * agents are known to sometimes modify such characters, or they are
- * used as delimiters.
- *
- * unwise = "{" | "}" | "|" | "\" | "^" | "[" | "]" | "`"
- *
- * Data corresponding to excluded characters must be escaped in order to
- * be properly represented within a URI.
+ * fma_selected_info_create_for_location:
+ * @location: the #GFile of the item.
+ * @uri: its URI.
+ * @mimetype: the corresponding mime type, or %NULL.
+ * @type: the type of the file, or %G_FILE_TYPE_UNKNOWN.
  *
- * pwi 2011-01-04:
- * It results from the above excerpt that:
- * - as double quotes are not valid character in URI, they have to be
- *   escaped as %22, and so Nautilus does
- * - but simple quotes are not forbidden, and so have not to be
- *   escaped, and so Nautilus does not escape them
+ * See fma_selection_add_location().
  *
- * As a result, we may have valid, non-escaped, simple quotes in an URI.
+ * Returns: a newly allocated #FMASelectedInfo object for the given
+ * @location.
  */
-static FMASelectedInfo *
-new_from_uri( const gchar *uri, const gchar *mimetype, gchar **errmsg )
+FMASelectedInfo *
+fma_selected_info_create_for_location( GFile *location, const gchar *uri, const gchar *mimetype, GFileType type )
 {
-	GFile *location;
-	FMAGnomeVFSURI *vfs;
+	static const gchar *thisfn = "fma_selected_info_create_for_location";
+	FMASelection *selection;
+	FMASelectedInfo *info;
+	guint index;
 
-	FMASelectedInfo *info = g_object_new( FMA_TYPE_SELECTED_INFO, NULL );
-
-	info->private->uri = g_strdup( uri );
-	if( mimetype ){
-		info->private->mimetype = g_strdup( mimetype );
-	}
+	g_return_val_if_fail( G_IS_FILE( location ), NULL );
 
-	/* pwi 2011-05-18
-	 * Filename and dirname should be taken from the GFile location, itself taken
-	 * from the URI, so that we have dir='/home/pierre/.gvfs/sftp on stormy.trychlos.org/etc'
-	 * Taking filename and dirname from URI just gives '/etc'
-	 * see #650523
-	 */
-	location = g_file_new_for_uri( uri );
-	info->private->filename = g_file_get_path( location );
-
-	vfs = g_new0( FMAGnomeVFSURI, 1 );
-	fma_gnome_vfs_uri_parse( vfs, uri );
-	if( !info->private->filename ){
-		g_debug( "fma_selected_info_new_from_uri: uri='%s', filename=NULL, setting it to '%s'", uri, vfs->path );
-		info->private->filename = g_strdup( vfs->path );
-	}
-
-	info->private->basename = g_path_get_basename( info->private->filename );
-	info->private->dirname = g_path_get_dirname( info->private->filename );
-	info->private->hostname = g_strdup( vfs->host_name );
-	info->private->username = g_strdup( vfs->user_name );
-	info->private->scheme = g_strdup( vfs->scheme );
-	info->private->port = vfs->host_port;
-	fma_gnome_vfs_uri_free( vfs );
-
-	query_file_attributes( info, location, errmsg );
-	g_object_unref( location );
+	g_debug( "%s: uri=%s, mimetype=%s", thisfn, uri, mimetype );
 
-	dump( info );
+	selection = fma_selection_new();
+	index = fma_selection_add_location( selection, location, uri, mimetype, type );
+	info = fma_selected_info_new_for_selection( selection, index );
+	fma_selection_unref( selection );
 
 	return( info );
 }
 
-static void
-query_file_attributes( FMASelectedInfo *nsi, GFile *location, gchar **errmsg )
+/*
+ * fma_selected_info_new_for_selection:
+ * @selection: a #FMASelection.
+ * @index: the index of an item of the @selection.
+ *
+ * Returns: a newly allocated #FMASelectedInfo object, which is a view on
+ * the item of the @selection. The object holds a reference on the
+ * @selection.
+ */
+FMASelectedInfo *
+fma_selected_info_new_for_selection( FMASelection *selection, guint index )
 {
-	static const gchar *thisfn = "fma_selected_info_query_file_attributes";
-	GError *error;
-
-	error = NULL;
-	GFileInfo *info = g_file_query_info( location,
-			G_FILE_ATTRIBUTE_STANDARD_TYPE
-				"," G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE
-				"," G_FILE_ATTRIBUTE_ACCESS_CAN_READ
-				"," G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE
-				"," G_FILE_ATTRIBUTE_ACCESS_CAN_EXECUTE
-				"," G_FILE_ATTRIBUTE_OWNER_USER,
-			G_FILE_QUERY_INFO_NONE, NULL, &error );
-
-	if( error ){
-		if( errmsg ){
-			*errmsg = g_strdup_printf( _( "Error when querying informations for %s URI: %s" ), nsi->private->uri, error->message );
-		} else {
-			g_warning( "%s: uri=%s, g_file_query_info: %s", thisfn, nsi->private->uri, error->message );
-		}
-		g_error_free( error );
-		return;
-	}
-
-	if( !nsi->private->mimetype ){
-		nsi->private->mimetype = g_strdup( g_file_info_get_attribute_as_string( info, G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE ));
-	}
-
-	nsi->private->file_type = ( GFileType ) g_file_info_get_attribute_uint32( info, G_FILE_ATTRIBUTE_STANDARD_TYPE );
+	FMASelectedInfo *info;
 
-	nsi->private->can_read = g_file_info_get_attribute_boolean( info, G_FILE_ATTRIBUTE_ACCESS_CAN_READ );
-	nsi->private->can_write = g_file_info_get_attribute_boolean( info, G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE );
-	nsi->private->can_execute = g_file_info_get_attribute_boolean( info, G_FILE_ATTRIBUTE_ACCESS_CAN_EXECUTE );
+	g_return_val_if_fail( selection, NULL );
+	g_return_val_if_fail( index < fma_selection_get_count( selection ), NULL );
 
-	nsi->private->owner = g_strdup( g_file_info_get_attribute_as_string( info, G_FILE_ATTRIBUTE_OWNER_USER ));
+	info = g_object_new( FMA_TYPE_SELECTED_INFO, NULL );
+	info->private->selection = fma_selection_ref( selection );
+	info->private->index = index;
 
-	nsi->private->attributes_are_set = TRUE;
-
-	g_object_unref( info );
+	return( info );
 }
@@ -38,12 +38,20 @@
  * order to gather some common properties for the selected item, mainly
  * its mime type for example.
  *
+ * The object is only a view on one item of a #FMASelection, which
+ * actually stores the data. The attributes of the file which are not
+ * provided by the file manager (type, access rights, owner) are only
+ * queried when a condition first needs them.
+ *
+ * The views are only kept for the #GList-based API: the candidate
+ * checks and the #FMATokens work on the #FMASelection itself.
+ *
  * This class should be replaced by FileManagerFileInfo class, as soon
  * as the required file manager version will have the
  * file_manager_file_info_create_for_uri() API (2.28 for Nautilus)
  */
 
-#include <glib-object.h>
+#include "fma-selection.h"
 
 G_BEGIN_DECLS
 
@@ -72,29 +80,32 @@ typedef struct {
 }
 	FMASelectedInfoClass;
 
-GType            fma_selected_info_get_type          ( void );
+GType            fma_selected_info_get_type            ( void );
 
-GList           *fma_selected_info_copy_list         ( GList *files );
-void             fma_selected_info_free_list         ( GList *files );
+GList           *fma_selected_info_copy_list           ( GList *files );
+void             fma_selected_info_free_list           ( GList *files );
+FMASelection    *fma_selected_info_get_selection       ( GList *files );
 
-gchar           *fma_selected_info_get_basename      ( const FMASelectedInfo *nsi );
-gchar           *fma_selected_info_get_dirname       ( const FMASelectedInfo *nsi );
-gchar           *fma_selected_info_get_mime_type     ( const FMASelectedInfo *nsi );
-gchar           *fma_selected_info_get_path          ( const FMASelectedInfo *nsi );
-gchar           *fma_selected_info_get_uri           ( const FMASelectedInfo *nsi );
-gchar           *fma_selected_info_get_uri_host      ( const FMASelectedInfo *nsi );
-gchar           *fma_selected_info_get_uri_user      ( const FMASelectedInfo *nsi );
-guint            fma_selected_info_get_uri_port      ( const FMASelectedInfo *nsi );
-gchar           *fma_selected_info_get_uri_scheme    ( const FMASelectedInfo *nsi );
-gboolean         fma_selected_info_is_directory      ( const FMASelectedInfo *nsi );
-gboolean         fma_selected_info_is_regular        ( const FMASelectedInfo *nsi );
-gboolean         fma_selected_info_is_executable     ( const FMASelectedInfo *nsi );
-gboolean         fma_selected_info_is_local          ( const FMASelectedInfo *nsi );
-gboolean         fma_selected_info_is_owner          ( const FMASelectedInfo *nsi, const gchar *user );
-gboolean         fma_selected_info_is_readable       ( const FMASelectedInfo *nsi );
-gboolean         fma_selected_info_is_writable       ( const FMASelectedInfo *nsi );
+gchar           *fma_selected_info_get_basename        ( const FMASelectedInfo *nsi );
+gchar           *fma_selected_info_get_dirname         ( const FMASelectedInfo *nsi );
+gchar           *fma_selected_info_get_mime_type       ( const FMASelectedInfo *nsi );
+gchar           *fma_selected_info_get_path            ( const FMASelectedInfo *nsi );
+gchar           *fma_selected_info_get_uri             ( const FMASelectedInfo *nsi );
+gchar           *fma_selected_info_get_uri_host        ( const FMASelectedInfo *nsi );
+gchar           *fma_selected_info_get_uri_user        ( const FMASelectedInfo *nsi );
+guint            fma_selected_info_get_uri_port        ( const FMASelectedInfo *nsi );
+gchar           *fma_selected_info_get_uri_scheme      ( const FMASelectedInfo *nsi );
+gboolean         fma_selected_info_is_directory        ( const FMASelectedInfo *nsi );
+gboolean         fma_selected_info_is_regular          ( const FMASelectedInfo *nsi );
+gboolean         fma_selected_info_is_executable       ( const FMASelectedInfo *nsi );
+gboolean         fma_selected_info_is_local            ( const FMASelectedInfo *nsi );
+gboolean         fma_selected_info_is_owner            ( const FMASelectedInfo *nsi, const gchar *user );
+gboolean         fma_selected_info_is_readable         ( const FMASelectedInfo *nsi );
+gboolean         fma_selected_info_is_writable         ( const FMASelectedInfo *nsi );
 
-FMASelectedInfo *fma_selected_info_create_for_uri    ( const gchar *uri, const gchar *mimetype, gchar **errmsg );
+FMASelectedInfo *fma_selected_info_create_for_uri      ( const gchar *uri, const gchar *mimetype, gchar **errmsg );
+FMASelectedInfo *fma_selected_info_create_for_location ( GFile *location, const gchar *uri, const gchar *mimetype, GFileType type );
+FMASelectedInfo *fma_selected_info_new_for_selection   ( FMASelection *selection, guint index );
 
 G_END_DECLS
 
@@ -0,0 +1,401 @@
+/*
+ * FileManager-Actions
+ * A file-manager extension which offers configurable context menu actions.
+ *
+ * Copyright (C) 2005 The GNOME Foundation
+ * Copyright (C) 2006-2008 Frederic Ruaudel and others (see AUTHORS)
+ * Copyright (C) 2009-2015 Pierre Wieser and others (see AUTHORS)
+ *
+ * FileManager-Actions is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * FileManager-Actions is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FileManager-Actions; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Frederic Ruaudel <grumz@grumz.net>
+ *   Rodrigo Moya <rodrigo@gnome-db.org>
+ *   Pierre Wieser <pwieser@trychlos.org>
+ *   ... and many others (see AUTHORS)
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+#include <unistd.h>
+
+#include "fma-selection-classes.h"
+
+/* the classes of one kind
+ */
+typedef struct {
+	gboolean    computed;
+	GArray     *representatives;		/* guint: the index of the first file of each class */
+	GHashTable *sizes;					/* representative -> count of files */
+}
+	ClassSet;
+
+struct _FMASelectionClasses {
+	FMASelection *selection;			/* reffed */
+	guint         count;
+	guint        *files;				/* the indexes of the examined files */
+	guint         examined;
+	gboolean      sampled;
+	GMutex        mutex;				/* the classes may be requested from several threads */
+	ClassSet      sets[ SELECTION_CLASS_N ];
+};
+
+static void   classes_compute( FMASelectionClasses *classes, guint kind );
+static gchar *class_key( FMASelection *selection, guint index, guint kind );
+
+/*
+ * fma_selection_classes_new:
+ * @selection: the current #FMASelection.
+ *
+ * The @selection is expected to stay unchanged as long as the returned
+ * object, which holds a reference on it.
+ *
+ * Returns: a newly allocated #FMASelectionClasses, which should be
+ * fma_selection_classes_free() by the caller.
+ */
+FMASelectionClasses *
+fma_selection_classes_new( FMASelection *selection )
+{
+	FMASelectionClasses *classes;
+	guint i;
+
+	g_return_val_if_fail( selection, NULL );
+
+	classes = g_new0( FMASelectionClasses, 1 );
+	classes->selection = fma_selection_ref( selection );
+	classes->count = fma_selection_get_count( selection );
+	classes->files = g_new( guint, classes->count );
+	classes->examined = classes->count;
+	g_mutex_init( &classes->mutex );
+
+	for( i = 0 ; i < classes->count ; ++i ){
+		classes->files[i] = i;
+	}
+
+	return( classes );
+}
+
+/*
+ * fma_selection_classes_free:
+ * @classes: this #FMASelectionClasses.
+ *
+ * Releases the @classes.
+ */
+void
+fma_selection_classes_free( FMASelectionClasses *classes )
+{
+	guint i;
+
+	if( classes ){
+		for( i = 0 ; i < SELECTION_CLASS_N ; ++i ){
+			if( classes->sets[i].representatives ){
+				g_array_free( classes->sets[i].representatives, TRUE );
+			}
+			if( classes->sets[i].sizes ){
+				g_hash_table_destroy( classes->sets[i].sizes );
+			}
+		}
+		g_free( classes->files );
+		fma_selection_unref( classes->selection );
+		g_mutex_clear( &classes->mutex );
+		g_free( classes );
+	}
+}
+
+/*
+ * fma_selection_classes_set_sample:
+ * @classes: this #FMASelectionClasses.
+ * @size: the maximum count of files to be examined.
+ *
+ * Restricts the files whose attributes are examined when computing the
+ * classes to at most @size files, evenly spread over the selection, the
+ * first and the last selected files being always part of the sample.
+ *
+ * This is expected to be called before any class has been computed.
+ *
+ * A sampled selection may so hide a class: the per-file conditions are
+ * then only checked against the sampled files, and may accept a
+ * selection which contains a file which would have otherwise been
+ * rejected; the sizes of the classes only count the sampled files. The
+ * selection count itself is kept exact.
+ */
+void
+fma_selection_classes_set_sample( FMASelectionClasses *classes, guint size )
+{
+	static const gchar *thisfn = "fma_selection_classes_set_sample";
+	guint i;
+
+	g_return_if_fail( classes );
+	g_return_if_fail( !classes->sampled );
+
+	if( size < 2 || classes->count <= size ){
+		return;
+	}
+
+	for( i = 0 ; i < size ; ++i ){
+		classes->files[i] = ( guint )(( guint64 ) i * ( classes->count - 1 ) / ( size - 1 ));
+	}
+
+	classes->examined = size;
+	classes->sampled = TRUE;
+
+	g_debug( "%s: files=%u, sample=%u", thisfn, classes->count, size );
+}
+
+/*
+ * fma_selection_classes_is_sampled:
+ * @classes: (allow-none): this #FMASelectionClasses.
+ *
+ * Returns: %TRUE if the classes are only computed from a sample of the
+ * selection.
+ */
+gboolean
+fma_selection_classes_is_sampled( const FMASelectionClasses *classes )
+{
+	return( classes && classes->sampled );
+}
+
+/*
+ * fma_selection_classes_is_for:
+ * @classes: (allow-none): this #FMASelectionClasses.
+ * @selection: a #FMASelection.
+ *
+ * Returns: %TRUE if the @classes have been built from this @selection.
+ */
+gboolean
+fma_selection_classes_is_for( const FMASelectionClasses *classes, const FMASelection *selection )
+{
+	return( classes && classes->selection == selection );
+}
+
+/*
+ * fma_selection_classes_get_selection:
+ * @classes: this #FMASelectionClasses.
+ *
+ * Returns: the #FMASelection the @classes have been built from, owned by
+ * the @classes.
+ */
+FMASelection *
+fma_selection_classes_get_selection( const FMASelectionClasses *classes )
+{
+	g_return_val_if_fail( classes, NULL );
+
+	return( classes->selection );
+}
+
+/*
+ * fma_selection_classes_get_count:
+ * @classes: this #FMASelectionClasses.
+ *
+ * Returns: the count of files in the selection.
+ */
+guint
+fma_selection_classes_get_count( const FMASelectionClasses *classes )
+{
+	g_return_val_if_fail( classes, 0 );
+
+	return( classes->count );
+}
+
+/*
+ * fma_selection_classes_get_files:
+ * @classes: this #FMASelectionClasses.
+ * @count: [out]: the count of returned indexes.
+ *
+ * Returns: the indexes of the files which are to be examined by the
+ * per-file conditions which cannot be checked per class, i.e. either
+ * the sample or the whole selection. The returned array is owned by the
+ * @classes, and should not be released.
+ */
+const guint *
+fma_selection_classes_get_files( const FMASelectionClasses *classes, guint *count )
+{
+	g_return_val_if_fail( classes, NULL );
+	g_return_val_if_fail( count, NULL );
+
+	*count = classes->examined;
+
+	return( classes->files );
+}
+
+/*
+ * fma_selection_classes_get:
+ * @classes: this #FMASelectionClasses.
+ * @kind: the kind of the classes.
+ * @count: [out]: the count of classes.
+ *
+ * Returns: the indexes of the representatives of the classes of this
+ * @kind, in the order of the selection. The returned array is owned by
+ * the @classes, and should not be released.
+ */
+const guint *
+fma_selection_classes_get( FMASelectionClasses *classes, guint kind, guint *count )
+{
+	g_return_val_if_fail( classes, NULL );
+	g_return_val_if_fail( kind < SELECTION_CLASS_N, NULL );
+	g_return_val_if_fail( count, NULL );
+
+	g_mutex_lock( &classes->mutex );
+	if( !classes->sets[kind].computed ){
+		classes_compute( classes, kind );
+	}
+	g_mutex_unlock( &classes->mutex );
+
+	*count = classes->sets[kind].representatives->len;
+
+	return(( const guint * ) classes->sets[kind].representatives->data );
+}
+
+/*
+ * fma_selection_classes_get_size:
+ * @classes: this #FMASelectionClasses.
+ * @kind: the kind of the classes.
+ * @representative: the index of the representative of a class of this
+ *  @kind.
+ *
+ * Returns: the count of files of the class.
+ */
+guint
+fma_selection_classes_get_size( FMASelectionClasses *classes, guint kind, guint representative )
+{
+	g_return_val_if_fail( classes, 0 );
+	g_return_val_if_fail( kind < SELECTION_CLASS_N, 0 );
+
+	g_mutex_lock( &classes->mutex );
+	if( !classes->sets[kind].computed ){
+		classes_compute( classes, kind );
+	}
+	g_mutex_unlock( &classes->mutex );
+
+	return( GPOINTER_TO_UINT( g_hash_table_lookup( classes->sets[kind].sizes, GUINT_TO_POINTER( representative ))));
+}
+
+/*
+ * fma_selection_classes_capabilities:
+ * @selection: a #FMASelection.
+ * @index: the index of an item of the @selection.
+ * @mask: the capabilities to be checked.
+ *
+ * Returns: the capabilities of the item, restricted to the @mask.
+ */
+guint
+fma_selection_classes_capabilities( FMASelection *selection, guint index, guint mask )
+{
+	const gchar *user;
+	guint access;
+	guint caps;
+
+	caps = 0;
+
+	if( mask & SELECTION_CAP_OWNER ){
+		user = getlogin();
+		caps |= ( user && !g_strcmp0( fma_selection_peek_owner( selection, index ), user )) ? SELECTION_CAP_OWNER : 0;
+	}
+	if( mask & ( SELECTION_CAP_READABLE | SELECTION_CAP_WRITABLE | SELECTION_CAP_EXECUTABLE )){
+		access = fma_selection_get_access( selection, index );
+		caps |= ( access & FMA_SELECTION_READABLE ) ? SELECTION_CAP_READABLE : 0;
+		caps |= ( access & FMA_SELECTION_WRITABLE ) ? SELECTION_CAP_WRITABLE : 0;
+		caps |= ( access & FMA_SELECTION_EXECUTABLE ) ? SELECTION_CAP_EXECUTABLE : 0;
+		caps &= mask;
+	}
+	if( mask & SELECTION_CAP_LOCAL ){
+		caps |= !g_strcmp0( fma_selection_peek_scheme( selection, index ), "file" ) ? SELECTION_CAP_LOCAL : 0;
+	}
+
+	return( caps );
+}
+
+static void
+classes_compute( FMASelectionClasses *classes, guint kind )
+{
+	static const gchar *thisfn = "fma_selection_classes_compute";
+	ClassSet *set;
+	GHashTable *keys;
+	gpointer representative;
+	gchar *key;
+	guint i;
+
+	set = &classes->sets[kind];
+	set->representatives = g_array_new( FALSE, FALSE, sizeof( guint ));
+	set->sizes = g_hash_table_new( g_direct_hash, g_direct_equal );
+
+	/* rather than having each file stat'ed in turn
+	 */
+	if( kind == SELECTION_CLASS_MIMETYPE ){
+		fma_selection_fetch( classes->selection, classes->files, classes->examined, FMA_SELECTION_FETCH_TYPE );
+
+	} else if( kind == SELECTION_CLASS_CAPABILITIES ){
+		fma_selection_fetch( classes->selection, classes->files, classes->examined, FMA_SELECTION_FETCH_ACCESS | FMA_SELECTION_FETCH_OWNER );
+	}
+
+	keys = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, NULL );
+
+	for( i = 0 ; i < classes->examined ; ++i ){
+		key = class_key( classes->selection, classes->files[i], kind );
+
+		if( g_hash_table_lookup_extended( keys, key, NULL, &representative )){
+			g_free( key );
+
+		} else {
+			representative = GUINT_TO_POINTER( classes->files[i] );
+			g_hash_table_insert( keys, key, representative );
+			g_array_append_val( set->representatives, classes->files[i] );
+		}
+
+		g_hash_table_insert( set->sizes, representative,
+				GUINT_TO_POINTER( GPOINTER_TO_UINT( g_hash_table_lookup( set->sizes, representative )) + 1 ));
+	}
+
+	set->computed = TRUE;
+
+	g_debug( "%s: kind=%u, files=%u, examined=%u, classes=%u",
+			thisfn, kind, classes->count, classes->examined, g_hash_table_size( keys ));
+
+	g_hash_table_destroy( keys );
+}
+
+static gchar *
+class_key( FMASelection *selection, guint index, guint kind )
+{
+	const gchar *value;
+	gchar *key;
+
+	switch( kind ){
+		case SELECTION_CLASS_MIMETYPE:
+			value = fma_selection_peek_mimetype( selection, index );
+			key = g_strdup_printf( "%s%s",
+					fma_selection_get_file_type( selection, index ) == G_FILE_TYPE_REGULAR ? "r:" : "-:", value ? value : "" );
+			break;
+
+		case SELECTION_CLASS_DIRNAME:
+			value = fma_selection_peek_dirname( selection, index );
+			key = g_strdup( value ? value : "" );
+			break;
+
+		case SELECTION_CLASS_CAPABILITIES:
+			key = g_strdup_printf( "%u", fma_selection_classes_capabilities( selection, index, SELECTION_CAP_ALL ));
+			break;
+
+		default:
+			value = fma_selection_peek_scheme( selection, index );
+			key = g_strdup( value ? value : "" );
+			break;
+	}
+
+	return( key );
+}
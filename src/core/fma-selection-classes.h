@@ -0,0 +1,101 @@
+/*
+ * FileManager-Actions
+ * A file-manager extension which offers configurable context menu actions.
+ *
+ * Copyright (C) 2005 The GNOME Foundation
+ * Copyright (C) 2006-2008 Frederic Ruaudel and others (see AUTHORS)
+ * Copyright (C) 2009-2015 Pierre Wieser and others (see AUTHORS)
+ *
+ * FileManager-Actions is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * FileManager-Actions is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FileManager-Actions; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Frederic Ruaudel <grumz@grumz.net>
+ *   Rodrigo Moya <rodrigo@gnome-db.org>
+ *   Pierre Wieser <pwieser@trychlos.org>
+ *   ... and many others (see AUTHORS)
+ */
+
+#ifndef __CORE_FMA_SELECTION_CLASSES_H__
+#define __CORE_FMA_SELECTION_CLASSES_H__
+
+/* @title: FMASelectionClasses
+ * @short_description: The equivalence classes of a selection
+ * @include: core/fma-selection-classes.h
+ *
+ * Most of the per-file conditions only depend on one characteristic of
+ * the selected files: the mimetype (and whether the file is a regular
+ * one), the dirname, the capabilities or the scheme. A large selection
+ * usually only has a few distinct values of each of them.
+ *
+ * The selection is so split, once per menu request, into equivalence
+ * classes for each of these kinds. Each class is represented by the
+ * index of the first item of the #FMASelection found with its value,
+ * and counts the files which share it. A per-file condition of a given kind then only has
+ * to be checked against the representatives of the classes of this
+ * kind.
+ *
+ * The classes of a kind are only computed when first requested, so
+ * that the attributes of the files are not queried if no condition
+ * depends on them.
+ *
+ * For very large selections, the classes may be computed from an evenly
+ * spread sample of the files rather than from all of them.
+ */
+
+#include <core/fma-selection.h>
+
+G_BEGIN_DECLS
+
+/* the kinds of equivalence classes
+ */
+enum {
+	SELECTION_CLASS_MIMETYPE = 0,		/* the mimetype and is_regular */
+	SELECTION_CLASS_DIRNAME,
+	SELECTION_CLASS_CAPABILITIES,
+	SELECTION_CLASS_SCHEME,
+	SELECTION_CLASS_N
+};
+
+/* the capabilities bits of a selected file
+ */
+enum {
+	SELECTION_CAP_OWNER      = 1 << 0,
+	SELECTION_CAP_READABLE   = 1 << 1,
+	SELECTION_CAP_WRITABLE   = 1 << 2,
+	SELECTION_CAP_EXECUTABLE = 1 << 3,
+	SELECTION_CAP_LOCAL      = 1 << 4,
+	SELECTION_CAP_ALL        = ( 1 << 5 ) - 1
+};
+
+typedef struct _FMASelectionClasses FMASelectionClasses;
+
+FMASelectionClasses *fma_selection_classes_new          ( FMASelection *selection );
+void                 fma_selection_classes_free         ( FMASelectionClasses *classes );
+
+void                 fma_selection_classes_set_sample   ( FMASelectionClasses *classes, guint size );
+gboolean             fma_selection_classes_is_sampled   ( const FMASelectionClasses *classes );
+
+gboolean             fma_selection_classes_is_for       ( const FMASelectionClasses *classes, const FMASelection *selection );
+FMASelection        *fma_selection_classes_get_selection( const FMASelectionClasses *classes );
+guint                fma_selection_classes_get_count    ( const FMASelectionClasses *classes );
+const guint         *fma_selection_classes_get_files    ( const FMASelectionClasses *classes, guint *count );
+const guint         *fma_selection_classes_get          ( FMASelectionClasses *classes, guint kind, guint *count );
+guint                fma_selection_classes_get_size     ( FMASelectionClasses *classes, guint kind, guint representative );
+
+guint                fma_selection_classes_capabilities ( FMASelection *selection, guint index, guint mask );
+
+G_END_DECLS
+
+#endif /* __CORE_FMA_SELECTION_CLASSES_H__ */
@@ -0,0 +1,1036 @@
+/*
+ * FileManager-Actions
+ * A file-manager extension which offers configurable context menu actions.
+ *
+ * Copyright (C) 2005 The GNOME Foundation
+ * Copyright (C) 2006-2008 Frederic Ruaudel and others (see AUTHORS)
+ * Copyright (C) 2009-2015 Pierre Wieser and others (see AUTHORS)
+ *
+ * FileManager-Actions is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * FileManager-Actions is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FileManager-Actions; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Frederic Ruaudel <grumz@grumz.net>
+ *   Rodrigo Moya <rodrigo@gnome-db.org>
+ *   Pierre Wieser <pwieser@trychlos.org>
+ *   ... and many others (see AUTHORS)
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <fcntl.h>
+#include <glib/gi18n.h>
+#include <pwd.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "fma-gnome-vfs-uri.h"
+#include "fma-selected-info.h"
+#include "fma-selection.h"
+
+/* the bits of the flags of an item: which groups of attributes are
+ * set, and the access rights
+ */
+enum {
+	FLAG_TYPE        = 1 << 0,
+	FLAG_MIMETYPE    = 1 << 1,
+	FLAG_ACCESS      = 1 << 2,
+	FLAG_OWNER       = 1 << 3,
+	FLAG_READABLE    = 1 << 4,
+	FLAG_WRITABLE    = 1 << 5,
+	FLAG_EXECUTABLE  = 1 << 6
+};
+
+#define FLAGS_ATTRIBUTES				( FLAG_TYPE | FLAG_MIMETYPE | FLAG_ACCESS | FLAG_OWNER )
+
+/* all strings are pointers into the arena
+ */
+struct _FMASelection {
+	gint          ref_count;
+	GMutex        mutex;				/* protects the data computed on demand */
+	GStringChunk *arena;
+	guint         count;
+	GPtrArray    *uris;
+	GPtrArray    *filenames;
+	GPtrArray    *basenames;
+	GPtrArray    *basenames_utf8;		/* computed on demand */
+	GPtrArray    *basenames_folded;		/* computed on demand */
+	GPtrArray    *dirnames;				/* interned */
+	GHashTable   *dirnames_utf8;		/* interned dirname -> UTF-8, computed on demand */
+	GPtrArray    *hostnames;			/* interned */
+	GPtrArray    *usernames;			/* interned */
+	GPtrArray    *schemes;				/* interned */
+	GPtrArray    *mimetypes;			/* interned, queried on demand */
+	GPtrArray    *owners;				/* interned, queried on demand */
+	GArray       *ports;				/* guint */
+	GArray       *types;				/* guint8: GFileType, queried on demand */
+	GArray       *flags;				/* guint8 */
+};
+
+#define STRING_AT( array, i )			(( const gchar * ) g_ptr_array_index(( array ), ( i )))
+#define FLAGS_AT( selection, i )		g_array_index(( selection )->flags, guint8, ( i ))
+
+static guint        add_item( FMASelection *selection, const gchar *uri, const gchar *filename, const gchar *mimetype, GFileType type );
+static const gchar *intern( FMASelection *selection, const gchar *str );
+static void         dump( const FMASelection *selection, guint index );
+static void         ensure_attributes( FMASelection *selection, guint index, guint wanted, gchar **errmsg );
+static GFileInfo   *query_file_attributes( const FMASelection *selection, guint index, guint groups, gchar **errmsg );
+static void         set_file_attributes( FMASelection *selection, guint index, guint groups, GFileInfo *info );
+#if defined( HAVE_FSTATAT ) && defined( HAVE_FACCESSAT )
+static void         fetch_directory( FMASelection *selection, const gchar *dirname, GArray *indexes, guint wanted, GHashTable *owners );
+static const gchar *fetch_owner( FMASelection *selection, GHashTable *owners, uid_t uid );
+static GFileType    fetch_file_type( mode_t mode );
+#endif
+
+/*
+ * fma_selection_new:
+ *
+ * Returns: a new empty #FMASelection, to be fma_selection_unref() by the
+ * caller.
+ */
+FMASelection *
+fma_selection_new( void )
+{
+	FMASelection *selection;
+
+	selection = g_new0( FMASelection, 1 );
+	selection->ref_count = 1;
+	g_mutex_init( &selection->mutex );
+	selection->arena = g_string_chunk_new( 4096 );
+	selection->uris = g_ptr_array_new();
+	selection->filenames = g_ptr_array_new();
+	selection->basenames = g_ptr_array_new();
+	selection->basenames_utf8 = g_ptr_array_new();
+	selection->basenames_folded = g_ptr_array_new();
+	selection->dirnames = g_ptr_array_new();
+	selection->dirnames_utf8 = g_hash_table_new( g_direct_hash, g_direct_equal );
+	selection->hostnames = g_ptr_array_new();
+	selection->usernames = g_ptr_array_new();
+	selection->schemes = g_ptr_array_new();
+	selection->mimetypes = g_ptr_array_new();
+	selection->owners = g_ptr_array_new();
+	selection->ports = g_array_new( FALSE, FALSE, sizeof( guint ));
+	selection->types = g_array_new( FALSE, FALSE, sizeof( guint8 ));
+	selection->flags = g_array_new( FALSE, FALSE, sizeof( guint8 ));
+
+	return( selection );
+}
+
+/*
+ * fma_selection_ref:
+ * @selection: this #FMASelection.
+ *
+ * Returns: the @selection, with one more reference.
+ */
+FMASelection *
+fma_selection_ref( FMASelection *selection )
+{
+	g_return_val_if_fail( selection, NULL );
+
+	g_atomic_int_inc( &selection->ref_count );
+
+	return( selection );
+}
+
+/*
+ * fma_selection_unref:
+ * @selection: this #FMASelection.
+ *
+ * Releases a reference on the @selection, freeing it when this was the
+ * last one.
+ */
+void
+fma_selection_unref( FMASelection *selection )
+{
+	if( selection && g_atomic_int_dec_and_test( &selection->ref_count )){
+		g_ptr_array_free( selection->uris, TRUE );
+		g_ptr_array_free( selection->filenames, TRUE );
+		g_ptr_array_free( selection->basenames, TRUE );
+		g_ptr_array_free( selection->basenames_utf8, TRUE );
+		g_ptr_array_free( selection->basenames_folded, TRUE );
+		g_ptr_array_free( selection->dirnames, TRUE );
+		g_hash_table_destroy( selection->dirnames_utf8 );
+		g_ptr_array_free( selection->hostnames, TRUE );
+		g_ptr_array_free( selection->usernames, TRUE );
+		g_ptr_array_free( selection->schemes, TRUE );
+		g_ptr_array_free( selection->mimetypes, TRUE );
+		g_ptr_array_free( selection->owners, TRUE );
+		g_array_free( selection->ports, TRUE );
+		g_array_free( selection->types, TRUE );
+		g_array_free( selection->flags, TRUE );
+		g_string_chunk_free( selection->arena );
+		g_mutex_clear( &selection->mutex );
+		g_free( selection );
+	}
+}
+
+/*
+ * fma_selection_add_location:
+ * @selection: this #FMASelection.
+ * @location: the #GFile of the item.
+ * @uri: its URI.
+ * @mimetype: the corresponding mime type, or %NULL.
+ * @type: the type of the file, or %G_FILE_TYPE_UNKNOWN.
+ *
+ * Appends an item the file manager already knows about: the attributes
+ * it has provided are kept as is, and the other ones are only queried
+ * if a condition actually needs them.
+ *
+ * The items are expected to be added before the @selection be shared
+ * between threads.
+ *
+ * Returns: the index of the new item.
+ */
+guint
+fma_selection_add_location( FMASelection *selection, GFile *location, const gchar *uri, const gchar *mimetype, GFileType type )
+{
+	gchar *filename;
+	guint index;
+
+	g_return_val_if_fail( selection, 0 );
+	g_return_val_if_fail( G_IS_FILE( location ), 0 );
+
+	/* pwi 2011-05-18
+	 * Filename and dirname should be taken from the GFile location, itself taken
+	 * from the URI, so that we have dir='/home/pierre/.gvfs/sftp on stormy.trychlos.org/etc'
+	 * Taking filename and dirname from URI just gives '/etc'
+	 * see #650523
+	 */
+	filename = g_file_get_path( location );
+	index = add_item( selection, uri, filename, mimetype, type );
+	g_free( filename );
+
+	return( index );
+}
+
+/*
+ * fma_selection_add_uri:
+ * @selection: this #FMASelection.
+ * @uri: an URI.
+ * @mimetype: the corresponding mime type, or %NULL.
+ * @errmsg: a pointer to a string which will contain an error message on
+ *  return.
+ *
+ * Appends an item only known by its @uri. All the attributes of the
+ * file are queried at once, so that an error may be reported through
+ * @errmsg.
+ *
+ * Returns: the index of the new item.
+ */
+guint
+fma_selection_add_uri( FMASelection *selection, const gchar *uri, const gchar *mimetype, gchar **errmsg )
+{
+	GFile *location;
+	guint index;
+
+	g_return_val_if_fail( selection, 0 );
+
+	location = g_file_new_for_uri( uri );
+	index = fma_selection_add_location( selection, location, uri, mimetype, G_FILE_TYPE_UNKNOWN );
+	g_object_unref( location );
+
+	ensure_attributes( selection, index, FLAGS_ATTRIBUTES, errmsg );
+
+	return( index );
+}
+
+/*
+ * fma_selection_add_copy:
+ * @selection: this #FMASelection.
+ * @source: another #FMASelection.
+ * @index: the index of an item of the @source.
+ *
+ * Appends a copy of an item of another selection, along with the
+ * attributes which have already been queried for it.
+ *
+ * Returns: the index of the new item.
+ */
+guint
+fma_selection_add_copy( FMASelection *selection, FMASelection *source, guint index )
+{
+	guint copy;
+
+	g_return_val_if_fail( selection && source && selection != source, 0 );
+	g_return_val_if_fail( index < source->count, 0 );
+
+	g_mutex_lock( &source->mutex );
+
+	copy = add_item( selection,
+			STRING_AT( source->uris, index ),
+			STRING_AT( source->filenames, index ),
+			STRING_AT( source->mimetypes, index ),
+			( GFileType ) g_array_index( source->types, guint8, index ));
+
+	g_ptr_array_index( selection->owners, copy ) = ( gpointer ) intern( selection, STRING_AT( source->owners, index ));
+	FLAGS_AT( selection, copy ) = FLAGS_AT( source, index );
+
+	g_mutex_unlock( &source->mutex );
+
+	return( copy );
+}
+
+/*
+ * fma_selection_get_count:
+ * @selection: this #FMASelection.
+ *
+ * Returns: the count of items in the @selection.
+ */
+guint
+fma_selection_get_count( const FMASelection *selection )
+{
+	g_return_val_if_fail( selection, 0 );
+
+	return( selection->count );
+}
+
+/*
+ * fma_selection_get_list:
+ * @selection: this #FMASelection.
+ *
+ * Returns: a #GList of #FMASelectedInfo views, one per item of the
+ * @selection, to be fma_selected_info_free_list() by the caller. Each
+ * view holds a reference on the @selection.
+ */
+GList *
+fma_selection_get_list( FMASelection *selection )
+{
+	GList *list;
+	guint i;
+
+	g_return_val_if_fail( selection, NULL );
+
+	list = NULL;
+
+	for( i = selection->count ; i > 0 ; --i ){
+		list = g_list_prepend( list, fma_selected_info_new_for_selection( selection, i-1 ));
+	}
+
+	return( list );
+}
+
+/*
+ * fma_selection_fetch:
+ * @selection: this #FMASelection.
+ * @indexes: the indexes of the items to be fetched.
+ * @count: the count of @indexes.
+ * @groups: the groups of attributes to be fetched, as a combination of
+ *  FMA_SELECTION_FETCH_TYPE, FMA_SELECTION_FETCH_ACCESS and
+ *  FMA_SELECTION_FETCH_OWNER.
+ *
+ * Sets the requested attributes of the requested local items which do
+ * not have them yet.
+ *
+ * The files are grouped by directory, and are stat'ed relatively to a
+ * single descriptor of this directory, instead of going through a
+ * g_file_query_info() call for each of them. The remote files, and the
+ * ones which cannot be stat'ed this way, are left to be queried on
+ * demand. The mimetype is never fetched here, as guessing it may need
+ * to read the file.
+ */
+void
+fma_selection_fetch( FMASelection *selection, const guint *indexes, guint count, guint groups )
+{
+#if defined( HAVE_FSTATAT ) && defined( HAVE_FACCESSAT )
+	static const gchar *thisfn = "fma_selection_fetch";
+	GHashTable *dirs, *owners;
+	GHashTableIter iter;
+	gpointer dirname, dir_indexes;
+	guint8 wanted;
+	guint i, index;
+
+	g_return_if_fail( selection );
+	g_return_if_fail( indexes || !count );
+
+	wanted =
+			( groups & FMA_SELECTION_FETCH_TYPE ? FLAG_TYPE : 0 ) |
+			( groups & FMA_SELECTION_FETCH_ACCESS ? FLAG_ACCESS : 0 ) |
+			( groups & FMA_SELECTION_FETCH_OWNER ? FLAG_OWNER : 0 );
+
+	if( !wanted || !count ){
+		return;
+	}
+
+	dirs = g_hash_table_new_full( g_direct_hash, g_direct_equal, NULL, ( GDestroyNotify ) g_array_unref );
+
+	g_mutex_lock( &selection->mutex );
+
+	for( i = 0 ; i < count ; ++i ){
+		index = indexes[i];
+
+		if( index < selection->count &&
+				( FLAGS_AT( selection, index ) & wanted ) != wanted &&
+				!g_strcmp0( STRING_AT( selection->schemes, index ), "file" )){
+
+			/* the dirnames are interned */
+			dirname = ( gpointer ) STRING_AT( selection->dirnames, index );
+			dir_indexes = g_hash_table_lookup( dirs, dirname );
+			if( !dir_indexes ){
+				dir_indexes = g_array_new( FALSE, FALSE, sizeof( guint ));
+				g_hash_table_insert( dirs, dirname, dir_indexes );
+			}
+			g_array_append_val(( GArray * ) dir_indexes, index );
+		}
+	}
+
+	if( g_hash_table_size( dirs )){
+		g_debug( "%s: fetching %u directories, wanted=%u", thisfn, g_hash_table_size( dirs ), ( guint ) wanted );
+		owners = g_hash_table_new( g_direct_hash, g_direct_equal );
+
+		g_hash_table_iter_init( &iter, dirs );
+		while( g_hash_table_iter_next( &iter, &dirname, &dir_indexes )){
+			fetch_directory( selection, ( const gchar * ) dirname, ( GArray * ) dir_indexes, wanted, owners );
+		}
+
+		g_hash_table_destroy( owners );
+	}
+
+	g_mutex_unlock( &selection->mutex );
+
+	g_hash_table_destroy( dirs );
+#endif
+}
+
+/*
+ * fma_selection_peek_uri:
+ * @selection: this #FMASelection.
+ * @index: the index of the item.
+ *
+ * Returns: the URI of the item, owned by the @selection.
+ */
+const gchar *
+fma_selection_peek_uri( const FMASelection *selection, guint index )
+{
+	g_return_val_if_fail( selection && index < selection->count, NULL );
+
+	return( STRING_AT( selection->uris, index ));
+}
+
+/*
+ * fma_selection_peek_filename:
+ * @selection: this #FMASelection.
+ * @index: the index of the item.
+ *
+ * Returns: the filename of the item, owned by the @selection.
+ */
+const gchar *
+fma_selection_peek_filename( const FMASelection *selection, guint index )
+{
+	g_return_val_if_fail( selection && index < selection->count, NULL );
+
+	return( STRING_AT( selection->filenames, index ));
+}
+
+/*
+ * fma_selection_peek_basename:
+ * @selection: this #FMASelection.
+ * @index: the index of the item.
+ *
+ * Returns: the basename of the item, in the filename encoding, owned by
+ * the @selection.
+ */
+const gchar *
+fma_selection_peek_basename( const FMASelection *selection, guint index )
+{
+	g_return_val_if_fail( selection && index < selection->count, NULL );
+
+	return( STRING_AT( selection->basenames, index ));
+}
+
+/*
+ * fma_selection_peek_basename_utf8:
+ * @selection: this #FMASelection.
+ * @index: the index of the item.
+ * @casefold: whether the basename should be lowercased.
+ *
+ * The UTF-8 conversion, and the lowercasing, are only computed once.
+ *
+ * Returns: the basename of the item, converted to UTF-8, or %NULL if it
+ * cannot be converted. The returned string is owned by the @selection.
+ */
+const gchar *
+fma_selection_peek_basename_utf8( FMASelection *selection, guint index, gboolean casefold )
+{
+	const gchar *utf8, *folded;
+	gchar *str;
+
+	g_return_val_if_fail( selection && index < selection->count, NULL );
+
+	g_mutex_lock( &selection->mutex );
+
+	utf8 = STRING_AT( selection->basenames_utf8, index );
+	if( !utf8 ){
+		str = g_filename_to_utf8( STRING_AT( selection->basenames, index ), -1, NULL, NULL, NULL );
+		if( str ){
+			utf8 = g_string_chunk_insert( selection->arena, str );
+			g_ptr_array_index( selection->basenames_utf8, index ) = ( gpointer ) utf8;
+			g_free( str );
+		}
+	}
+
+	folded = STRING_AT( selection->basenames_folded, index );
+	if( casefold && !folded && utf8 ){
+		str = g_utf8_strdown( utf8, -1 );
+		folded = g_string_chunk_insert( selection->arena, str );
+		g_ptr_array_index( selection->basenames_folded, index ) = ( gpointer ) folded;
+		g_free( str );
+	}
+
+	g_mutex_unlock( &selection->mutex );
+
+	return( casefold ? folded : utf8 );
+}
+
+/*
+ * fma_selection_peek_dirname:
+ * @selection: this #FMASelection.
+ * @index: the index of the item.
+ *
+ * Returns: the dirname of the item, owned by the @selection.
+ */
+const gchar *
+fma_selection_peek_dirname( const FMASelection *selection, guint index )
+{
+	g_return_val_if_fail( selection && index < selection->count, NULL );
+
+	return( STRING_AT( selection->dirnames, index ));
+}
+
+/*
+ * fma_selection_peek_dirname_utf8:
+ * @selection: this #FMASelection.
+ * @index: the index of the item.
+ *
+ * The UTF-8 conversion is only computed once per distinct dirname.
+ *
+ * Returns: the dirname of the item, converted to UTF-8, or %NULL if it
+ * cannot be converted. The returned string is owned by the @selection.
+ */
+const gchar *
+fma_selection_peek_dirname_utf8( FMASelection *selection, guint index )
+{
+	const gchar *dirname;
+	gpointer utf8;
+	gchar *str;
+
+	g_return_val_if_fail( selection && index < selection->count, NULL );
+
+	dirname = STRING_AT( selection->dirnames, index );
+	if( !dirname ){
+		return( NULL );
+	}
+
+	g_mutex_lock( &selection->mutex );
+
+	if( !g_hash_table_lookup_extended( selection->dirnames_utf8, dirname, NULL, &utf8 )){
+		str = g_filename_to_utf8( dirname, -1, NULL, NULL, NULL );
+		utf8 = str ? ( gpointer ) g_string_chunk_insert( selection->arena, str ) : NULL;
+		g_hash_table_insert( selection->dirnames_utf8, ( gpointer ) dirname, utf8 );
+		g_free( str );
+	}
+
+	g_mutex_unlock( &selection->mutex );
+
+	return(( const gchar * ) utf8 );
+}
+
+/*
+ * fma_selection_peek_hostname:
+ * @selection: this #FMASelection.
+ * @index: the index of the item.
+ *
+ * Returns: the host of the URI of the item, owned by the @selection.
+ */
+const gchar *
+fma_selection_peek_hostname( const FMASelection *selection, guint index )
+{
+	g_return_val_if_fail( selection && index < selection->count, NULL );
+
+	return( STRING_AT( selection->hostnames, index ));
+}
+
+/*
+ * fma_selection_peek_username:
+ * @selection: this #FMASelection.
+ * @index: the index of the item.
+ *
+ * Returns: the user of the URI of the item, owned by the @selection.
+ */
+const gchar *
+fma_selection_peek_username( const FMASelection *selection, guint index )
+{
+	g_return_val_if_fail( selection && index < selection->count, NULL );
+
+	return( STRING_AT( selection->usernames, index ));
+}
+
+/*
+ * fma_selection_peek_scheme:
+ * @selection: this #FMASelection.
+ * @index: the index of the item.
+ *
+ * Returns: the scheme of the URI of the item, owned by the @selection.
+ */
+const gchar *
+fma_selection_peek_scheme( const FMASelection *selection, guint index )
+{
+	g_return_val_if_fail( selection && index < selection->count, NULL );
+
+	return( STRING_AT( selection->schemes, index ));
+}
+
+/*
+ * fma_selection_get_port:
+ * @selection: this #FMASelection.
+ * @index: the index of the item.
+ *
+ * Returns: the port of the URI of the item.
+ */
+guint
+fma_selection_get_port( const FMASelection *selection, guint index )
+{
+	g_return_val_if_fail( selection && index < selection->count, 0 );
+
+	return( g_array_index( selection->ports, guint, index ));
+}
+
+/*
+ * fma_selection_peek_mimetype:
+ * @selection: this #FMASelection.
+ * @index: the index of the item.
+ *
+ * Returns: the mimetype of the item, owned by the @selection.
+ */
+const gchar *
+fma_selection_peek_mimetype( FMASelection *selection, guint index )
+{
+	g_return_val_if_fail( selection && index < selection->count, NULL );
+
+	ensure_attributes( selection, index, FLAG_MIMETYPE, NULL );
+
+	return( STRING_AT( selection->mimetypes, index ));
+}
+
+/*
+ * fma_selection_get_file_type:
+ * @selection: this #FMASelection.
+ * @index: the index of the item.
+ *
+ * Returns: the type of the item.
+ */
+GFileType
+fma_selection_get_file_type( FMASelection *selection, guint index )
+{
+	g_return_val_if_fail( selection && index < selection->count, G_FILE_TYPE_UNKNOWN );
+
+	ensure_attributes( selection, index, FLAG_TYPE, NULL );
+
+	return(( GFileType ) g_array_index( selection->types, guint8, index ));
+}
+
+/*
+ * fma_selection_get_access:
+ * @selection: this #FMASelection.
+ * @index: the index of the item.
+ *
+ * Returns: the access rights of the user on the item, as a combination
+ * of FMA_SELECTION_READABLE, FMA_SELECTION_WRITABLE and
+ * FMA_SELECTION_EXECUTABLE.
+ */
+guint
+fma_selection_get_access( FMASelection *selection, guint index )
+{
+	guint8 flags;
+
+	g_return_val_if_fail( selection && index < selection->count, 0 );
+
+	ensure_attributes( selection, index, FLAG_ACCESS, NULL );
+	flags = FLAGS_AT( selection, index );
+
+	return(( flags & FLAG_READABLE ? FMA_SELECTION_READABLE : 0 ) |
+			( flags & FLAG_WRITABLE ? FMA_SELECTION_WRITABLE : 0 ) |
+			( flags & FLAG_EXECUTABLE ? FMA_SELECTION_EXECUTABLE : 0 ));
+}
+
+/*
+ * fma_selection_peek_owner:
+ * @selection: this #FMASelection.
+ * @index: the index of the item.
+ *
+ * Returns: the owner of the item, owned by the @selection.
+ */
+const gchar *
+fma_selection_peek_owner( FMASelection *selection, guint index )
+{
+	g_return_val_if_fail( selection && index < selection->count, NULL );
+
+	ensure_attributes( selection, index, FLAG_OWNER, NULL );
+
+	return( STRING_AT( selection->owners, index ));
+}
+
+/*
+ * Nautilus uses to address the desktop via the 'x-nautilus-desktop:///' URI.
+ * g_filename_from_uri() complains that
+ * "The URI 'x-nautilus-desktop:///' is not an absolute URI using the "file" scheme".
+ * In this case, we prefer the vfs->path member wich is just a decomposition of the
+ * URI, and does not try to interpret it.
+ *
+ * *********************************************************************************
+ * Extract from RFC 2396:
+ *
+ * 2.4.3. Excluded US-ASCII Characters
+ *
+ * Although they are disallowed within the URI syntax, we include here a
+ * description of those US-ASCII characters that have been excluded and
+ * the reasons for their exclusion.
+ *
+ * The control characters in the US-ASCII coded character set are not
+ * used within a URI, both because they are non-printable and because
+ * they are likely to be misinterpreted by some control mechanisms.
+ *
+ * control = <US-ASCII coded characters 00-1F and 7F hexadecimal>
+ *
+ * The space character is excluded because significant spaces may
+ * disappear and insignificant spaces may be introduced when URI are
+ * transcribed or typeset or subjected to the treatment of word-
+ * processing programs. Whitespace is also used to delimit URI in many
+ * contexts.
+ *
+ * space = <US-ASCII coded character 20 hexadecimal>
+ *
+ * The angle-bracket "<" and ">" and double-quote (") characters are
+ * excluded because they are often used as the delimiters around URI in
+ * text documents and protocol fields. The character "#" is excluded
+ * because it is used to delimit a URI from a fragment identifier in URI
+ * references (Section 4). The percent character "%" is excluded because
+ * it is used for the encoding of escaped characters.
+ *
+ * delims = "<" | ">" | "#" | "%" | <">
+ *
+ * Other characters are excluded because gateways and other transport
+ * agents are known to sometimes modify such characters, or they are
+ * used as delimiters.
+ *
+ * unwise = "{" | "}" | "|" | "\" | "^" | "[" | "]" | "`"
+ *
+ * Data corresponding to excluded characters must be escaped in order to
+ * be properly represented within a URI.
+ *
+ * pwi 2011-01-04:
+ * It results from the above excerpt that:
+ * - as double quotes are not valid character in URI, they have to be
+ *   escaped as %22, and so Nautilus does
+ * - but simple quotes are not forbidden, and so have not to be
+ *   escaped, and so Nautilus does not escape them
+ *
+ * As a result, we may have valid, non-escaped, simple quotes in an URI.
+ */
+static guint
+add_item( FMASelection *selection, const gchar *uri, const gchar *filename, const gchar *mimetype, GFileType type )
+{
+	FMAGnomeVFSURI *vfs;
+	const gchar *path, *basename;
+	gchar *str;
+	guint8 type8, flags;
+	guint index;
+
+	index = selection->count;
+
+	vfs = g_new0( FMAGnomeVFSURI, 1 );
+	fma_gnome_vfs_uri_parse( vfs, uri );
+	if( !filename ){
+		g_debug( "fma_selection_add_item: uri='%s', filename=NULL, setting it to '%s'", uri, vfs->path );
+		filename = vfs->path;
+	}
+
+	g_ptr_array_add( selection->uris, g_string_chunk_insert( selection->arena, uri ));
+	path = g_string_chunk_insert( selection->arena, filename );
+	g_ptr_array_add( selection->filenames, ( gpointer ) path );
+
+	/* the basename is most often the tail of the filename
+	 */
+	str = g_path_get_basename( path );
+	basename = g_str_has_suffix( path, str ) ? path + strlen( path ) - strlen( str ) : g_string_chunk_insert( selection->arena, str );
+	g_ptr_array_add( selection->basenames, ( gpointer ) basename );
+	g_ptr_array_add( selection->basenames_utf8, NULL );
+	g_ptr_array_add( selection->basenames_folded, NULL );
+	g_free( str );
+
+	str = g_path_get_dirname( path );
+	g_ptr_array_add( selection->dirnames, ( gpointer ) intern( selection, str ));
+	g_free( str );
+
+	g_ptr_array_add( selection->hostnames, ( gpointer ) intern( selection, vfs->host_name ));
+	g_ptr_array_add( selection->usernames, ( gpointer ) intern( selection, vfs->user_name ));
+	g_ptr_array_add( selection->schemes, ( gpointer ) intern( selection, vfs->scheme ));
+	g_array_append_val( selection->ports, vfs->host_port );
+	fma_gnome_vfs_uri_free( vfs );
+
+	flags = 0;
+	g_ptr_array_add( selection->mimetypes, ( gpointer ) intern( selection, mimetype ));
+	if( mimetype ){
+		flags |= FLAG_MIMETYPE;
+	}
+	type8 = ( guint8 ) type;
+	g_array_append_val( selection->types, type8 );
+	if( type != G_FILE_TYPE_UNKNOWN ){
+		flags |= FLAG_TYPE;
+	}
+	g_ptr_array_add( selection->owners, NULL );
+	g_array_append_val( selection->flags, flags );
+
+	selection->count += 1;
+
+	dump( selection, index );
+
+	return( index );
+}
+
+/*
+ * NULL-safe
+ */
+static const gchar *
+intern( FMASelection *selection, const gchar *str )
+{
+	return( str ? g_string_chunk_insert_const( selection->arena, str ) : NULL );
+}
+
+static void
+dump( const FMASelection *selection, guint index )
+{
+	static const gchar *thisfn = "fma_selection_dump";
+
+	g_debug( "%s: index=%u, uri=%s, mimetype=%s, flags=%u",
+			thisfn, index,
+			STRING_AT( selection->uris, index ),
+			STRING_AT( selection->mimetypes, index ),
+			( guint ) FLAGS_AT( selection, index ));
+}
+
+/*
+ * if one of the @wanted groups of attributes is not set yet, queries
+ * all the missing groups at once, so that a remote file is only asked
+ * for one time
+ *
+ * the query itself is run without the mutex held, so that a slow file
+ * does not block the other threads
+ *
+ * the attributes are said set even if the query fails, so that it is
+ * not tried again
+ */
+static void
+ensure_attributes( FMASelection *selection, guint index, guint wanted, gchar **errmsg )
+{
+	GFileInfo *info;
+	guint8 flags;
+	guint groups;
+
+	g_mutex_lock( &selection->mutex );
+	flags = FLAGS_AT( selection, index );
+	g_mutex_unlock( &selection->mutex );
+
+	if(( flags & wanted ) != wanted ){
+		groups = FLAGS_ATTRIBUTES & ~flags;
+		info = query_file_attributes( selection, index, groups, errmsg );
+
+		g_mutex_lock( &selection->mutex );
+		groups &= ~FLAGS_AT( selection, index );
+		if( info ){
+			set_file_attributes( selection, index, groups, info );
+		}
+		FLAGS_AT( selection, index ) |= FLAGS_ATTRIBUTES;
+		g_mutex_unlock( &selection->mutex );
+
+		if( info ){
+			g_object_unref( info );
+		}
+	}
+}
+
+static GFileInfo *
+query_file_attributes( const FMASelection *selection, guint index, guint groups, gchar **errmsg )
+{
+	static const gchar *thisfn = "fma_selection_query_file_attributes";
+	GError *error;
+	GString *attributes;
+	GFile *location;
+	GFileInfo *info;
+	const gchar *uri;
+
+	attributes = g_string_new( "" );
+	if( groups & FLAG_TYPE ){
+		g_string_append( attributes, "," G_FILE_ATTRIBUTE_STANDARD_TYPE );
+	}
+	if( groups & FLAG_MIMETYPE ){
+		g_string_append( attributes, "," G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE );
+	}
+	if( groups & FLAG_ACCESS ){
+		g_string_append( attributes,
+				"," G_FILE_ATTRIBUTE_ACCESS_CAN_READ
+				"," G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE
+				"," G_FILE_ATTRIBUTE_ACCESS_CAN_EXECUTE );
+	}
+	if( groups & FLAG_OWNER ){
+		g_string_append( attributes, "," G_FILE_ATTRIBUTE_OWNER_USER );
+	}
+
+	uri = STRING_AT( selection->uris, index );
+	g_debug( "%s: uri=%s, attributes=%s", thisfn, uri, attributes->str+1 );
+
+	error = NULL;
+	location = g_file_new_for_uri( uri );
+	info = g_file_query_info( location, attributes->str+1, G_FILE_QUERY_INFO_NONE, NULL, &error );
+	g_object_unref( location );
+	g_string_free( attributes, TRUE );
+
+	if( error ){
+		if( errmsg ){
+			*errmsg = g_strdup_printf( _( "Error when querying informations for %s URI: %s" ), uri, error->message );
+		} else {
+			g_warning( "%s: uri=%s, g_file_query_info: %s", thisfn, uri, error->message );
+		}
+		g_error_free( error );
+	}
+
+	return( info );
+}
+
+/*
+ * this is called with the mutex held
+ */
+static void
+set_file_attributes( FMASelection *selection, guint index, guint groups, GFileInfo *info )
+{
+	guint8 type8;
+
+	if( groups & FLAG_MIMETYPE ){
+		g_ptr_array_index( selection->mimetypes, index ) = ( gpointer ) intern( selection,
+				g_file_info_get_attribute_string( info, G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE ));
+	}
+
+	if( groups & FLAG_TYPE ){
+		type8 = ( guint8 ) g_file_info_get_attribute_uint32( info, G_FILE_ATTRIBUTE_STANDARD_TYPE );
+		g_array_index( selection->types, guint8, index ) = type8;
+	}
+
+	if( groups & FLAG_ACCESS ){
+		FLAGS_AT( selection, index ) |=
+				( g_file_info_get_attribute_boolean( info, G_FILE_ATTRIBUTE_ACCESS_CAN_READ ) ? FLAG_READABLE : 0 ) |
+				( g_file_info_get_attribute_boolean( info, G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE ) ? FLAG_WRITABLE : 0 ) |
+				( g_file_info_get_attribute_boolean( info, G_FILE_ATTRIBUTE_ACCESS_CAN_EXECUTE ) ? FLAG_EXECUTABLE : 0 );
+	}
+
+	if( groups & FLAG_OWNER ){
+		g_ptr_array_index( selection->owners, index ) = ( gpointer ) intern( selection,
+				g_file_info_get_attribute_string( info, G_FILE_ATTRIBUTE_OWNER_USER ));
+	}
+}
+
+#if defined( HAVE_FSTATAT ) && defined( HAVE_FACCESSAT )
+/*
+ * only the @wanted groups which are not set yet are fetched; the access
+ * rights do not need the file be stat'ed
+ *
+ * symbolic links are followed, as g_file_query_info() does; a file which
+ * cannot be stat'ed (e.g. a broken link) is left as is
+ *
+ * this is called with the mutex held
+ */
+static void
+fetch_directory( FMASelection *selection, const gchar *dirname, GArray *indexes, guint wanted, GHashTable *owners )
+{
+	static const gchar *thisfn = "fma_selection_fetch_directory";
+	const gchar *basename;
+	struct stat st;
+	guint8 flags, missing, type8;
+	guint i, index;
+	gint fd;
+
+	fd = open( dirname, O_RDONLY | O_DIRECTORY | O_CLOEXEC );
+	if( fd < 0 ){
+		g_debug( "%s: unable to open %s", thisfn, dirname );
+		return;
+	}
+
+	for( i = 0 ; i < indexes->len ; ++i ){
+		index = g_array_index( indexes, guint, i );
+		basename = STRING_AT( selection->basenames, index );
+		flags = FLAGS_AT( selection, index );
+		missing = wanted & ~flags;
+
+		if(( missing & ( FLAG_TYPE | FLAG_OWNER )) && fstatat( fd, basename, &st, 0 ) != 0 ){
+			continue;
+		}
+
+		if( missing & FLAG_TYPE ){
+			type8 = ( guint8 ) fetch_file_type( st.st_mode );
+			g_array_index( selection->types, guint8, index ) = type8;
+			flags |= FLAG_TYPE;
+		}
+
+		if( missing & FLAG_ACCESS ){
+			flags |=
+					( faccessat( fd, basename, R_OK, 0 ) == 0 ? FLAG_READABLE : 0 ) |
+					( faccessat( fd, basename, W_OK, 0 ) == 0 ? FLAG_WRITABLE : 0 ) |
+					( faccessat( fd, basename, X_OK, 0 ) == 0 ? FLAG_EXECUTABLE : 0 ) |
+					FLAG_ACCESS;
+		}
+
+		if( missing & FLAG_OWNER ){
+			g_ptr_array_index( selection->owners, index ) = ( gpointer ) fetch_owner( selection, owners, st.st_uid );
+			flags |= FLAG_OWNER;
+		}
+
+		FLAGS_AT( selection, index ) = flags;
+	}
+
+	close( fd );
+}
+
+/*
+ * the user names are only looked up once per fetch, and are interned
+ * in the arena
+ */
+static const gchar *
+fetch_owner( FMASelection *selection, GHashTable *owners, uid_t uid )
+{
+	struct passwd pwd, *result;
+	gchar buffer[4096];
+	gpointer name;
+
+	if( !g_hash_table_lookup_extended( owners, GUINT_TO_POINTER( uid ), NULL, &name )){
+		result = NULL;
+		getpwuid_r( uid, &pwd, buffer, sizeof( buffer ), &result );
+		name = ( gpointer ) intern( selection, result ? result->pw_name : NULL );
+		g_hash_table_insert( owners, GUINT_TO_POINTER( uid ), name );
+	}
+
+	return(( const gchar * ) name );
+}
+
+static GFileType
+fetch_file_type( mode_t mode )
+{
+	if( S_ISREG( mode )){
+		return( G_FILE_TYPE_REGULAR );
+	}
+	if( S_ISDIR( mode )){
+		return( G_FILE_TYPE_DIRECTORY );
+	}
+	return( G_FILE_TYPE_SPECIAL );
+}
+#endif
@@ -0,0 +1,107 @@
+/*
+ * FileManager-Actions
+ * A file-manager extension which offers configurable context menu actions.
+ *
+ * Copyright (C) 2005 The GNOME Foundation
+ * Copyright (C) 2006-2008 Frederic Ruaudel and others (see AUTHORS)
+ * Copyright (C) 2009-2015 Pierre Wieser and others (see AUTHORS)
+ *
+ * FileManager-Actions is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * FileManager-Actions is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FileManager-Actions; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Frederic Ruaudel <grumz@grumz.net>
+ *   Rodrigo Moya <rodrigo@gnome-db.org>
+ *   Pierre Wieser <pwieser@trychlos.org>
+ *   ... and many others (see AUTHORS)
+ */
+
+#ifndef __CORE_FMA_SELECTION_H__
+#define __CORE_FMA_SELECTION_H__
+
+/* @title: FMASelection
+ * @short_description: A compact storage of the selected items
+ * @include: core/fma-selection.h
+ *
+ * A #FMASelection stores the characteristics of all the selected items
+ * of a file manager request as parallel arrays, one per attribute,
+ * indexed by the position of the item in the selection. All the strings
+ * live in a single #GStringChunk arena; the dirnames, schemes, hosts,
+ * users, mimetypes and owners are interned, so that a large selection
+ * in a few directories only stores each of them once. The type and the
+ * access rights are packed in a couple of bytes per item.
+ *
+ * The strings of the arena are never moved, so that the pointers handed
+ * out by the fma_selection_peek_xxx() functions stay valid as long as
+ * the selection itself, even when the attributes of other items are
+ * later queried.
+ *
+ * The candidate checks and the #FMATokens work directly on the
+ * selection, addressing its items by their index. The #FMASelectedInfo
+ * objects returned by fma_selection_get_list() are light views on one
+ * item of the selection, which are only kept for the #GList-based API.
+ */
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef struct _FMASelection FMASelection;
+
+/* the access rights of an item
+ */
+enum {
+	FMA_SELECTION_READABLE   = 1 << 0,
+	FMA_SELECTION_WRITABLE   = 1 << 1,
+	FMA_SELECTION_EXECUTABLE = 1 << 2
+};
+
+/* the groups of attributes which may be fetched by fma_selection_fetch()
+ */
+enum {
+	FMA_SELECTION_FETCH_TYPE   = 1 << 0,
+	FMA_SELECTION_FETCH_ACCESS = 1 << 1,
+	FMA_SELECTION_FETCH_OWNER  = 1 << 2
+};
+
+FMASelection *fma_selection_new               ( void );
+FMASelection *fma_selection_ref               ( FMASelection *selection );
+void          fma_selection_unref             ( FMASelection *selection );
+
+guint         fma_selection_add_location      ( FMASelection *selection, GFile *location, const gchar *uri, const gchar *mimetype, GFileType type );
+guint         fma_selection_add_uri           ( FMASelection *selection, const gchar *uri, const gchar *mimetype, gchar **errmsg );
+guint         fma_selection_add_copy          ( FMASelection *selection, FMASelection *source, guint index );
+
+guint         fma_selection_get_count         ( const FMASelection *selection );
+GList        *fma_selection_get_list          ( FMASelection *selection );
+void          fma_selection_fetch             ( FMASelection *selection, const guint *indexes, guint count, guint groups );
+
+const gchar  *fma_selection_peek_uri          ( const FMASelection *selection, guint index );
+const gchar  *fma_selection_peek_filename     ( const FMASelection *selection, guint index );
+const gchar  *fma_selection_peek_basename     ( const FMASelection *selection, guint index );
+const gchar  *fma_selection_peek_basename_utf8( FMASelection *selection, guint index, gboolean casefold );
+const gchar  *fma_selection_peek_dirname      ( const FMASelection *selection, guint index );
+const gchar  *fma_selection_peek_dirname_utf8 ( FMASelection *selection, guint index );
+const gchar  *fma_selection_peek_hostname     ( const FMASelection *selection, guint index );
+const gchar  *fma_selection_peek_username     ( const FMASelection *selection, guint index );
+const gchar  *fma_selection_peek_scheme       ( const FMASelection *selection, guint index );
+guint         fma_selection_get_port          ( const FMASelection *selection, guint index );
+const gchar  *fma_selection_peek_mimetype     ( FMASelection *selection, guint index );
+GFileType     fma_selection_get_file_type     ( FMASelection *selection, guint index );
+guint         fma_selection_get_access        ( FMASelection *selection, guint index );
+const gchar  *fma_selection_peek_owner        ( FMASelection *selection, guint index );
+
+G_END_DECLS
+
+#endif /* __CORE_FMA_SELECTION_H__ */
@@ -145,6 +145,9 @@ static const KeyDef st_def_keys[] = {
 	{ IPREFS_SHOW_IF_RUNNING_URI,              GROUP_FMA,    FMA_DATA_TYPE_STRING,      "file:///bin" },
 	{ IPREFS_TRY_EXEC_WSP,                     GROUP_FMA,    FMA_DATA_TYPE_UINT_LIST,   "" },
 	{ IPREFS_TRY_EXEC_URI,                     GROUP_FMA,    FMA_DATA_TYPE_STRING,      "file:///bin" },
+	{ IPREFS_EXEC_CHUNK_PLURAL,                GROUP_RUNTIME, FMA_DATA_TYPE_BOOLEAN,     "false" },
+	{ IPREFS_EXEC_MAX_CHILDREN,                GROUP_RUNTIME, FMA_DATA_TYPE_UINT,        "0" },
+	{ IPREFS_EXEC_OUTPUT_MAX,                  GROUP_RUNTIME, FMA_DATA_TYPE_UINT,        "65536" },
 	{ IPREFS_EXPORT_ASK_USER_WSP,              GROUP_FMA,    FMA_DATA_TYPE_UINT_LIST,   "" },
 	{ IPREFS_EXPORT_ASK_USER_LAST_FORMAT,      GROUP_FMA,    FMA_DATA_TYPE_STRING,      "Desktop1" },
 	{ IPREFS_EXPORT_ASK_USER_KEEP_LAST_CHOICE, GROUP_FMA,    FMA_DATA_TYPE_BOOLEAN,     "false" },
@@ -179,6 +182,15 @@ static const KeyDef st_def_keys[] = {
 	{ IPREFS_MAIN_WINDOW_WSP,                  GROUP_FMA,    FMA_DATA_TYPE_UINT_LIST,   "" },
 	{ IPREFS_PREFERENCES_WSP,                  GROUP_FMA,    FMA_DATA_TYPE_UINT_LIST,   "" },
 	{ IPREFS_PLUGIN_MENU_LOG,                  GROUP_RUNTIME, FMA_DATA_TYPE_BOOLEAN,     "false" },
+	{ IPREFS_PLUGIN_MENU_CONDITIONS_TIMEOUT,   GROUP_RUNTIME, FMA_DATA_TYPE_UINT,        "200" },
+	{ IPREFS_PLUGIN_MENU_CONDITIONS_DEFAULT,   GROUP_RUNTIME, FMA_DATA_TYPE_BOOLEAN,     "false" },
+	{ IPREFS_PLUGIN_MENU_SHOW_IF_TRUE_TTL,     GROUP_RUNTIME, FMA_DATA_TYPE_UINT,        "2000" },
+	{ IPREFS_PLUGIN_MENU_SHOW_IF_TRUE_TIMEOUT, GROUP_RUNTIME, FMA_DATA_TYPE_UINT,        "5000" },
+	{ IPREFS_PLUGIN_MENU_PROCESSES_TTL,        GROUP_RUNTIME, FMA_DATA_TYPE_UINT,        "1000" },
+	{ IPREFS_PLUGIN_MENU_PARALLEL_THREADS,     GROUP_RUNTIME, FMA_DATA_TYPE_UINT,        "0" },
+	{ IPREFS_PLUGIN_MENU_DEGRADED_THRESHOLD,   GROUP_RUNTIME, FMA_DATA_TYPE_UINT,        "5000" },
+	{ IPREFS_PLUGIN_MENU_DEGRADED_SAMPLE,      GROUP_RUNTIME, FMA_DATA_TYPE_UINT,        "256" },
+	{ IPREFS_PLUGIN_MENU_BUDGET,               GROUP_RUNTIME, FMA_DATA_TYPE_UINT,        "1000" },
 	{ IPREFS_RELABEL_DUPLICATE_ACTION,         GROUP_FMA,    FMA_DATA_TYPE_BOOLEAN,     "false" },
 	{ IPREFS_RELABEL_DUPLICATE_MENU,           GROUP_FMA,    FMA_DATA_TYPE_BOOLEAN,     "false" },
 	{ IPREFS_RELABEL_DUPLICATE_PROFILE,        GROUP_FMA,    FMA_DATA_TYPE_BOOLEAN,     "false" },
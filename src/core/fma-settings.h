@@ -86,6 +86,9 @@ G_BEGIN_DECLS
 #define IPREFS_SHOW_IF_RUNNING_URI				"environment-show-if-running-lfu"
 #define IPREFS_TRY_EXEC_WSP						"environment-try-exec-wsp"
 #define IPREFS_TRY_EXEC_URI						"environment-try-exec-lfu"
+#define IPREFS_EXEC_CHUNK_PLURAL				"exec-chunk-plural"
+#define IPREFS_EXEC_MAX_CHILDREN				"exec-max-children"
+#define IPREFS_EXEC_OUTPUT_MAX					"exec-output-max"
 #define IPREFS_EXPORT_ASK_USER_WSP				"export-ask-user-wsp"
 #define IPREFS_EXPORT_ASK_USER_LAST_FORMAT		"export-ask-user-last-format"
 #define IPREFS_EXPORT_ASK_USER_KEEP_LAST_CHOICE	"export-ask-user-keep-last-choice"
@@ -120,6 +123,15 @@ G_BEGIN_DECLS
 #define IPREFS_MAIN_WINDOW_WSP					"main-window-wsp"
 #define IPREFS_PREFERENCES_WSP					"preferences-wsp"
 #define IPREFS_PLUGIN_MENU_LOG					"plugin-menu-log-enabled"
+#define IPREFS_PLUGIN_MENU_CONDITIONS_TIMEOUT	"plugin-menu-conditions-timeout"
+#define IPREFS_PLUGIN_MENU_CONDITIONS_DEFAULT	"plugin-menu-conditions-default"
+#define IPREFS_PLUGIN_MENU_SHOW_IF_TRUE_TTL		"plugin-menu-show-if-true-ttl"
+#define IPREFS_PLUGIN_MENU_SHOW_IF_TRUE_TIMEOUT	"plugin-menu-show-if-true-timeout"
+#define IPREFS_PLUGIN_MENU_PROCESSES_TTL		"plugin-menu-processes-ttl"
+#define IPREFS_PLUGIN_MENU_PARALLEL_THREADS		"plugin-menu-parallel-threads"
+#define IPREFS_PLUGIN_MENU_DEGRADED_THRESHOLD	"plugin-menu-degraded-threshold"
+#define IPREFS_PLUGIN_MENU_DEGRADED_SAMPLE		"plugin-menu-degraded-sample"
+#define IPREFS_PLUGIN_MENU_BUDGET				"plugin-menu-budget"
 #define IPREFS_RELABEL_DUPLICATE_ACTION			"relabel-when-duplicate-action"
 #define IPREFS_RELABEL_DUPLICATE_MENU			"relabel-when-duplicate-menu"
 #define IPREFS_RELABEL_DUPLICATE_PROFILE		"relabel-when-duplicate-profile"
@@ -0,0 +1,520 @@
+/*
+ * FileManager-Actions
+ * A file-manager extension which offers configurable context menu actions.
+ *
+ * Copyright (C) 2005 The GNOME Foundation
+ * Copyright (C) 2006-2008 Frederic Ruaudel and others (see AUTHORS)
+ * Copyright (C) 2009-2015 Pierre Wieser and others (see AUTHORS)
+ *
+ * FileManager-Actions is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * FileManager-Actions is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FileManager-Actions; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Frederic Ruaudel <grumz@grumz.net>
+ *   Rodrigo Moya <rodrigo@gnome-db.org>
+ *   Pierre Wieser <pwieser@trychlos.org>
+ *   ... and many others (see AUTHORS)
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include <api/fma-object-api.h>
+
+#include "fma-template.h"
+
+struct _FMATemplate {
+	gint     ref_count;
+	gchar   *source;
+	GArray  *segments;					/* FMATemplateSegment */
+	gboolean singular;
+	GArray  *words;						/* FMATemplateSegment, or NULL */
+	gchar   *unquoted;					/* the literals of the words */
+};
+
+static GMutex      st_mutex;
+static GHashTable *st_templates = NULL;	/* source -> FMATemplate */
+
+static FMATemplate *template_compile( const gchar *string );
+static void         words_compile( FMATemplate *template );
+static void         words_flush( GArray *words, GString *unquoted, gint *literal );
+static void         compile_add( GHashTable *templates, gchar *string );
+static void         compile_context( GHashTable *templates, FMAObjectId *object );
+static void         compile_rec( GHashTable *templates, GList *tree );
+
+/*
+ * fma_template_get:
+ * @string: (allow-none): a string which may embed parameters.
+ *
+ * Returns: the compiled template of the @string, either from the cache
+ * or compiled on the fly, with a new reference which should be released
+ * with fma_template_unref() by the caller, or %NULL if @string is %NULL.
+ */
+FMATemplate *
+fma_template_get( const gchar *string )
+{
+	FMATemplate *template;
+
+	if( !string ){
+		return( NULL );
+	}
+
+	g_mutex_lock( &st_mutex );
+	template = st_templates ? ( FMATemplate * ) g_hash_table_lookup( st_templates, string ) : NULL;
+	if( template ){
+		fma_template_ref( template );
+	}
+	g_mutex_unlock( &st_mutex );
+
+	if( !template ){
+		template = template_compile( string );
+	}
+
+	return( template );
+}
+
+/*
+ * fma_template_ref:
+ * @template: this #FMATemplate.
+ *
+ * Returns: the @template with a new reference.
+ */
+FMATemplate *
+fma_template_ref( FMATemplate *template )
+{
+	g_return_val_if_fail( template, NULL );
+
+	g_atomic_int_inc( &template->ref_count );
+
+	return( template );
+}
+
+/*
+ * fma_template_unref:
+ * @template: (allow-none): this #FMATemplate.
+ *
+ * Releases a reference on the @template, freeing it with the last one.
+ */
+void
+fma_template_unref( FMATemplate *template )
+{
+	if( template && g_atomic_int_dec_and_test( &template->ref_count )){
+		g_array_free( template->segments, TRUE );
+		if( template->words ){
+			g_array_free( template->words, TRUE );
+		}
+		g_free( template->unquoted );
+		g_free( template->source );
+		g_free( template );
+	}
+}
+
+/*
+ * fma_template_get_source:
+ * @template: this #FMATemplate.
+ *
+ * Returns: the string the @template has been compiled from, which is
+ * owned by the @template.
+ */
+const gchar *
+fma_template_get_source( const FMATemplate *template )
+{
+	g_return_val_if_fail( template, NULL );
+
+	return( template->source );
+}
+
+/*
+ * fma_template_get_segments:
+ * @template: this #FMATemplate.
+ * @count: [out]: the count of segments.
+ *
+ * Returns: the segments of the @template, in the order of the source,
+ * as an array which is owned by the @template.
+ */
+const FMATemplateSegment *
+fma_template_get_segments( const FMATemplate *template, guint *count )
+{
+	g_return_val_if_fail( template, NULL );
+	g_return_val_if_fail( count, NULL );
+
+	*count = template->segments->len;
+
+	return(( const FMATemplateSegment * ) template->segments->data );
+}
+
+/*
+ * fma_template_get_words:
+ * @template: this #FMATemplate.
+ * @count: [out]: the count of segments.
+ *
+ * The @template, considered as a command line, is split into words the
+ * same way g_shell_parse_argv() would do, the parameters being kept as
+ * placeholders. The returned segments are either literals, which address
+ * the fma_template_get_unquoted() buffer, parameters, or word breaks
+ * (FMA_TEMPLATE_WORD_BREAK).
+ *
+ * A plural parameter expands to as many words as there are files, the
+ * first value being appended to the preceding literal of its word, and
+ * the last one being followed by the rest of it.
+ *
+ * Returns: the segments, as an array which is owned by the @template,
+ * or %NULL if the command line cannot be expanded this way, i.e. when a
+ * parameter appears inside quotes, or when the line has a comment or an
+ * unterminated quote.
+ */
+const FMATemplateSegment *
+fma_template_get_words( const FMATemplate *template, guint *count )
+{
+	g_return_val_if_fail( template, NULL );
+	g_return_val_if_fail( count, NULL );
+
+	if( !template->words ){
+		*count = 0;
+		return( NULL );
+	}
+
+	*count = template->words->len;
+
+	return(( const FMATemplateSegment * ) template->words->data );
+}
+
+/*
+ * fma_template_get_unquoted:
+ * @template: this #FMATemplate.
+ *
+ * Returns: the buffer the literals of the words are taken from, which is
+ * owned by the @template.
+ */
+const gchar *
+fma_template_get_unquoted( const FMATemplate *template )
+{
+	g_return_val_if_fail( template, NULL );
+
+	return( template->unquoted );
+}
+
+/*
+ * fma_template_is_singular:
+ * @template: this #FMATemplate.
+ *
+ * Returns: %TRUE if the first relevant parameter of the @template is of
+ * singular form, %FALSE else.
+ */
+gboolean
+fma_template_is_singular( const FMATemplate *template )
+{
+	g_return_val_if_fail( template, FALSE );
+
+	return( template->singular );
+}
+
+/*
+ * fma_template_compile_tree:
+ * @tree: the tree of the loaded items.
+ *
+ * Compiles the strings of the items of the @tree which embed parameters,
+ * replacing the current content of the cache.
+ */
+void
+fma_template_compile_tree( GList *tree )
+{
+	static const gchar *thisfn = "fma_template_compile_tree";
+	GHashTable *templates, *previous;
+
+	templates = g_hash_table_new_full( g_str_hash, g_str_equal, NULL, ( GDestroyNotify ) fma_template_unref );
+	compile_rec( templates, tree );
+
+	g_mutex_lock( &st_mutex );
+	previous = st_templates;
+	st_templates = templates;
+	g_mutex_unlock( &st_mutex );
+
+	if( previous ){
+		g_hash_table_destroy( previous );
+	}
+
+	g_debug( "%s: count=%u", thisfn, g_hash_table_size( templates ));
+}
+
+/*
+ * a lone '%' sign at the end of the string is ignored, as well as an
+ * unknown parameter at expansion time
+ */
+static FMATemplate *
+template_compile( const gchar *string )
+{
+	FMATemplate *template;
+	FMATemplateSegment segment;
+	gboolean found;
+	guint i, start;
+
+	template = g_new0( FMATemplate, 1 );
+	template->ref_count = 1;
+	template->source = g_strdup( string );
+	template->segments = g_array_new( FALSE, FALSE, sizeof( FMATemplateSegment ));
+	template->singular = FALSE;
+
+	found = FALSE;
+	start = 0;
+
+	for( i = 0 ; string[i] ; ){
+		if( string[i] != '%' ){
+			i += 1;
+			continue;
+		}
+
+		if( i > start ){
+			segment.token = 0;
+			segment.start = start;
+			segment.len = i - start;
+			g_array_append_val( template->segments, segment );
+		}
+
+		if( !string[i+1] ){
+			start = i+1;
+			break;
+		}
+
+		segment.token = string[i+1];
+		segment.start = i;
+		segment.len = 2;
+		g_array_append_val( template->segments, segment );
+
+		/* all other parameters are irrelevant according to DES-EMA
+		 */
+		if( !found && strchr( "bdfmouwx", segment.token )){
+			found = TRUE;
+			template->singular = TRUE;
+
+		} else if( !found && strchr( "BDFMOUWX", segment.token )){
+			found = TRUE;
+		}
+
+		i += 2;
+		start = i;
+	}
+
+	if( string[start] ){
+		segment.token = 0;
+		segment.start = start;
+		segment.len = strlen( string+start );
+		g_array_append_val( template->segments, segment );
+	}
+
+	words_compile( template );
+
+	return( template );
+}
+
+/*
+ * the quoting rules are those of g_shell_unquote(): inside double quotes,
+ * the backslash only escapes '"', '\', '`', '$' and a newline
+ */
+static void
+words_compile( FMATemplate *template )
+{
+	static const gchar *thisfn = "fma_template_words_compile";
+	GArray *words;
+	GString *unquoted;
+	FMATemplateSegment segment;
+	const gchar *s;
+	gboolean in_word, ok;
+	gint literal;
+	gchar quote;
+
+	words = g_array_new( FALSE, FALSE, sizeof( FMATemplateSegment ));
+	unquoted = g_string_new( "" );
+	s = template->source;
+	in_word = FALSE;
+	literal = -1;
+	ok = TRUE;
+
+	while( ok && *s ){
+		switch( *s ){
+			case '%':
+				if( !s[1] ){
+					s += 1;
+					break;
+				}
+				if( s[1] == '%' ){
+					if( literal < 0 ){
+						literal = unquoted->len;
+					}
+					unquoted = g_string_append_c( unquoted, '%' );
+
+				} else {
+					words_flush( words, unquoted, &literal );
+					segment.token = s[1];
+					segment.start = 0;
+					segment.len = 0;
+					g_array_append_val( words, segment );
+				}
+				in_word = TRUE;
+				s += 2;
+				break;
+
+			case ' ':
+			case '\t':
+			case '\n':
+				if( in_word ){
+					words_flush( words, unquoted, &literal );
+					segment.token = FMA_TEMPLATE_WORD_BREAK;
+					segment.start = 0;
+					segment.len = 0;
+					g_array_append_val( words, segment );
+					in_word = FALSE;
+				}
+				s += 1;
+				break;
+
+			case '\'':
+			case '"':
+				quote = *s++;
+				if( literal < 0 ){
+					literal = unquoted->len;
+				}
+				while( *s && *s != quote && *s != '%' ){
+					if( quote == '"' && *s == '\\' && s[1] && strchr( "\"\\`$\n", s[1] )){
+						s += 1;
+					}
+					unquoted = g_string_append_c( unquoted, *s++ );
+				}
+				ok = ( *s == quote );
+				in_word = TRUE;
+				s += 1;
+				break;
+
+			case '\\':
+				ok = ( s[1] != '\0' );
+				if( ok && s[1] != '\n' ){
+					if( literal < 0 ){
+						literal = unquoted->len;
+					}
+					unquoted = g_string_append_c( unquoted, s[1] );
+					in_word = TRUE;
+				}
+				s += 2;
+				break;
+
+			case '#':
+				ok = in_word;
+				/* fall through */
+
+			default:
+				if( literal < 0 ){
+					literal = unquoted->len;
+				}
+				unquoted = g_string_append_c( unquoted, *s++ );
+				in_word = TRUE;
+				break;
+		}
+	}
+
+	if( ok ){
+		words_flush( words, unquoted, &literal );
+		template->words = words;
+		template->unquoted = g_string_free( unquoted, FALSE );
+
+	} else {
+		g_debug( "%s: %s: not expandable as an argument vector", thisfn, template->source );
+		g_array_free( words, TRUE );
+		g_string_free( unquoted, TRUE );
+	}
+}
+
+/*
+ * pushes the pending literal, if any, as a segment
+ */
+static void
+words_flush( GArray *words, GString *unquoted, gint *literal )
+{
+	FMATemplateSegment segment;
+
+	if( *literal >= 0 ){
+		segment.token = 0;
+		segment.start = *literal;
+		segment.len = unquoted->len - *literal;
+		g_array_append_val( words, segment );
+		*literal = -1;
+	}
+}
+
+/*
+ * takes the ownership of the @string
+ */
+static void
+compile_add( GHashTable *templates, gchar *string )
+{
+	FMATemplate *template;
+
+	if( string && strchr( string, '%' ) && !g_hash_table_contains( templates, string )){
+		template = template_compile( string );
+		g_hash_table_insert( templates, template->source, template );
+	}
+
+	g_free( string );
+}
+
+static void
+compile_context( GHashTable *templates, FMAObjectId *object )
+{
+	compile_add( templates, fma_object_get_try_exec( object ));
+	compile_add( templates, fma_object_get_show_if_registered( object ));
+	compile_add( templates, fma_object_get_show_if_true( object ));
+	compile_add( templates, fma_object_get_show_if_running( object ));
+}
+
+static void
+compile_rec( GHashTable *templates, GList *tree )
+{
+	GList *it, *ip;
+	GSList *subitems, *is;
+	gchar *path, *parameters;
+
+	for( it = tree ; it ; it = it->next ){
+
+		compile_add( templates, fma_object_get_label( it->data ));
+		compile_add( templates, fma_object_get_tooltip( it->data ));
+		compile_add( templates, fma_object_get_icon( it->data ));
+		compile_context( templates, FMA_OBJECT_ID( it->data ));
+
+		subitems = fma_object_get_items_slist( it->data );
+		for( is = subitems ; is ; is = is->next ){
+			compile_add( templates, g_strdup(( const gchar * ) is->data ));
+		}
+		g_slist_free_full( subitems, ( GDestroyNotify ) g_free );
+
+		if( FMA_IS_OBJECT_MENU( it->data )){
+			compile_rec( templates, fma_object_get_items( it->data ));
+
+		} else if( FMA_IS_OBJECT_ACTION( it->data )){
+			compile_add( templates, fma_object_get_toolbar_label( it->data ));
+
+			for( ip = fma_object_get_items( it->data ) ; ip ; ip = ip->next ){
+				path = fma_object_get_path( ip->data );
+				parameters = fma_object_get_parameters( ip->data );
+				compile_add( templates, g_strdup_printf( "%s %s", path, parameters ));
+				g_free( parameters );
+				g_free( path );
+
+				compile_add( templates, fma_object_get_working_dir( ip->data ));
+				compile_context( templates, FMA_OBJECT_ID( ip->data ));
+			}
+		}
+	}
+}
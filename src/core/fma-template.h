@@ -0,0 +1,93 @@
+/*
+ * FileManager-Actions
+ * A file-manager extension which offers configurable context menu actions.
+ *
+ * Copyright (C) 2005 The GNOME Foundation
+ * Copyright (C) 2006-2008 Frederic Ruaudel and others (see AUTHORS)
+ * Copyright (C) 2009-2015 Pierre Wieser and others (see AUTHORS)
+ *
+ * FileManager-Actions is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * FileManager-Actions is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FileManager-Actions; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Frederic Ruaudel <grumz@grumz.net>
+ *   Rodrigo Moya <rodrigo@gnome-db.org>
+ *   Pierre Wieser <pwieser@trychlos.org>
+ *   ... and many others (see AUTHORS)
+ */
+
+#ifndef __CORE_FMA_TEMPLATE_H__
+#define __CORE_FMA_TEMPLATE_H__
+
+/* @title: FMATemplate
+ * @short_description: The compiled form of a string which embeds parameters
+ * @include: core/fma-template.h
+ *
+ * A #FMATemplate is the result of the parsing of a string which may
+ * embed parameters (see core/fma-tokens.h): a sequence of segments, each
+ * of them being either a literal part of the string or a reference to a
+ * parameter. The form of execution (singular or plural) which the string
+ * would imply as a command is computed at the same time.
+ *
+ * The labels, tooltips, icons, working directories, commands and
+ * conditions of the items are compiled when the items are loaded, and
+ * the templates are kept in a cache keyed by the source string, so that
+ * the expansion of a parameter-embedding string is a single linear
+ * concatenation of its segments. A string which is not in the cache is
+ * compiled on the fly.
+ *
+ * A template may also be expanded directly as an argument vector, each
+ * file of a plural parameter then becoming exactly one argument, without
+ * any quoting nor re-parsing (see fma_template_get_words()).
+ *
+ * The templates are reference-counted, and immutable once compiled, so
+ * that they may be shared between threads.
+ */
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _FMATemplate FMATemplate;
+
+/* a segment of a template:
+ * - a literal: @token is zero, and @start and @len address the source,
+ * - a parameter: @token is the character which follows the '%' sign.
+ */
+typedef struct {
+	gchar token;
+	guint start;
+	guint len;
+}
+	FMATemplateSegment;
+
+/* the pseudo-token which separates two words in fma_template_get_words()
+ */
+#define FMA_TEMPLATE_WORD_BREAK			' '
+
+FMATemplate              *fma_template_get         ( const gchar *string );
+FMATemplate              *fma_template_ref         ( FMATemplate *template );
+void                      fma_template_unref       ( FMATemplate *template );
+
+const gchar              *fma_template_get_source  ( const FMATemplate *template );
+const FMATemplateSegment *fma_template_get_segments( const FMATemplate *template, guint *count );
+gboolean                  fma_template_is_singular ( const FMATemplate *template );
+const FMATemplateSegment *fma_template_get_words   ( const FMATemplate *template, guint *count );
+const gchar              *fma_template_get_unquoted( const FMATemplate *template );
+
+void                      fma_template_compile_tree( GList *tree );
+
+G_END_DECLS
+
+#endif /* __CORE_FMA_TEMPLATE_H__ */
@@ -31,17 +31,19 @@
 #include <config.h>
 #endif
 
-#include <gio/gunixinputstream.h>
 #include <glib/gi18n.h>
 #include <gtk/gtk.h>
+#include <limits.h>
 #include <string.h>
+#include <unistd.h>
 
 #include <api/fma-core-utils.h>
 #include <api/fma-object-api.h>
 
+#include "fma-exec-queue.h"
 #include "fma-gnome-vfs-uri.h"
-#include "fma-selected-info.h"
 #include "fma-settings.h"
+#include "fma-template.h"
 #include "fma-tokens.h"
 
 /* private class data
@@ -50,33 +52,36 @@ struct _FMATokensClassPrivate {
 	void *empty;						/* so that gcc -pedantic is happy */
 };
 
-/* private instance data
+/* the per-file fields, each of them only being built when a parameter
+ * which needs it is first expanded
  */
-struct _FMATokensPrivate {
-	gboolean dispose_has_run;
-	guint    count;
-	GSList  *uris;
-	GSList  *filenames;
-	GSList  *basedirs;
-	GSList  *basenames;
-	GSList  *basenames_woext;
-	GSList  *exts;
-	GSList  *mimetypes;
-	gchar   *hostname;
-	gchar   *username;
-	guint    port;
-	gchar   *scheme;
+enum {
+	TOKEN_URI = 0,
+	TOKEN_FILENAME,
+	TOKEN_BASEDIR,
+	TOKEN_BASENAME,
+	TOKEN_BASENAME_WOEXT,
+	TOKEN_EXT,
+	TOKEN_MIMETYPE,
+	TOKEN_N
 };
 
-/*  the structure passed to the callback which waits for the end of the child
+/* the room kept free when splitting a plural-form command
  */
-typedef struct {
-	gchar   *command;
-	gboolean is_output_displayed;
-	gint     child_stdout;
-	gint     child_stderr;
-}
-	ChildStr;
+#define ARG_MARGIN						2048
+
+/* private instance data
+ */
+struct _FMATokensPrivate {
+	gboolean      dispose_has_run;
+	guint         count;
+	FMASelection *selection;			/* reffed */
+	gchar       **fields[ TOKEN_N ];	/* count values, NULL until first needed */
+	gchar        *hostname;
+	gchar        *username;
+	guint         port;
+	gchar        *scheme;
+};
 
 static GObjectClass *st_parent_class = NULL;
 
@@ -86,18 +91,29 @@ static void      instance_init( GTypeInstance *instance, gpointer klass );
 static void      instance_dispose( GObject *object );
 static void      instance_finalize( GObject *object );
 
-static void      child_watch_fn( GPid pid, gint status, ChildStr *child_str );
-static void      display_output( const gchar *command, int fd_stdout, int fd_stderr );
-static gchar    *display_output_get_content( int fd );
+static void      on_display_output_done( const gchar *command, gint status, const gchar *std_output, const gchar *std_error, void *empty );
+static void      display_output( const gchar *command, const gchar *std_output, const gchar *std_error );
+static gchar    *display_output_get_content( const gchar *content );
+static void      execute_action_unit( const FMATokens *tokens, const FMATemplate *template, const FMAObjectProfile *profile, gboolean use_argv, guint i, guint start, guint end );
 static void      execute_action_command( gchar *command, const FMAObjectProfile *profile, const FMATokens *tokens );
+static void      execute_action_argv( gchar **argv, const gchar *command, const FMAObjectProfile *profile, const FMATokens *tokens, gboolean is_output_displayed );
 static gchar    *get_command_execution_display_output( const gchar *command );
 static gchar    *get_command_execution_embedded( const gchar *command );
 static gchar    *get_command_execution_normal( const gchar *command );
 static gchar    *get_command_execution_terminal( const gchar *command );
-static gboolean  is_singular_exec( const FMATokens *tokens, const gchar *exec );
-static gchar    *parse_singular( const FMATokens *tokens, const gchar *input, guint i, gboolean utf8, gboolean quoted );
+static gchar   **get_field( const FMATokens *tokens, guint field );
+static void      build_field( FMATokens *tokens, guint field );
+static gchar    *parse_singular( const FMATokens *tokens, const gchar *input, guint i, gboolean quoted );
+static gchar    *expand_template( const FMATokens *tokens, const FMATemplate *template, guint i, guint start, guint end, gboolean quoted );
+static void      execute_plural_chunked( const FMATokens *tokens, const FMATemplate *template, const FMAObjectProfile *profile, gboolean use_argv );
+static guint    *plural_chunks( const FMATokens *tokens, const FMATemplate *template, gboolean requoted, gsize limit, guint *chunks );
+static gsize     quoted_length( const gchar *str, gboolean requoted );
+static gchar   **expand_template_argv( const FMATokens *tokens, const FMATemplate *template, guint i, guint start, guint end );
+static GString  *argv_append( GString *word, const gchar *str );
+static void      argv_push( GPtrArray *argv, GString **word );
+static gint      get_plural_field( gchar token );
 static GString  *quote_string( GString *input, const gchar *name, gboolean quoted );
-static GString  *quote_string_list( GString *input, GSList *names, gboolean quoted );
+static GString  *quote_string_list( GString *input, gchar **names, guint count, gboolean quoted );
 
 GType
 fma_tokens_get_type( void )
@@ -168,13 +184,7 @@ instance_init( GTypeInstance *instance, gpointer klass )
 
 	self->private = g_new0( FMATokensPrivate, 1 );
 
-	self->private->uris = NULL;
-	self->private->filenames = NULL;
-	self->private->basedirs = NULL;
-	self->private->basenames = NULL;
-	self->private->basenames_woext = NULL;
-	self->private->exts = NULL;
-	self->private->mimetypes = NULL;
+	self->private->selection = NULL;
 	self->private->hostname = NULL;
 	self->private->username = NULL;
 	self->private->port = 0;
@@ -210,6 +220,7 @@ instance_finalize( GObject *object )
 {
 	static const gchar *thisfn = "fma_tokens_instance_finalize";
 	FMATokens *self;
+	guint i, j;
 
 	g_return_if_fail( FMA_IS_TOKENS( object ));
 
@@ -217,16 +228,20 @@ instance_finalize( GObject *object )
 
 	self = FMA_TOKENS( object );
 
+	if( self->private->selection ){
+		fma_selection_unref( self->private->selection );
+	}
+	for( i = 0 ; i < TOKEN_N ; ++i ){
+		if( self->private->fields[i] ){
+			for( j = 0 ; j < self->private->count ; ++j ){
+				g_free( self->private->fields[i][j] );
+			}
+			g_free( self->private->fields[i] );
+		}
+	}
 	g_free( self->private->scheme );
 	g_free( self->private->username );
 	g_free( self->private->hostname );
-	fma_core_utils_slist_free( self->private->mimetypes );
-	fma_core_utils_slist_free( self->private->exts );
-	fma_core_utils_slist_free( self->private->basenames_woext );
-	fma_core_utils_slist_free( self->private->basenames );
-	fma_core_utils_slist_free( self->private->basedirs );
-	fma_core_utils_slist_free( self->private->filenames );
-	fma_core_utils_slist_free( self->private->uris );
 
 	g_free( self->private );
 
@@ -255,44 +270,39 @@ fma_tokens_new_for_example( void )
 	const guint  ex_port = 8080;
 	const gchar *ex_host = _( "test.example.net" );
 	const gchar *ex_user = _( "user" );
+	const gchar *ex_uris[] = { ex_uri1, ex_uri2 };
+	const gchar *ex_mimetypes[] = { ex_mimetype1, ex_mimetype2 };
 	FMAGnomeVFSURI *vfs;
-	gchar *dirname, *bname, *bname_woext, *ext;
-	GSList *is;
-	gboolean first;
+	guint i;
 
 	g_debug( "%s:", thisfn );
 
 	tokens = g_object_new( FMA_TYPE_TOKENS, NULL );
-	first = TRUE;
-	tokens->private->count = 2;
+	tokens->private->count = G_N_ELEMENTS( ex_uris );
 
-	tokens->private->uris = g_slist_append( tokens->private->uris, g_strdup( ex_uri1 ));
-	tokens->private->uris = g_slist_append( tokens->private->uris, g_strdup( ex_uri2 ));
+	for( i = 0 ; i < TOKEN_N ; ++i ){
+		tokens->private->fields[i] = g_new0( gchar *, tokens->private->count );
+	}
 
-	for( is = tokens->private->uris ; is ; is = is->next ){
+	for( i = 0 ; i < tokens->private->count ; ++i ){
 		vfs = g_new0( FMAGnomeVFSURI, 1 );
-		fma_gnome_vfs_uri_parse( vfs, is->data );
-
-		tokens->private->filenames = g_slist_append( tokens->private->filenames, g_strdup( vfs->path ));
-		dirname = g_path_get_dirname( vfs->path );
-		tokens->private->basedirs = g_slist_append( tokens->private->basedirs, dirname );
-		bname = g_path_get_basename( vfs->path );
-		tokens->private->basenames = g_slist_append( tokens->private->basenames, bname );
-		fma_core_utils_dir_split_ext( bname, &bname_woext, &ext );
-		tokens->private->basenames_woext = g_slist_append( tokens->private->basenames_woext, bname_woext );
-		tokens->private->exts = g_slist_append( tokens->private->exts, ext );
-
-		if( first ){
+		fma_gnome_vfs_uri_parse( vfs, ex_uris[i] );
+
+		tokens->private->fields[TOKEN_URI][i] = g_strdup( ex_uris[i] );
+		tokens->private->fields[TOKEN_FILENAME][i] = g_strdup( vfs->path );
+		tokens->private->fields[TOKEN_BASEDIR][i] = g_path_get_dirname( vfs->path );
+		tokens->private->fields[TOKEN_BASENAME][i] = g_path_get_basename( vfs->path );
+		fma_core_utils_dir_split_ext( tokens->private->fields[TOKEN_BASENAME][i],
+				&tokens->private->fields[TOKEN_BASENAME_WOEXT][i], &tokens->private->fields[TOKEN_EXT][i] );
+		tokens->private->fields[TOKEN_MIMETYPE][i] = g_strdup( ex_mimetypes[i] );
+
+		if( !i ){
 			tokens->private->scheme = g_strdup( vfs->scheme );
-			first = FALSE;
 		}
 
 		fma_gnome_vfs_uri_free( vfs );
 	}
 
-	tokens->private->mimetypes = g_slist_append( tokens->private->mimetypes, g_strdup( ex_mimetype1 ));
-	tokens->private->mimetypes = g_slist_append( tokens->private->mimetypes, g_strdup( ex_mimetype2 ));
-
 	tokens->private->hostname = g_strdup( ex_host );
 	tokens->private->username = g_strdup( ex_user );
 	tokens->private->port = ex_port;
@@ -302,52 +312,38 @@ fma_tokens_new_for_example( void )
 
 /*
  * fma_tokens_new_from_selection:
- * @selection: a #GList list of #FMASelectedInfo objects.
+ * @selection: a #FMASelection.
+ *
+ * The per-file fields (uris, filenames, basenames, mimetypes and so on)
+ * are each only built when a parameter which needs it is first expanded,
+ * so that a context menu whose labels do not use any parameter does not
+ * have to go through each selected file. They are then kept as arrays,
+ * indexed in the selection order.
  *
  * Returns: a new #FMATokens object which holds all possible tokens.
  */
 FMATokens *
-fma_tokens_new_from_selection( GList *selection )
+fma_tokens_new_from_selection( FMASelection *selection )
 {
 	static const gchar *thisfn = "fma_tokens_new_from_selection";
 	FMATokens *tokens;
-	GList *it;
-	gchar *uri, *filename, *basedir, *basename, *bname_woext, *ext, *mimetype;
-	gboolean first;
 
-	g_debug( "%s: selection=%p (count=%d)", thisfn, ( void * ) selection, g_list_length( selection ));
+	g_return_val_if_fail( selection, NULL );
 
-	first = TRUE;
 	tokens = g_object_new( FMA_TYPE_TOKENS, NULL );
 
-	tokens->private->count = g_list_length( selection );
-
-	for( it = selection ; it ; it = it->next ){
-		mimetype = fma_selected_info_get_mime_type( FMA_SELECTED_INFO( it->data ));
+	tokens->private->selection = fma_selection_ref( selection );
+	tokens->private->count = fma_selection_get_count( selection );
 
-		uri = fma_selected_info_get_uri( FMA_SELECTED_INFO( it->data ));
-		filename = fma_selected_info_get_path( FMA_SELECTED_INFO( it->data ));
-		basedir = fma_selected_info_get_dirname( FMA_SELECTED_INFO( it->data ));
-		basename = fma_selected_info_get_basename( FMA_SELECTED_INFO( it->data ));
-		fma_core_utils_dir_split_ext( basename, &bname_woext, &ext );
-
-		if( first ){
-			tokens->private->hostname = fma_selected_info_get_uri_host( FMA_SELECTED_INFO( it->data ));
-			tokens->private->username = fma_selected_info_get_uri_user( FMA_SELECTED_INFO( it->data ));
-			tokens->private->port = fma_selected_info_get_uri_port( FMA_SELECTED_INFO( it->data ));
-			tokens->private->scheme = fma_selected_info_get_uri_scheme( FMA_SELECTED_INFO( it->data ));
-			first = FALSE;
-		}
-
-		tokens->private->uris = g_slist_append( tokens->private->uris, uri );
-		tokens->private->filenames = g_slist_append( tokens->private->filenames, filename );
-		tokens->private->basedirs = g_slist_append( tokens->private->basedirs, basedir );
-		tokens->private->basenames = g_slist_append( tokens->private->basenames, basename );
-		tokens->private->basenames_woext = g_slist_append( tokens->private->basenames_woext, bname_woext );
-		tokens->private->exts = g_slist_append( tokens->private->exts, ext );
-		tokens->private->mimetypes = g_slist_append( tokens->private->mimetypes, mimetype );
+	if( tokens->private->count ){
+		tokens->private->hostname = g_strdup( fma_selection_peek_hostname( selection, 0 ));
+		tokens->private->username = g_strdup( fma_selection_peek_username( selection, 0 ));
+		tokens->private->port = fma_selection_get_port( selection, 0 );
+		tokens->private->scheme = g_strdup( fma_selection_peek_scheme( selection, 0 ));
 	}
 
+	g_debug( "%s: selection=%p (count=%u)", thisfn, ( void * ) selection, tokens->private->count );
+
 	return( tokens );
 }
 
@@ -355,7 +351,8 @@ fma_tokens_new_from_selection( GList *selection )
  * fma_tokens_parse_for_display:
  * @tokens: a #FMATokens object.
  * @string: the input string, may or may not contain tokens.
- * @utf8: whether the @input string is UTF-8 encoded, or a standard ASCII string.
+ * @utf8: unused; the parameters are expanded the same way whether the
+ *  @string is UTF-8 encoded or not. Kept for API compatibility.
  *
  * Expands the parameters in the given string.
  *
@@ -368,7 +365,96 @@ fma_tokens_new_from_selection( GList *selection )
 gchar *
 fma_tokens_parse_for_display( const FMATokens *tokens, const gchar *string, gboolean utf8 )
 {
-	return( parse_singular( tokens, string, 0, utf8, FALSE ));
+	return( parse_singular( tokens, string, 0, FALSE ));
+}
+
+/*
+ * fma_tokens_expand_command:
+ * @tokens: a #FMATokens object.
+ * @command: the command, may or may not contain tokens.
+ * @i: the number of the iteration in a multiple selection, starting with zero.
+ * @start: the index of the first file of the plural parameters.
+ * @end: the index after the last file of the plural parameters.
+ *
+ * Expands the @command as a string to be parsed by a shell, the
+ * filenames being shell-quoted.
+ *
+ * Returns: the expanded command, as a newly allocated string which should
+ * be g_free() by the caller.
+ */
+gchar *
+fma_tokens_expand_command( const FMATokens *tokens, const gchar *command, guint i, guint start, guint end )
+{
+	FMATemplate *template;
+	gchar *output;
+
+	template = fma_template_get( command );
+	output = expand_template( tokens, template, i, start, end, TRUE );
+	fma_template_unref( template );
+
+	return( output );
+}
+
+/*
+ * fma_tokens_expand_argv:
+ * @tokens: a #FMATokens object.
+ * @command: the command, may or may not contain tokens.
+ * @i: the number of the iteration in a multiple selection, starting with zero.
+ * @start: the index of the first file of the plural parameters.
+ * @end: the index after the last file of the plural parameters.
+ *
+ * Expands the @command directly as an argument vector, as a Normal
+ * command is executed.
+ *
+ * Returns: the %NULL-terminated argument vector, which should be
+ * g_strfreev() by the caller, or %NULL if the @command cannot be
+ * expanded this way (e.g. because it embeds a parameter inside quotes),
+ * and has so to go through fma_tokens_expand_command().
+ */
+gchar **
+fma_tokens_expand_argv( const FMATokens *tokens, const gchar *command, guint i, guint start, guint end )
+{
+	FMATemplate *template;
+	gchar **argv;
+	guint count;
+
+	template = fma_template_get( command );
+	argv = fma_template_get_words( template, &count )
+			? expand_template_argv( tokens, template, i, start, end )
+			: NULL;
+	fma_template_unref( template );
+
+	return( argv );
+}
+
+/*
+ * fma_tokens_get_plural_chunks:
+ * @tokens: a #FMATokens object.
+ * @command: the plural-form command.
+ * @execution_mode: the execution mode of the profile.
+ * @limit: the maximal size of the arguments (see fma_tokens_get_arg_limit()).
+ * @chunks: [out]: the count of ranges.
+ *
+ * Splits the selection as a plural-form @command is executed when the
+ * 'exec-chunk-plural' preference is set: each range of files becomes one
+ * execution of the @command, the plural parameters and the count of
+ * files only considering this range.
+ *
+ * Returns: the index after the last file of each range, as a newly
+ * allocated array of @chunks elements which should be g_free() by the
+ * caller.
+ */
+guint *
+fma_tokens_get_plural_chunks( const FMATokens *tokens, const gchar *command, const gchar *execution_mode, gsize limit, guint *chunks )
+{
+	FMATemplate *template;
+	guint *ends;
+
+	template = fma_template_get( command );
+	ends = plural_chunks( tokens, template, strcmp( execution_mode, "Normal" ) != 0, limit, chunks );
+	fma_template_unref( template );
+
+	return( ends );
 }
 
 /*
@@ -381,10 +467,10 @@ fma_tokens_parse_for_display( const FMATokens *tokens, const gchar *string, gboo
 void
 fma_tokens_execute_action( const FMATokens *tokens, const FMAObjectProfile *profile )
 {
-	gchar *path, *parameters, *exec;
-	gboolean singular;
-	guint i;
-	gchar *command;
+	gchar *path, *parameters, *exec, *execution_mode;
+	FMATemplate *template;
+	guint i, count;
+	gboolean use_argv;
 
 	path = fma_object_get_path( profile );
 	parameters = fma_object_get_parameters( profile );
@@ -392,96 +478,106 @@ fma_tokens_execute_action( const FMATokens *tokens, const FMAObjectProfile *prof
 	g_free( parameters );
 	g_free( path );
 
-	singular = is_singular_exec( tokens, exec );
+	/* the command has been compiled when the items have been loaded
+	 */
+	template = fma_template_get( exec );
+
+	/* a Normal command is directly expanded as an argument vector,
+	 * unless its parameters are embedded inside quotes
+	 */
+	execution_mode = fma_object_get_execution_mode( profile );
+	use_argv = !strcmp( execution_mode, "Normal" ) && fma_template_get_words( template, &count ) != NULL;
+	g_free( execution_mode );
 
-	if( singular ){
+	if( fma_template_is_singular( template )){
 		for( i = 0 ; i < tokens->private->count ; ++i ){
-			command = parse_singular( tokens, exec, i, FALSE, TRUE );
-			execute_action_command( command, profile, tokens );
-			g_free( command );
+			execute_action_unit( tokens, template, profile, use_argv, i, 0, tokens->private->count );
 		}
 
+	} else if( tokens->private->count > 1 && fma_settings_get_boolean( IPREFS_EXEC_CHUNK_PLURAL, NULL, NULL )){
+		execute_plural_chunked( tokens, template, profile, use_argv );
+
 	} else {
-		command = parse_singular( tokens, exec, 0, FALSE, TRUE );
-		execute_action_command( command, profile, tokens );
-		g_free( command );
+		execute_action_unit( tokens, template, profile, use_argv, 0, 0, tokens->private->count );
 	}
 
+	fma_template_unref( template );
 	g_free( exec );
 }
 
 static void
-child_watch_fn( GPid pid, gint status, ChildStr *child_str )
+on_display_output_done( const gchar *command, gint status, const gchar *std_output, const gchar *std_error, void *empty )
 {
-	static const gchar *thisfn = "fma_tokens_child_watch_fn";
+	static const gchar *thisfn = "fma_tokens_on_display_output_done";
 
-	g_debug( "%s: pid=%u, status=%d", thisfn, ( guint ) pid, status );
-	g_spawn_close_pid( pid );
-	if( child_str->is_output_displayed ){
-		display_output( child_str->command, child_str->child_stdout, child_str->child_stderr );
-	}
-	g_free( child_str->command );
-	g_free( child_str );
+	g_debug( "%s: command=%s, status=%d", thisfn, command, status );
+	display_output( command, std_output, std_error );
 }
 
 static void
-display_output( const gchar *command, int fd_stdout, int fd_stderr )
+display_output( const gchar *command, const gchar *std_output, const gchar *std_error )
 {
 	GtkWidget *dialog;
-	gchar *std_output, *std_error;
+	gchar *output, *error;
 
 	dialog = gtk_message_dialog_new_with_markup(
 			NULL, GTK_DIALOG_MODAL, GTK_MESSAGE_INFO, GTK_BUTTONS_OK, "<b>%s</b>", _( "Output of the run command" ));
 	g_object_set( G_OBJECT( dialog ) , "title", PACKAGE_NAME, NULL );
 
-	std_output = display_output_get_content( fd_stdout );
-	std_error = display_output_get_content( fd_stderr );
+	output = display_output_get_content( std_output );
+	error = display_output_get_content( std_error );
 
 	gtk_message_dialog_format_secondary_markup( GTK_MESSAGE_DIALOG( dialog ),
 			"<b>%s</b>\n%s\n\n<b>%s</b>\n%s\n\n<b>%s</b>\n%s\n\n",
 					_( "Run command:" ), command,
-					_( "Standard output:" ), std_output,
-					_( "Standard error:" ), std_error );
+					_( "Standard output:" ), output,
+					_( "Standard error:" ), error );
 
 	gtk_dialog_run( GTK_DIALOG( dialog ));
 	gtk_widget_destroy( dialog );
 
-	g_free( std_output );
-	g_free( std_error );
+	g_free( output );
+	g_free( error );
 }
 
+/*
+ * the output has been read by the execution queue while the child was
+ * running, and is bounded by the 'exec-output-max' preference
+ */
 static gchar *
-display_output_get_content( int fd )
+display_output_get_content( const gchar *content )
 {
-	static const gchar *thisfn = "fma_tokens_display_output_get_content";
-	GInputStream *stream;
-	GString *string;
-	gchar buf[1024];
-	GError *error;
 	gchar *msg;
 
-	string = g_string_new( "" );
-	memset( buf, '\0', sizeof( buf ));
+	msg = content ? g_locale_to_utf8( content, -1, NULL, NULL, NULL ) : NULL;
 
-	if( fd > 0 ){
-		stream = g_unix_input_stream_new( fd, TRUE );
-		error = NULL;
+	return( msg ? msg : g_strdup( "" ));
+}
 
-		while( g_input_stream_read( stream, buf, sizeof( buf )-1, NULL, &error )){
-			string = g_string_append( string, buf );
-			memset( buf, '\0', sizeof( buf ));
-		}
-		if( error ){
-			g_warning( "%s: g_input_stream_read: %s", thisfn, error->message );
-			g_error_free( error );
-		}
-		g_input_stream_close( stream, NULL, NULL );
-	}
+/*
+ * executes the @template for the @i-th file, the plural parameters
+ * considering the [@start, @end[ range of the selection
+ */
+static void
+execute_action_unit( const FMATokens *tokens, const FMATemplate *template, const FMAObjectProfile *profile, gboolean use_argv, guint i, guint start, guint end )
+{
+	gchar **argv;
+	gchar *command;
 
-	msg = g_locale_to_utf8( string->str, -1, NULL, NULL, NULL );
-	g_string_free( string, TRUE );
+	if( use_argv ){
+		argv = expand_template_argv( tokens, template, i, start, end );
+		if( argv[0] ){
+			command = g_strjoinv( " ", argv );
+			execute_action_argv( argv, command, profile, tokens, FALSE );
+			g_free( command );
+		}
+		g_strfreev( argv );
 
-	return( msg );
+	} else {
+		command = expand_template( tokens, template, i, start, end, TRUE );
+		execute_action_command( command, profile, tokens );
+		g_free( command );
+	}
 }
 
 /*
@@ -499,16 +595,13 @@ execute_action_command( gchar *command, const FMAObjectProfile *profile, const F
 	gchar *execution_mode, *run_command;
 	gchar **argv;
 	gint argc;
-	gchar *wdir, *wdir_nq;
-	GPid child_pid;
-	ChildStr *child_str;
+	gboolean is_output_displayed;
 
 	g_debug( "%s: profile=%p", thisfn, ( void * ) profile );
 
 	error = NULL;
 	run_command = NULL;
-	child_str = g_new0( ChildStr, 1 );
-	child_pid = ( GPid ) 0;
+	is_output_displayed = FALSE;
 	execution_mode = fma_object_get_execution_mode( profile );
 
 	if( !strcmp( execution_mode, "Normal" )){
@@ -521,7 +614,7 @@ execute_action_command( gchar *command, const FMAObjectProfile *profile, const F
 		run_command = get_command_execution_embedded( command );
 
 	} else if( !strcmp( execution_mode, "DisplayOutput" )){
-		child_str->is_output_displayed = TRUE;
+		is_output_displayed = TRUE;
 		run_command = get_command_execution_display_output( command );
 
 	} else {
@@ -529,61 +622,13 @@ execute_action_command( gchar *command, const FMAObjectProfile *profile, const F
 	}
 
 	if( run_command ){
-		child_str->command = g_strdup( run_command );
 
 		if( !g_shell_parse_argv( run_command, &argc, &argv, &error )){
 			g_warning( "%s: g_shell_parse_argv: %s", thisfn, error->message );
 			g_error_free( error );
 
 		} else {
-			wdir = fma_object_get_working_dir( profile );
-			wdir_nq = parse_singular( tokens, wdir, 0, FALSE, FALSE );
-			g_debug( "%s: run_command=%s, wdir=%s", thisfn, run_command, wdir_nq );
-
-			/* it appears that at least mplayer does not support g_spawn_async_with_pipes
-			 * (at least when not run in '-quiet' mode) while, e.g., totem and vlc rightly
-			 * support this function
-			 * So only use g_spawn_async_with_pipes when we really need to get back
-			 * the content of output and error streams
-			 * See https://bugzilla.gnome.org/show_bug.cgi?id=644289.
-			 */
-			if( child_str->is_output_displayed ){
-				g_spawn_async_with_pipes(
-						wdir_nq,
-						argv,
-						NULL,
-						G_SPAWN_SEARCH_PATH | G_SPAWN_DO_NOT_REAP_CHILD,
-						NULL,
-						NULL,
-						&child_pid,
-						NULL,
-						&child_str->child_stdout,
-						&child_str->child_stderr,
-						&error );
-
-			} else {
-				g_spawn_async(
-						wdir_nq,
-						argv,
-						NULL,
-						G_SPAWN_SEARCH_PATH | G_SPAWN_DO_NOT_REAP_CHILD,
-						NULL,
-						NULL,
-						&child_pid,
-						&error );
-			}
-
-			if( error ){
-				g_warning( "%s: g_spawn_async: %s", thisfn, error->message );
-				g_error_free( error );
-				child_pid = ( GPid ) 0;
-
-			} else {
-				g_child_watch_add( child_pid, ( GChildWatchFunc ) child_watch_fn, child_str );
-			}
-
-			g_free( wdir );
-			g_free( wdir_nq );
+			execute_action_argv( argv, run_command, profile, tokens, is_output_displayed );
 			g_strfreev( argv );
 		}
 
@@ -591,11 +636,27 @@ execute_action_command( gchar *command, const FMAObjectProfile *profile, const F
 	}
 
 	g_free( execution_mode );
+}
 
-	if( child_pid == ( GPid ) 0 ){
-		g_free( child_str->command );
-		g_free( child_str );
-	}
+static void
+execute_action_argv( gchar **argv, const gchar *command, const FMAObjectProfile *profile, const FMATokens *tokens, gboolean is_output_displayed )
+{
+	static const gchar *thisfn = "nautilus_actions_execute_action_argv";
+	gchar *wdir, *wdir_nq;
+
+	wdir = fma_object_get_working_dir( profile );
+	wdir_nq = parse_singular( tokens, wdir, 0, FALSE );
+	g_debug( "%s: run_command=%s, wdir=%s", thisfn, command, wdir_nq );
+
+	/* the command is actually spawned by the execution queue,
+	 * as soon as the count of running children allows it
+	 */
+	fma_exec_queue_push( fma_exec_queue_get_default(),
+			argv, wdir_nq, command, is_output_displayed, NULL,
+			is_output_displayed ? ( FMAExecQueueDoneFunc ) on_display_output_done : NULL, NULL );
+
+	g_free( wdir );
+	g_free( wdir_nq );
 }
 
 static gchar *
@@ -657,65 +718,72 @@ fma_tokens_command_for_terminal( const gchar *pattern, const gchar *command )
 }
 
 /*
- * fma_tokens_is_singular_exec:
- * @tokens: the current #FMATokens object.
- * @exec: the to be executed command-line before having been parsed
+ * returns the per-file values of the @field, building them at first use
  *
- * Returns: %TRUE if the first relevant parameter found in @exec
- * command-line is of singular form, %FALSE else.
+ * the object is const for the caller, but the fields are only a cache
+ * of the selection
  */
-static gboolean
-is_singular_exec( const FMATokens *tokens, const gchar *exec )
+static gchar **
+get_field( const FMATokens *tokens, guint field )
 {
-	gboolean singular;
-	gboolean found;
-	gchar *iter;
+	if( !tokens->private->fields[field] && tokens->private->selection ){
+		build_field(( FMATokens * ) tokens, field );
+	}
 
-	singular = FALSE;
-	found = FALSE;
-	iter = ( gchar * ) exec;
+	return( tokens->private->fields[field] );
+}
 
-	while(( iter = g_strstr_len( iter, -1, "%" )) != NULL && !found ){
+static void
+build_field( FMATokens *tokens, guint field )
+{
+	static const gchar *thisfn = "fma_tokens_build_field";
+	FMASelection *selection;
+	gchar **values, **basenames;
+	gint64 elapsed;
+	guint i;
 
-		switch( iter[1] ){
-			case 'b':
-			case 'd':
-			case 'f':
-			case 'm':
-			case 'o':
-			case 'u':
-			case 'w':
-			case 'x':
-				found = TRUE;
-				singular = TRUE;
-				break;
+	elapsed = g_get_monotonic_time();
 
-			case 'B':
-			case 'D':
-			case 'F':
-			case 'M':
-			case 'O':
-			case 'U':
-			case 'W':
-			case 'X':
-				found = TRUE;
-				singular = FALSE;
-				break;
+	/* both are got from the same split of the basename
+	 */
+	if( field == TOKEN_BASENAME_WOEXT || field == TOKEN_EXT ){
+		basenames = get_field( tokens, TOKEN_BASENAME );
+		tokens->private->fields[TOKEN_BASENAME_WOEXT] = g_new0( gchar *, tokens->private->count );
+		tokens->private->fields[TOKEN_EXT] = g_new0( gchar *, tokens->private->count );
+		for( i = 0 ; i < tokens->private->count && basenames ; ++i ){
+			fma_core_utils_dir_split_ext( basenames[i],
+					&tokens->private->fields[TOKEN_BASENAME_WOEXT][i], &tokens->private->fields[TOKEN_EXT][i] );
+		}
 
-			/* all other parameters are irrelevant according to DES-EMA
-			 * c: selection count
-			 * h: hostname
-			 * n: username
-			 * p: port
-			 * s: scheme
-			 * %: %
-			 */
+	} else {
+		values = g_new0( gchar *, tokens->private->count );
+		selection = tokens->private->selection;
+
+		for( i = 0 ; i < tokens->private->count ; ++i ){
+			switch( field ){
+				case TOKEN_URI:
+					values[i] = g_strdup( fma_selection_peek_uri( selection, i ));
+					break;
+				case TOKEN_FILENAME:
+					values[i] = g_strdup( fma_selection_peek_filename( selection, i ));
+					break;
+				case TOKEN_BASEDIR:
+					values[i] = g_strdup( fma_selection_peek_dirname( selection, i ));
+					break;
+				case TOKEN_BASENAME:
+					values[i] = g_strdup( fma_selection_peek_basename( selection, i ));
+					break;
+				case TOKEN_MIMETYPE:
+					values[i] = g_strdup( fma_selection_peek_mimetype( selection, i ));
+					break;
+			}
 		}
 
-		iter += 2;			/* skip the % sign and the character after */
+		tokens->private->fields[field] = values;
 	}
 
-	return( singular );
+	g_debug( "%s: tokens=%p, field=%u, count=%u, elapsed=%" G_GINT64_FORMAT "us",
+			thisfn, ( void * ) tokens, field, tokens->private->count, g_get_monotonic_time() - elapsed );
 }
 
 /*
@@ -723,8 +791,6 @@ is_singular_exec( const FMATokens *tokens, const gchar *exec )
  * @tokens: a #FMATokens object.
  * @input: the input string, may or may not contain tokens.
  * @i: the number of the iteration in a multiple selection, starting with zero.
- * @utf8: whether the @input string is UTF-8 encoded, or a standard ASCII
- *  string.
  * @quoted: whether the filenames have to be quoted (should be %TRUE when
  *  about to execute a command).
  *
@@ -732,93 +798,113 @@ is_singular_exec( const FMATokens *tokens, const gchar *exec )
  * of plural form. In the case of a multiple selection, singular form
  * commands are executed one time for each element of the selection
  *
- * Returns: a #GSList which contains two fields: the command and its parameters.
- * The returned #GSList should be fma_core_utils_slist_free() by the caller.
+ * Returns: the expanded string, as a newly allocated string which should
+ * be g_free() by the caller, or %NULL if @input is %NULL.
  */
 static gchar *
-parse_singular( const FMATokens *tokens, const gchar *input, guint i, gboolean utf8, gboolean quoted )
+parse_singular( const FMATokens *tokens, const gchar *input, guint i, gboolean quoted )
 {
-	static const gchar *thisfn = "fma_tokens_parse_singular";
-	GString *output;
-	gchar *iter, *prev_iter;
-	const gchar *nth;
-
-	g_debug( "%s: tokens=%p, input=%s, i=%d, utf8=%s, quoted=%s",
-			thisfn, ( void * ) tokens, input, i, utf8 ? "true":"false", quoted ? "true":"false" );
-
-	output = g_string_new( "" );
+	FMATemplate *template;
+	gchar *output;
 
-	/* return NULL if input is NULL
-	 */
 	if( !input ){
-		return( g_string_free( output, TRUE ));
+		return( NULL );
 	}
 
-	/* return an empty string if input is empty
-	 */
-	if( utf8 ){
-		if( !g_utf8_strlen( input, -1 )){
-			return( g_string_free( output, FALSE ));
-		}
-	} else {
-		if( !strlen( input )){
-			return( g_string_free( output, FALSE ));
-		}
+	if( !strchr( input, '%' )){
+		return( g_strdup( input ));
 	}
 
-	iter = ( gchar * ) input;
-	prev_iter = iter;
+	template = fma_template_get( input );
+	output = expand_template( tokens, template, i, 0, tokens->private->count, quoted );
+	fma_template_unref( template );
 
-	while(( iter = g_strstr_len( iter, -1, "%" ))){
-		output = g_string_append_len( output, prev_iter, strlen( prev_iter ) - strlen( iter ));
+	return( output );
+}
+
+/*
+ * expand_template:
+ * @tokens: a #FMATokens object.
+ * @template: the compiled string.
+ * @i: the number of the iteration in a multiple selection, starting with zero.
+ * @start: the index of the first file of the plural parameters.
+ * @end: the index after the last file of the plural parameters.
+ * @quoted: whether the filenames have to be quoted.
+ *
+ * Concatenates the literals and the expanded parameters of the @template.
+ * The plural parameters, as well as the count of files, only consider
+ * the [@start, @end[ range of the selection.
+ *
+ * Returns: the expanded string, as a newly allocated string which should
+ * be g_free() by the caller.
+ */
+static gchar *
+expand_template( const FMATokens *tokens, const FMATemplate *template, guint i, guint start, guint end, gboolean quoted )
+{
+	static const gchar *thisfn = "fma_tokens_expand_template";
+	const FMATemplateSegment *segments;
+	const gchar *source;
+	GString *output;
+	gchar **values;
+	guint count, is;
+
+	g_debug( "%s: tokens=%p, input=%s, i=%d, quoted=%s",
+			thisfn, ( void * ) tokens, fma_template_get_source( template ), i, quoted ? "true":"false" );
+
+	source = fma_template_get_source( template );
+	segments = fma_template_get_segments( template, &count );
+	output = g_string_sized_new( strlen( source ));
+
+	for( is = 0 ; is < count ; ++is ){
+
+		switch( segments[is].token ){
+			case 0:
+				output = g_string_append_len( output, source+segments[is].start, segments[is].len );
+				break;
 
-		switch( iter[1] ){
 			case 'b':
-				if( tokens->private->basenames ){
-					nth = ( const gchar * ) g_slist_nth_data( tokens->private->basenames, i );
-					if( nth ){
-						output = quote_string( output, nth, quoted );
-					}
+				values = get_field( tokens, TOKEN_BASENAME );
+				if( values && i < tokens->private->count && values[i] ){
+					output = quote_string( output, values[i], quoted );
 				}
 				break;
 
 			case 'B':
-				if( tokens->private->basenames ){
-					output = quote_string_list( output, tokens->private->basenames, quoted );
+				values = get_field( tokens, TOKEN_BASENAME );
+				if( values ){
+					output = quote_string_list( output, values+start, end-start, quoted );
 				}
 				break;
 
 			case 'c':
-				g_string_append_printf( output, "%d", tokens->private->count );
+				g_string_append_printf( output, "%u", end-start );
 				break;
 
 			case 'd':
-				if( tokens->private->basedirs ){
-					nth = ( const gchar * ) g_slist_nth_data( tokens->private->basedirs, i );
-					if( nth ){
-						output = quote_string( output, nth, quoted );
-					}
+				values = get_field( tokens, TOKEN_BASEDIR );
+				if( values && i < tokens->private->count && values[i] ){
+					output = quote_string( output, values[i], quoted );
 				}
 				break;
 
 			case 'D':
-				if( tokens->private->basedirs ){
-					output = quote_string_list( output, tokens->private->basedirs, quoted );
+				values = get_field( tokens, TOKEN_BASEDIR );
+				if( values ){
+					output = quote_string_list( output, values+start, end-start, quoted );
 				}
 				break;
 
 			case 'f':
-				if( tokens->private->filenames ){
-					nth = ( const gchar * ) g_slist_nth_data( tokens->private->filenames, i );
-					if( nth ){
-						output = quote_string( output, nth, quoted );
-					}
+				values = get_field( tokens, TOKEN_FILENAME );
+				if( values && i < tokens->private->count && values[i] ){
+					output = quote_string( output, values[i], quoted );
 				}
 				break;
 
 			case 'F':
-				if( tokens->private->filenames ){
-					output = quote_string_list( output, tokens->private->filenames, quoted );
+				values = get_field( tokens, TOKEN_FILENAME );
+				if( values ){
+					output = quote_string_list( output, values+start, end-start, quoted );
 				}
 				break;
 
@@ -831,17 +917,16 @@ parse_singular( const FMATokens *tokens, const gchar *input, guint i, gboolean u
 			/* mimetypes are never quoted
 			 */
 			case 'm':
-				if( tokens->private->mimetypes ){
-					nth = ( const gchar * ) g_slist_nth_data( tokens->private->mimetypes, i );
-					if( nth ){
-						output = quote_string( output, nth, FALSE );
-					}
+				values = get_field( tokens, TOKEN_MIMETYPE );
+				if( values && i < tokens->private->count && values[i] ){
+					output = quote_string( output, values[i], FALSE );
 				}
 				break;
 
 			case 'M':
-				if( tokens->private->mimetypes ){
-					output = quote_string_list( output, tokens->private->mimetypes, FALSE );
+				values = get_field( tokens, TOKEN_MIMETYPE );
+				if( values ){
+					output = quote_string_list( output, values+start, end-start, FALSE );
 				}
 				break;
 
@@ -871,47 +956,44 @@ parse_singular( const FMATokens *tokens, const gchar *input, guint i, gboolean u
 				break;
 
 			case 'u':
-				if( tokens->private->uris ){
-					nth = ( const gchar * ) g_slist_nth_data( tokens->private->uris, i );
-					if( nth ){
-						output = quote_string( output, nth, quoted );
-					}
+				values = get_field( tokens, TOKEN_URI );
+				if( values && i < tokens->private->count && values[i] ){
+					output = quote_string( output, values[i], quoted );
 				}
 				break;
 
 			case 'U':
-				if( tokens->private->uris ){
-					output = quote_string_list( output, tokens->private->uris, quoted );
+				values = get_field( tokens, TOKEN_URI );
+				if( values ){
+					output = quote_string_list( output, values+start, end-start, quoted );
 				}
 				break;
 
 			case 'w':
-				if( tokens->private->basenames_woext ){
-					nth = ( const gchar * ) g_slist_nth_data( tokens->private->basenames_woext, i );
-					if( nth ){
-						output = quote_string( output, nth, quoted );
-					}
+				values = get_field( tokens, TOKEN_BASENAME_WOEXT );
+				if( values && i < tokens->private->count && values[i] ){
+					output = quote_string( output, values[i], quoted );
 				}
 				break;
 
 			case 'W':
-				if( tokens->private->basenames_woext ){
-					output = quote_string_list( output, tokens->private->basenames_woext, quoted );
+				values = get_field( tokens, TOKEN_BASENAME_WOEXT );
+				if( values ){
+					output = quote_string_list( output, values+start, end-start, quoted );
 				}
 				break;
 
 			case 'x':
-				if( tokens->private->exts ){
-					nth = ( const gchar * ) g_slist_nth_data( tokens->private->exts, i );
-					if( nth ){
-						output = quote_string( output, nth, quoted );
-					}
+				values = get_field( tokens, TOKEN_EXT );
+				if( values && i < tokens->private->count && values[i] ){
+					output = quote_string( output, values[i], quoted );
 				}
 				break;
 
 			case 'X':
-				if( tokens->private->exts ){
-					output = quote_string_list( output, tokens->private->exts, quoted );
+				values = get_field( tokens, TOKEN_EXT );
+				if( values ){
+					output = quote_string_list( output, values+start, end-start, quoted );
 				}
 				break;
 
@@ -922,15 +1004,329 @@ parse_singular( const FMATokens *tokens, const gchar *input, guint i, gboolean u
 				break;
 		}
 
-		iter += 2;			/* skip the % sign and the character after */
-		prev_iter = iter;	/* store the new start of the string */
 	}
 
-	output = g_string_append_len( output, prev_iter, strlen( prev_iter ));
-
 	return( g_string_free( output, FALSE ));
 }
 
+/*
+ * xargs-like execution of a plural-form command: the selection is split
+ * into the largest ranges whose expanded command fits in the system
+ * limit, and the command is pushed once per range
+ *
+ * the size of a range is estimated from the quoted length of the values
+ * of each plural parameter, plus one pointer per argument; when the
+ * command is run through a terminal or a shell, from the length of the
+ * values once quoted again (see fma_tokens_command_for_terminal())
+ */
+static void
+execute_plural_chunked( const FMATokens *tokens, const FMATemplate *template, const FMAObjectProfile *profile, gboolean use_argv )
+{
+	static const gchar *thisfn = "fma_tokens_execute_plural_chunked";
+	gchar *execution_mode;
+	gboolean requoted;
+	gsize limit;
+	guint *ends, chunks, i, start;
+
+	execution_mode = fma_object_get_execution_mode( profile );
+	limit = fma_tokens_get_arg_limit( execution_mode );
+	requoted = ( strcmp( execution_mode, "Normal" ) != 0 );
+	g_free( execution_mode );
+
+	ends = plural_chunks( tokens, template, requoted, limit, &chunks );
+
+	for( i = 0, start = 0 ; i < chunks ; start = ends[i++] ){
+		execute_action_unit( tokens, template, profile, use_argv, start, start, ends[i] );
+	}
+
+	g_debug( "%s: count=%u, limit=%" G_GSIZE_FORMAT ", chunks=%u", thisfn, tokens->private->count, limit, chunks );
+
+	g_free( ends );
+}
+
+/*
+ * splits the selection into the largest ranges whose expanded @template
+ * is estimated to fit in @limit; @requoted tells whether the expanded
+ * command will be quoted again as a whole
+ *
+ * returns the index after the last file of each range, as a newly
+ * allocated array of @chunks elements
+ */
+static guint *
+plural_chunks( const FMATokens *tokens, const FMATemplate *template, gboolean requoted, gsize limit, guint *chunks )
+{
+	const FMATemplateSegment *segments;
+	gsize fixed, size, *costs;
+	gchar **values, *quoted, *command;
+	guint count, is, i, start, end;
+	GArray *ends;
+	gint field;
+
+	segments = fma_template_get_segments( template, &count );
+	costs = g_new0( gsize, tokens->private->count );
+
+	/* the fixed part of the command: the literals, the singular and
+	 * the per-selection parameters
+	 */
+	command = expand_template( tokens, template, 0, 0, 0, TRUE );
+	fixed = ( requoted ? quoted_length( command, TRUE ) + 2 : strlen( command )) + 1 + 16;
+	g_free( command );
+
+	for( is = 0 ; is < count ; ++is ){
+		field = get_plural_field( segments[is].token );
+		if( field >= 0 ){
+			values = get_field( tokens, field );
+			for( i = 0 ; i < tokens->private->count ; ++i ){
+				if( values[i] ){
+					quoted = g_shell_quote( values[i] );
+					costs[i] += quoted_length( quoted, requoted ) + 1 + sizeof( gchar * );
+					g_free( quoted );
+				}
+			}
+		}
+	}
+
+	ends = g_array_new( FALSE, FALSE, sizeof( guint ));
+
+	for( start = 0 ; start < tokens->private->count ; start = end ){
+		size = fixed;
+
+		/* at least one file per chunk, even if too large */
+		for( end = start ; end < tokens->private->count && ( end == start || size + costs[end] <= limit ) ; ++end ){
+			size += costs[end];
+		}
+
+		g_array_append_val( ends, end );
+	}
+
+	g_free( costs );
+
+	*chunks = ends->len;
+
+	return(( guint * ) g_array_free( ends, FALSE ));
+}
+
+/*
+ * the length of @str, once quoted again by g_shell_quote() if
+ * @requoted: each single quote then becomes four characters; the two
+ * enclosing quotes are counted once, with the fixed part of the command
+ */
+static gsize
+quoted_length( const gchar *str, gboolean requoted )
+{
+	gsize length;
+	const gchar *it;
+
+	length = strlen( str );
+
+	if( requoted ){
+		for( it = str ; *it ; ++it ){
+			if( *it == '\'' ){
+				length += 3;
+			}
+		}
+	}
+
+	return( length );
+}
+
+/*
+ * fma_tokens_get_arg_limit:
+ * @execution_mode: the execution mode of the profile.
+ *
+ * The room left for the arguments of a command: the system limit, minus
+ * the environment and a margin, as xargs does.
+ *
+ * When the command is run through a terminal or a shell, it is passed
+ * as a single, quoted again, argument: it is then also limited by the
+ * maximal length of one argument, minus the same margin. The growth
+ * of the command with this second quoting is accounted for by
+ * fma_tokens_get_plural_chunks().
+ *
+ * Returns: the maximal size of the arguments of a plural-form command.
+ */
+gsize
+fma_tokens_get_arg_limit( const gchar *execution_mode )
+{
+	glong arg_max;
+	gsize limit, env;
+	gchar **envp, **it;
+
+	arg_max = sysconf( _SC_ARG_MAX );
+	limit = arg_max > 0 ? ( gsize ) arg_max : _POSIX_ARG_MAX;
+
+	envp = g_get_environ();
+	for( env = 0, it = envp ; *it ; ++it ){
+		env += strlen( *it ) + 1 + sizeof( gchar * );
+	}
+	g_strfreev( envp );
+
+	limit = ( limit > env + ARG_MARGIN + _POSIX_ARG_MAX ) ? limit - env - ARG_MARGIN : _POSIX_ARG_MAX;
+
+	if( strcmp( execution_mode, "Normal" )){
+		limit = MIN( limit, FMA_TOKENS_ARG_STRLEN_MAX - ARG_MARGIN );
+	}
+
+	return( limit );
+}
+
+/*
+ * expand_template_argv:
+ * @tokens: a #FMATokens object.
+ * @template: the compiled command.
+ * @i: the number of the iteration in a multiple selection, starting with zero.
+ * @start: the index of the first file of the plural parameters.
+ * @end: the index after the last file of the plural parameters.
+ *
+ * Builds the argument vector of the @template words (see
+ * fma_template_get_words()): each value is inserted as is, and each file
+ * of a plural parameter becomes its own argument, so that nothing has to
+ * be quoted nor re-parsed.
+ *
+ * Returns: the %NULL-terminated argument vector, which should be
+ * g_strfreev() by the caller.
+ */
+static gchar **
+expand_template_argv( const FMATokens *tokens, const FMATemplate *template, guint i, guint start, guint end )
+{
+	const FMATemplateSegment *words;
+	const gchar *unquoted;
+	GPtrArray *argv;
+	GString *word;
+	gchar **values;
+	gchar token;
+	guint count, is, iv;
+	gint field;
+	gboolean first;
+
+	words = fma_template_get_words( template, &count );
+	unquoted = fma_template_get_unquoted( template );
+	argv = g_ptr_array_new();
+	word = NULL;
+
+	for( is = 0 ; is < count ; ++is ){
+		token = words[is].token;
+		field = get_plural_field( g_ascii_toupper( token ));
+
+		if( token == 0 ){
+			word = argv_append( word, NULL );
+			word = g_string_append_len( word, unquoted+words[is].start, words[is].len );
+
+		} else if( token == FMA_TEMPLATE_WORD_BREAK ){
+			argv_push( argv, &word );
+
+		} else if( field >= 0 && g_ascii_isupper( token )){
+			values = get_field( tokens, field );
+			first = TRUE;
+			for( iv = start ; values && iv < end ; ++iv ){
+				if( values[iv] ){
+					if( !first ){
+						argv_push( argv, &word );
+					}
+					word = argv_append( word, values[iv] );
+					first = FALSE;
+				}
+			}
+
+		} else if( field >= 0 ){
+			values = get_field( tokens, field );
+			if( values && i < tokens->private->count && values[i] ){
+				word = argv_append( word, values[i] );
+			}
+
+		} else {
+			switch( token ){
+				case 'c':
+					word = argv_append( word, NULL );
+					g_string_append_printf( word, "%u", end-start );
+					break;
+
+				case 'h':
+					if( tokens->private->hostname ){
+						word = argv_append( word, tokens->private->hostname );
+					}
+					break;
+
+				case 'n':
+					if( tokens->private->username ){
+						word = argv_append( word, tokens->private->username );
+					}
+					break;
+
+				case 'p':
+					if( tokens->private->port > 0 ){
+						word = argv_append( word, NULL );
+						g_string_append_printf( word, "%d", tokens->private->port );
+					}
+					break;
+
+				case 's':
+					if( tokens->private->scheme ){
+						word = argv_append( word, tokens->private->scheme );
+					}
+					break;
+			}
+		}
+	}
+
+	argv_push( argv, &word );
+	g_ptr_array_add( argv, NULL );
+
+	return(( gchar ** ) g_ptr_array_free( argv, FALSE ));
+}
+
+/*
+ * appends @str to the current @word, creating it if needed; a %NULL @str
+ * only makes sure that the word exists
+ */
+static GString *
+argv_append( GString *word, const gchar *str )
+{
+	if( !word ){
+		word = g_string_new( "" );
+	}
+	if( str ){
+		word = g_string_append( word, str );
+	}
+
+	return( word );
+}
+
+/*
+ * terminates the current @word, if any, as an argument
+ */
+static void
+argv_push( GPtrArray *argv, GString **word )
+{
+	if( *word ){
+		g_ptr_array_add( argv, g_string_free( *word, FALSE ));
+		*word = NULL;
+	}
+}
+
+static gint
+get_plural_field( gchar token )
+{
+	switch( token ){
+		case 'B':
+			return( TOKEN_BASENAME );
+		case 'D':
+			return( TOKEN_BASEDIR );
+		case 'F':
+			return( TOKEN_FILENAME );
+		case 'M':
+			return( TOKEN_MIMETYPE );
+		case 'U':
+			return( TOKEN_URI );
+		case 'W':
+			return( TOKEN_BASENAME_WOEXT );
+		case 'X':
+			return( TOKEN_EXT );
+	}
+
+	return( -1 );
+}
+
 static GString *
 quote_string( GString *input, const gchar *name, gboolean quoted )
 {
@@ -949,25 +1345,31 @@ quote_string( GString *input, const gchar *name, gboolean quoted )
 }
 
 static GString *
-quote_string_list( GString *input, GSList *names, gboolean quoted )
+quote_string_list( GString *input, gchar **names, guint count, gboolean quoted )
 {
-	GSList *it;
 	gchar *tmp;
+	guint i;
+	gboolean first;
 
-	if( quoted ){
-		GSList *quoted_names = NULL;
-		for( it = names ; it ; it = it->next ){
-			quoted_names = g_slist_append( quoted_names, g_shell_quote(( const gchar * ) it->data ));
+	first = TRUE;
+
+	for( i = 0 ; i < count ; ++i ){
+		if( !names[i] ){
+			continue;
+		}
+		if( !first ){
+			input = g_string_append_c( input, ' ' );
 		}
-		tmp = fma_core_utils_slist_join_at_end( quoted_names, " " );
-		fma_core_utils_slist_free( quoted_names );
+		first = FALSE;
+		if( quoted ){
+			tmp = g_shell_quote( names[i] );
+			input = g_string_append( input, tmp );
+			g_free( tmp );
 
-	} else {
-		tmp = fma_core_utils_slist_join_at_end( g_slist_reverse( names ), " " );
+		} else {
+			input = g_string_append( input, names[i] );
+		}
 	}
 
-	input = g_string_append( input, tmp );
-	g_free( tmp );
-
 	return( input );
 }
@@ -48,8 +48,8 @@
  * Adding a parameter requires updating of:
  * - docs/manual/C/figures/fma-legend.png screenshot
  * - docs/manual/C/fma-execution.xml "Multiple execution" paragraph
- * - src/core/fma-tokens.c::is_singular_exec() function
- * - src/core/fma-tokens.c::parse_singular() function
+ * - src/core/fma-template.c::template_compile() function
+ * - src/core/fma-tokens.c::expand_template() function
  * - src/core/fma-object-profile-factory.c:FMAFO_DATA_PARAMETERS comment
  * - src/ui/fma-legend.ui:LegendDialog labels
  *
@@ -81,8 +81,14 @@
 
 #include <api/fma-object-profile.h>
 
+#include "fma-selection.h"
+
 G_BEGIN_DECLS
 
+/* the maximal length of a single argument (MAX_ARG_STRLEN on Linux)
+ */
+#define FMA_TOKENS_ARG_STRLEN_MAX				131072
+
 #define FMA_TYPE_TOKENS                ( fma_tokens_get_type())
 #define FMA_TOKENS( object )           ( G_TYPE_CHECK_INSTANCE_CAST( object, FMA_TYPE_TOKENS, FMATokens ))
 #define FMA_TOKENS_CLASS( klass )      ( G_TYPE_CHECK_CLASS_CAST( klass, FMA_TYPE_TOKENS, FMATokensClass ))
@@ -111,9 +117,13 @@ typedef struct {
 GType      fma_tokens_get_type            ( void );
 
 FMATokens *fma_tokens_new_for_example     ( void );
-FMATokens *fma_tokens_new_from_selection  ( GList *selection );
+FMATokens *fma_tokens_new_from_selection  ( FMASelection *selection );
 
 gchar     *fma_tokens_parse_for_display   ( const FMATokens *tokens, const gchar *string, gboolean utf8 );
+gchar     *fma_tokens_expand_command      ( const FMATokens *tokens, const gchar *command, guint i, guint start, guint end );
+gchar    **fma_tokens_expand_argv         ( const FMATokens *tokens, const gchar *command, guint i, guint start, guint end );
+guint     *fma_tokens_get_plural_chunks   ( const FMATokens *tokens, const gchar *command, const gchar *execution_mode, gsize limit, guint *chunks );
+gsize      fma_tokens_get_arg_limit       ( const gchar *execution_mode );
 void       fma_tokens_execute_action      ( const FMATokens *tokens, const FMAObjectProfile *profile );
 
 gchar     *fma_tokens_command_for_terminal( const gchar *pattern, const gchar *command );
@@ -0,0 +1,386 @@
+/*
+ * FileManager-Actions
+ * A file-manager extension which offers configurable context menu actions.
+ *
+ * Copyright (C) 2005 The GNOME Foundation
+ * Copyright (C) 2006-2008 Frederic Ruaudel and others (see AUTHORS)
+ * Copyright (C) 2009-2015 Pierre Wieser and others (see AUTHORS)
+ *
+ * FileManager-Actions is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * FileManager-Actions is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FileManager-Actions; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Frederic Ruaudel <grumz@grumz.net>
+ *   Rodrigo Moya <rodrigo@gnome-db.org>
+ *   Pierre Wieser <pwieser@trychlos.org>
+ *   ... and many others (see AUTHORS)
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include <api/fma-core-utils.h>
+
+#include <core/fma-selection-classes.h>
+
+#include "fma-menu-cache.h"
+
+/* the cache itself
+ */
+struct _FMAMenuCache {
+	guint       generation;
+	GList      *entries;				/* most recently used first */
+	GHashTable *volatiles;				/* item -> VOLATILE_YES|VOLATILE_NO */
+};
+
+/* the candidates evaluated for one selection signature
+ */
+struct _FMAMenuCacheEntry {
+	FMAMenuCache *cache;
+	gchar        *signature;
+	GHashTable   *decisions;			/* item -> decision */
+};
+
+enum {
+	VOLATILE_YES = 1,
+	VOLATILE_NO
+};
+
+static guint st_max_entries = 16;		/* count of remembered signatures */
+
+static gchar   *signature_new( guint target, FMASelectionClasses *classes );
+static void     signature_append_set( GString *signature, const gchar *prefix, GHashTable *set );
+static void     entry_free( FMAMenuCacheEntry *entry );
+static gboolean is_volatile( FMAMenuCache *cache, const FMAObjectItem *item );
+static gboolean is_volatile_context( const FMAIContext *context );
+static gboolean is_volatile_string( gchar *str );
+
+/*
+ * fma_menu_cache_new:
+ *
+ * Returns: a newly allocated #FMAMenuCache, which should be
+ * fma_menu_cache_free() by the caller.
+ */
+FMAMenuCache *
+fma_menu_cache_new( void )
+{
+	FMAMenuCache *cache;
+
+	cache = g_new0( FMAMenuCache, 1 );
+	cache->volatiles = g_hash_table_new( g_direct_hash, g_direct_equal );
+
+	return( cache );
+}
+
+/*
+ * fma_menu_cache_free:
+ * @cache: this #FMAMenuCache.
+ *
+ * Releases the @cache.
+ */
+void
+fma_menu_cache_free( FMAMenuCache *cache )
+{
+	if( cache ){
+		fma_menu_cache_invalidate( cache );
+		g_hash_table_destroy( cache->volatiles );
+		g_free( cache );
+	}
+}
+
+/*
+ * fma_menu_cache_invalidate:
+ * @cache: this #FMAMenuCache.
+ *
+ * Forgets all remembered signatures.
+ *
+ * This must be called each time something which may have an effect on
+ * the candidate status of the items changes.
+ */
+void
+fma_menu_cache_invalidate( FMAMenuCache *cache )
+{
+	static const gchar *thisfn = "fma_menu_cache_invalidate";
+
+	g_return_if_fail( cache );
+
+	g_debug( "%s: cache=%p, entries=%d", thisfn, ( void * ) cache, g_list_length( cache->entries ));
+
+	g_list_foreach( cache->entries, ( GFunc ) entry_free, NULL );
+	g_list_free( cache->entries );
+	cache->entries = NULL;
+
+	g_hash_table_remove_all( cache->volatiles );
+}
+
+/*
+ * fma_menu_cache_lookup:
+ * @cache: this #FMAMenuCache.
+ * @generation: the current generation of the FMAPivot items tree.
+ * @target: the current target.
+ * @classes: the equivalence classes of the current selection.
+ *
+ * Returns: the #FMAMenuCacheEntry which matches the signature of the
+ * selection. The returned entry may be empty if the signature has not
+ * been seen yet. It is owned by the @cache, and is only valid until the
+ * next call to fma_menu_cache_lookup().
+ */
+FMAMenuCacheEntry *
+fma_menu_cache_lookup( FMAMenuCache *cache, guint generation, guint target, FMASelectionClasses *classes )
+{
+	static const gchar *thisfn = "fma_menu_cache_lookup";
+	FMAMenuCacheEntry *entry;
+	gchar *signature;
+	GList *it;
+
+	g_return_val_if_fail( cache, NULL );
+
+	if( generation != cache->generation ){
+		g_debug( "%s: generation changed from %u to %u", thisfn, cache->generation, generation );
+		fma_menu_cache_invalidate( cache );
+		cache->generation = generation;
+	}
+
+	entry = NULL;
+	signature = signature_new( target, classes );
+
+	for( it = cache->entries ; it && !entry ; it = it->next ){
+		if( !strcmp((( FMAMenuCacheEntry * ) it->data )->signature, signature )){
+			entry = ( FMAMenuCacheEntry * ) it->data;
+			cache->entries = g_list_remove_link( cache->entries, it );
+			g_list_free( it );
+		}
+	}
+
+	if( entry ){
+		g_debug( "%s: found entry=%p with %u decisions",
+				thisfn, ( void * ) entry, g_hash_table_size( entry->decisions ));
+		g_free( signature );
+
+	} else {
+		entry = g_new0( FMAMenuCacheEntry, 1 );
+		entry->cache = cache;
+		entry->signature = signature;
+		entry->decisions = g_hash_table_new( g_direct_hash, g_direct_equal );
+		g_debug( "%s: new entry=%p", thisfn, ( void * ) entry );
+
+		if( g_list_length( cache->entries ) >= st_max_entries ){
+			it = g_list_last( cache->entries );
+			entry_free(( FMAMenuCacheEntry * ) it->data );
+			cache->entries = g_list_delete_link( cache->entries, it );
+		}
+	}
+
+	cache->entries = g_list_prepend( cache->entries, entry );
+
+	return( entry );
+}
+
+/*
+ * fma_menu_cache_get:
+ * @entry: the current #FMAMenuCacheEntry.
+ * @item: the #FMAObjectItem to be checked.
+ * @value: [out]: the remembered decision.
+ *
+ * Returns: %TRUE if a decision has been remembered for this @item,
+ * %FALSE else.
+ */
+gboolean
+fma_menu_cache_get( const FMAMenuCacheEntry *entry, const FMAObjectItem *item, guint *value )
+{
+	gpointer found;
+
+	if( entry && g_hash_table_lookup_extended( entry->decisions, item, NULL, &found )){
+		*value = GPOINTER_TO_UINT( found );
+		return( TRUE );
+	}
+
+	return( FALSE );
+}
+
+/*
+ * fma_menu_cache_set:
+ * @entry: the current #FMAMenuCacheEntry.
+ * @item: the #FMAObjectItem which has been checked.
+ * @value: the decision to be remembered.
+ *
+ * Remembers the decision for this @item, unless the @item is volatile.
+ */
+void
+fma_menu_cache_set( FMAMenuCacheEntry *entry, const FMAObjectItem *item, guint value )
+{
+	if( entry && !is_volatile( entry->cache, item )){
+		g_hash_table_insert( entry->decisions, ( gpointer ) item, GUINT_TO_POINTER( value ));
+	}
+}
+
+/*
+ * The signature gathers all the data the FMAIContext conditions may
+ * depend on, but the basenames. Each data is only taken once, sorted,
+ * and length-prefixed so that any character may be found in a dirname.
+ */
+static gchar *
+signature_new( guint target, FMASelectionClasses *classes )
+{
+	GHashTable *mimetypes, *schemes, *dirnames;
+	GString *signature;
+	FMASelection *selection;
+	const guint *representatives;
+	const gchar *str;
+	guint i, count;
+
+	mimetypes = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, NULL );
+	schemes = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, NULL );
+	dirnames = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, NULL );
+
+	selection = fma_selection_classes_get_selection( classes );
+
+	representatives = fma_selection_classes_get( classes, SELECTION_CLASS_MIMETYPE, &count );
+	for( i = 0 ; i < count ; ++i ){
+		str = fma_selection_peek_mimetype( selection, representatives[i] );
+		g_hash_table_add( mimetypes, g_strdup_printf( "%s%s",
+				fma_selection_get_file_type( selection, representatives[i] ) == G_FILE_TYPE_REGULAR ? "r:" : "-:", str ? str : "" ));
+	}
+
+	representatives = fma_selection_classes_get( classes, SELECTION_CLASS_SCHEME, &count );
+	for( i = 0 ; i < count ; ++i ){
+		str = fma_selection_peek_scheme( selection, representatives[i] );
+		g_hash_table_add( schemes, g_strdup( str ? str : "" ));
+	}
+
+	representatives = fma_selection_classes_get( classes, SELECTION_CLASS_DIRNAME, &count );
+	for( i = 0 ; i < count ; ++i ){
+		str = fma_selection_peek_dirname( selection, representatives[i] );
+		g_hash_table_add( dirnames, g_strdup( str ? str : "" ));
+	}
+
+	signature = g_string_new( "" );
+	g_string_append_printf( signature, "t%u;c%u;", target, fma_selection_classes_get_count( classes ));
+	signature_append_set( signature, "m", mimetypes );
+	signature_append_set( signature, "s", schemes );
+	signature_append_set( signature, "d", dirnames );
+
+	g_hash_table_destroy( dirnames );
+	g_hash_table_destroy( schemes );
+	g_hash_table_destroy( mimetypes );
+
+	return( g_string_free( signature, FALSE ));
+}
+
+static void
+signature_append_set( GString *signature, const gchar *prefix, GHashTable *set )
+{
+	GList *keys, *it;
+
+	keys = g_list_sort( g_hash_table_get_keys( set ), ( GCompareFunc ) strcmp );
+	g_string_append_printf( signature, "%s%u;", prefix, g_list_length( keys ));
+
+	for( it = keys ; it ; it = it->next ){
+		g_string_append_printf( signature, "%lu:%s", ( unsigned long ) strlen(( const gchar * ) it->data ), ( const gchar * ) it->data );
+	}
+
+	g_list_free( keys );
+}
+
+static void
+entry_free( FMAMenuCacheEntry *entry )
+{
+	g_hash_table_destroy( entry->decisions );
+	g_free( entry->signature );
+	g_free( entry );
+}
+
+/*
+ * an item is volatile if its candidate status depends on something which
+ * is not part of the selection signature; for an action, this includes
+ * the conditions of its profiles
+ */
+static gboolean
+is_volatile( FMAMenuCache *cache, const FMAObjectItem *item )
+{
+	static const gchar *thisfn = "fma_menu_cache_is_volatile";
+	guint status;
+	gboolean volatile_item;
+	GList *ip;
+
+	status = GPOINTER_TO_UINT( g_hash_table_lookup( cache->volatiles, item ));
+
+	if( !status ){
+		volatile_item = is_volatile_context( FMA_ICONTEXT( item ));
+
+		if( !volatile_item && FMA_IS_OBJECT_ACTION( item )){
+			for( ip = fma_object_get_items( item ) ; ip && !volatile_item ; ip = ip->next ){
+				volatile_item = is_volatile_context( FMA_ICONTEXT( ip->data ));
+			}
+		}
+
+		if( volatile_item ){
+			g_debug( "%s: item=%p is volatile, will not be cached", thisfn, ( void * ) item );
+		}
+
+		status = volatile_item ? VOLATILE_YES : VOLATILE_NO;
+		g_hash_table_insert( cache->volatiles, ( gpointer ) item, GUINT_TO_POINTER( status ));
+	}
+
+	return( status == VOLATILE_YES );
+}
+
+static gboolean
+is_volatile_context( const FMAIContext *context )
+{
+	gboolean volatile_context;
+	GSList *basenames, *capabilities;
+
+	volatile_context =
+			is_volatile_string( fma_object_get_try_exec( context )) ||
+			is_volatile_string( fma_object_get_show_if_registered( context )) ||
+			is_volatile_string( fma_object_get_show_if_true( context )) ||
+			is_volatile_string( fma_object_get_show_if_running( context ));
+
+	if( !volatile_context ){
+		basenames = fma_object_get_basenames( context );
+		volatile_context = ( basenames &&
+				( strcmp( basenames->data, "*" ) != 0 || g_slist_length( basenames ) > 1 ));
+		fma_core_utils_slist_free( basenames );
+	}
+
+	/* the capabilities are not part of the signature, so that the
+	 * access rights of the selected files do not have to be queried
+	 * when no item depends on them
+	 */
+	if( !volatile_context ){
+		capabilities = fma_object_get_capabilities( context );
+		volatile_context = ( capabilities != NULL );
+		fma_core_utils_slist_free( capabilities );
+	}
+
+	return( volatile_context );
+}
+
+/*
+ * takes ownership of @str
+ */
+static gboolean
+is_volatile_string( gchar *str )
+{
+	gboolean is_set;
+
+	is_set = ( str && strlen( str ));
+	g_free( str );
+
+	return( is_set );
+}
@@ -0,0 +1,75 @@
+/*
+ * FileManager-Actions
+ * A file-manager extension which offers configurable context menu actions.
+ *
+ * Copyright (C) 2005 The GNOME Foundation
+ * Copyright (C) 2006-2008 Frederic Ruaudel and others (see AUTHORS)
+ * Copyright (C) 2009-2015 Pierre Wieser and others (see AUTHORS)
+ *
+ * FileManager-Actions is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * FileManager-Actions is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FileManager-Actions; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Frederic Ruaudel <grumz@grumz.net>
+ *   Rodrigo Moya <rodrigo@gnome-db.org>
+ *   Pierre Wieser <pwieser@trychlos.org>
+ *   ... and many others (see AUTHORS)
+ */
+
+#ifndef __PLUGIN_MENU_FMA_MENU_CACHE_H__
+#define __PLUGIN_MENU_FMA_MENU_CACHE_H__
+
+/* @title: FMAMenuCache
+ * @short_description: The menu plugin candidates cache
+ * @include: plugin-menu/fma-menu-cache.h
+ *
+ * Each time the file manager asks for its context menu, we have to
+ * check all the items of the FMAPivot tree against the current
+ * selection. Most of the time, though, the user keeps clicking on the
+ * same kind of files in the same folder.
+ *
+ * The #FMAMenuCache remembers the outcome of the FMAIContext checks,
+ * keyed by a signature of the selection which gathers everything the
+ * conditions may depend on: the target, the count of selected items,
+ * and the distinct mimetypes, schemes and dirnames.
+ *
+ * Items whose conditions depend on something else (TryExec, ShowIfTrue,
+ * ShowIfRunning, ShowIfRegistered, basenames or capabilities) are said
+ * volatile: they are never cached and always checked again.
+ *
+ * The whole cache is flushed each time the FMAPivot generation changes,
+ * i.e. each time the items are reloaded.
+ */
+
+#include <api/fma-object-api.h>
+
+#include <core/fma-selection-classes.h>
+
+G_BEGIN_DECLS
+
+typedef struct _FMAMenuCache       FMAMenuCache;
+typedef struct _FMAMenuCacheEntry  FMAMenuCacheEntry;
+
+FMAMenuCache      *fma_menu_cache_new       ( void );
+void               fma_menu_cache_free      ( FMAMenuCache *cache );
+void               fma_menu_cache_invalidate( FMAMenuCache *cache );
+
+FMAMenuCacheEntry *fma_menu_cache_lookup    ( FMAMenuCache *cache, guint generation, guint target, FMASelectionClasses *classes );
+
+gboolean           fma_menu_cache_get       ( const FMAMenuCacheEntry *entry, const FMAObjectItem *item, guint *value );
+void               fma_menu_cache_set       ( FMAMenuCacheEntry *entry, const FMAObjectItem *item, guint value );
+
+G_END_DECLS
+
+#endif /* __PLUGIN_MENU_FMA_MENU_CACHE_H__ */
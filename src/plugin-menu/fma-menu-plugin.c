@@ -41,9 +41,12 @@
 
 #include <core/fma-pivot.h>
 #include <core/fma-about.h>
-#include <core/fma-selected-info.h>
+#include <core/fma-icontext-program.h>
+#include <core/fma-proc-snapshot.h>
+#include <core/fma-selection.h>
 #include <core/fma-tokens.h>
 
+#include "fma-menu-cache.h"
 #include "fma-menu-plugin.h"
 
 /* private class data
@@ -56,12 +59,29 @@ struct _FMAMenuPluginClassPrivate {
  */
 struct _FMAMenuPluginPrivate {
 	gboolean   dispose_has_run;
-	FMAPivot  *pivot;
-	gulong     items_changed_handler;
-	gulong     settings_changed_handler;
-	FMATimeout change_timeout;
+	FMAPivot     *pivot;
+	FMAMenuCache *cache;
+	gulong        items_changed_handler;
+	gulong        settings_changed_handler;
+	FMATimeout    change_timeout;
 };
 
+/* the data needed while building the file manager menu
+ */
+typedef struct {
+	FMAPivot                *pivot;
+	guint                   target;
+	FMASelection            *selection;
+	FMASelectionClasses     *classes;
+	FMAIContextProgramScope *scope;
+	FMATokens               *tokens;
+	FMAMenuCacheEntry       *entry;
+	FMAPivotIndexSet        *candidates;
+	gint64                  deadline;		/* the wall-clock budget, or zero */
+	gboolean                over;			/* whether the budget has been exhausted */
+}
+	BuildMenuData;
+
 static GObjectClass *st_parent_class  = NULL;
 static GType         st_actions_type  = 0;
 static gint          st_burst_timeout = 100;		/* burst timeout in msec */
@@ -78,21 +98,24 @@ static GList               *menu_provider_get_file_items( FileManagerMenuProvide
 	defined( HAVE_NEMO_MENU_PROVIDER_GET_TOOLBAR_ITEMS )
 static GList               *menu_provider_get_toolbar_items( FileManagerMenuProvider *provider, GtkWidget *window, FileManagerFileInfo *current_folder );
 #endif
-static GList               *selected_info_get_list_from_item( FileManagerFileInfo *item );
-static GList               *selected_info_get_list_from_list( GList *selection );
-static FMASelectedInfo     *new_from_file_manager_file_info( FileManagerFileInfo *item );
-static GList               *build_filemanager_menu( FMAMenuPlugin *plugin, guint target, GList *selection );
-static GList               *build_filemanager_menu_rec( GList *tree, guint target, GList *selection, FMATokens *tokens );
+static FMASelection        *selection_new_from_item( FileManagerFileInfo *item );
+static FMASelection        *selection_new_from_list( GList *nautilus_selection );
+static void                 add_from_file_manager_file_info( FMASelection *selection, FileManagerFileInfo *item );
+static GList               *build_filemanager_menu( FMAMenuPlugin *plugin, guint target, FMASelection *selection );
+static GList               *build_filemanager_menu_rec( GList *tree, BuildMenuData *build );
+static void                 prefetch_conditions_rec( GList *tree, BuildMenuData *build );
+static void                 collect_contexts_rec( GList *tree, BuildMenuData *build, GPtrArray *contexts );
+static gboolean             is_over_budget( BuildMenuData *build );
 static void                 attach_submenu_to_item( FileManagerMenuItem *item, GList *subitems );
 static void                 weak_notify_profile( FMAObjectProfile *profile, FileManagerMenuItem *item );
 static void                 execute_action( FileManagerMenuItem *item, FMAObjectProfile *profile );
 static void                 execute_about( FileManagerMenuItem *item, FMAMenuPlugin *plugin );
-static FileManagerMenuItem *create_item_from_profile( FMAObjectProfile *profile, guint target, GList *files, FMATokens *tokens );
+static FileManagerMenuItem *create_item_from_profile( FMAObjectProfile *profile, guint target, FMASelection *selection, FMATokens *tokens );
 static FileManagerMenuItem *create_item_from_menu( FMAObjectMenu *menu, GList *subitems, guint target );
 static FileManagerMenuItem *create_menu_item( const FMAObjectItem *item, guint target );
 static FMAObjectItem       *expand_tokens_item( const FMAObjectItem *item, FMATokens *tokens );
 static void                 expand_tokens_context( FMAIContext *context, FMATokens *tokens );
-static FMAObjectProfile    *get_candidate_profile( FMAObjectAction *action, guint target, GList *files );
+static FMAObjectProfile    *get_candidate_profile( FMAObjectAction *action, const FMAObjectAction *source, BuildMenuData *build, guint *index );
 static GList               *create_root_menu( FMAMenuPlugin *plugin, GList *filemanager_menu );
 static void                 weak_notify_menu_item( void *user_data /* =NULL */, FileManagerMenuItem *item );
 static GList               *add_about_item( FMAMenuPlugin *plugin, GList *filemanager_menu );
@@ -212,6 +235,7 @@ instance_constructed( GObject *object )
 		g_debug( "%s: object=%p (%s)", thisfn, ( void * ) object, G_OBJECT_TYPE_NAME( object ));
 
 		priv->pivot = fma_pivot_new();
+		priv->cache = fma_menu_cache_new();
 
 		/* setup FMAPivot properties before loading items
 		 */
@@ -276,6 +300,7 @@ instance_dispose( GObject *object )
 			g_signal_handler_disconnect( self->private->pivot, self->private->items_changed_handler );
 		}
 		g_object_unref( self->private->pivot );
+		fma_menu_cache_free( self->private->cache );
 
 		/* chain up to the parent class */
 		if( G_OBJECT_CLASS( st_parent_class )->dispose ){
@@ -342,13 +367,13 @@ menu_provider_get_background_items(
 	static const gchar *thisfn = "fma_menu_plugin_menu_provider_get_background_items";
 	GList *filemanager_menus_list = NULL;
 	gchar *uri;
-	GList *selected;
+	FMASelection *selected;
 
 	g_return_val_if_fail( FMA_IS_MENU_PLUGIN( provider ), NULL );
 
 	if( !FMA_MENU_PLUGIN( provider )->private->dispose_has_run ){
 
-		selected = selected_info_get_list_from_item( current_folder );
+		selected = selection_new_from_item( current_folder );
 
 		if( selected ){
 			uri = file_manager_file_info_get_uri( current_folder );
@@ -364,7 +389,7 @@ menu_provider_get_background_items(
 					ITEM_TARGET_LOCATION,
 					selected );
 
-			fma_selected_info_free_list( selected );
+			fma_selection_unref( selected );
 		}
 	}
 
@@ -382,7 +407,7 @@ menu_provider_get_file_items( FileManagerMenuProvider *provider, GtkWidget *wind
 {
 	static const gchar *thisfn = "fma_menu_plugin_menu_provider_get_file_items";
 	GList *filemanager_menus_list = NULL;
-	GList *selected;
+	FMASelection *selected;
 
 	g_return_val_if_fail( FMA_IS_MENU_PLUGIN( provider ), NULL );
 
@@ -393,7 +418,7 @@ menu_provider_get_file_items( FileManagerMenuProvider *provider, GtkWidget *wind
 			return(( GList * ) NULL );
 		}
 
-		selected = selected_info_get_list_from_list(( GList * ) files );
+		selected = selection_new_from_list(( GList * ) files );
 
 		if( selected ){
 			g_debug( "%s: provider=%p, window=%p, files=%p, count=%d",
@@ -418,7 +443,7 @@ menu_provider_get_file_items( FileManagerMenuProvider *provider, GtkWidget *wind
 					ITEM_TARGET_SELECTION,
 					selected );
 
-			fma_selected_info_free_list( selected );
+			fma_selection_unref( selected );
 		}
 	}
 
@@ -441,13 +466,13 @@ menu_provider_get_toolbar_items( FileManagerMenuProvider *provider, GtkWidget *w
 	static const gchar *thisfn = "fma_menu_plugin_menu_provider_get_toolbar_items";
 	GList *filemanager_menus_list = NULL;
 	gchar *uri;
-	GList *selected;
+	FMASelection *selected;
 
 	g_return_val_if_fail( FMA_IS_MENU_PLUGIN( provider ), NULL );
 
 	if( !FMA_MENU_PLUGIN( provider )->private->dispose_has_run ){
 
-		selected = selected_info_get_list_from_item( current_folder );
+		selected = selection_new_from_item( current_folder );
 
 		if( selected ){
 			uri = file_manager_file_info_get_uri( current_folder );
@@ -463,7 +488,7 @@ menu_provider_get_toolbar_items( FileManagerMenuProvider *provider, GtkWidget *w
 					ITEM_TARGET_TOOLBAR,
 					selected );
 
-			fma_selected_info_free_list( selected );
+			fma_selection_unref( selected );
 		}
 	}
 
@@ -472,103 +497,191 @@ menu_provider_get_toolbar_items( FileManagerMenuProvider *provider, GtkWidget *w
 #endif
 
 /*
- * selected_info_get_list_from_item:
+ * selection_new_from_item:
  * @item: a #NautilusFileInfo item
  *
- * Returns: a #GList list which contains a #FMASelectedInfo item with the
- * same URI that the @item.
+ * Returns: a new #FMASelection which contains one item with the same URI
+ * that the @item, to be fma_selection_unref() by the caller.
  */
-static GList *
-selected_info_get_list_from_item( FileManagerFileInfo *item )
+static FMASelection *
+selection_new_from_item( FileManagerFileInfo *item )
 {
-	GList *selected;
+	FMASelection *selection;
 
-	selected = NULL;
-	FMASelectedInfo *info = new_from_file_manager_file_info( item );
+	selection = fma_selection_new();
+	add_from_file_manager_file_info( selection, item );
 
-	if( info ){
-		selected = g_list_prepend( NULL, info );
-	}
-
-	return( selected );
+	return( selection );
 }
 
 /*
- * selected_info_get_list_from_list:
+ * selection_new_from_list:
  * @nautilus_selection: a #GList list of #NautilusFileInfo items.
  *
- * Returns: a #GList list of #FMASelectedInfo items whose URI correspond
- * to those of @nautilus_selection.
+ * Returns: a new #FMASelection whose items correspond to those of
+ * @nautilus_selection, to be fma_selection_unref() by the caller.
  */
-static GList *
-selected_info_get_list_from_list( GList *selection )
+static FMASelection *
+selection_new_from_list( GList *nautilus_selection )
 {
-	GList *selected;
+	FMASelection *selection;
 	GList *it;
 
-	selected = NULL;
+	selection = fma_selection_new();
 
-	for( it = selection ; it ; it = it->next ){
-		FMASelectedInfo *info = new_from_file_manager_file_info( FILE_MANAGER_FILE_INFO( it->data ));
-
-		if( info ){
-			selected = g_list_prepend( selected, info );
-		}
+	for( it = nautilus_selection ; it ; it = it->next ){
+		add_from_file_manager_file_info( selection, FILE_MANAGER_FILE_INFO( it->data ));
 	}
 
-	return( selected ? g_list_reverse( selected ) : NULL );
+	return( selection );
 }
 
-static FMASelectedInfo *
-new_from_file_manager_file_info( FileManagerFileInfo *item )
+static void
+add_from_file_manager_file_info( FMASelection *selection, FileManagerFileInfo *item )
 {
 	gchar *uri = file_manager_file_info_get_uri( item );
 	gchar *mimetype = file_manager_file_info_get_mime_type( item );
-	FMASelectedInfo *info = fma_selected_info_create_for_uri( uri, mimetype, NULL );
+	GFile *location = file_manager_file_info_get_location( item );
+	fma_selection_add_location( selection, location, uri, mimetype, file_manager_file_info_get_file_type( item ));
+	g_object_unref( location );
 	g_free( mimetype );
 	g_free( uri );
-
-	return( info );
 }
 
 /*
  * build_filemanager_menu:
  * @target: whether the menu targets a location (a folder) or a selection
  *  (the list of currently selected items in the file manager)
- * @selection: a list of FMASelectedInfo, with:
+ * @selection: a #FMASelection, with:
  *  - only one item if a location
  *  - one item by selected file manager item, if a selection.
- *  Note: a FMASelectedInfo is just a sort of NautilusFileInfo, with
- *  some added APIs.
  *
  * Build the Nautilus/Nemo menu as a list of Nautilus/NemoMenuItem items
  *
  * Returns: the Nautilus/Nemo menu list
  */
 static GList *
-build_filemanager_menu( FMAMenuPlugin *plugin, guint target, GList *selection )
+build_filemanager_menu( FMAMenuPlugin *plugin, guint target, FMASelection *selection )
 {
 	static const gchar *thisfn = "fma_menu_plugin_build_filemanager_menu";
 	GList *filemanager_menu;
-	FMATokens *tokens;
 	GList *tree;
+	BuildMenuData build;
 	gboolean items_add_about_item;
 	gboolean items_create_root_menu;
+	guint timeout;
+	guint threads;
+	GPtrArray *contexts;
+	guint budget, threshold;
+	gint64 deadline;
 
 	g_return_val_if_fail( FMA_IS_PIVOT( plugin->private->pivot ), NULL );
 
-	tokens = fma_tokens_new_from_selection( selection );
+	/* whatever be the selection, the menu is built within a limited
+	 * time: when the budget is exhausted, the items which have not been
+	 * examined yet are just left out of the menu
+	 */
+	budget = fma_settings_get_uint( IPREFS_PLUGIN_MENU_BUDGET, NULL, NULL );
+
+	build.pivot = plugin->private->pivot;
+	build.target = target;
+	build.selection = selection;
+	build.tokens = fma_tokens_new_from_selection( selection );
+	build.deadline = budget ? g_get_monotonic_time() + budget * G_TIME_SPAN_MILLISECOND : 0;
+	build.over = FALSE;
+
+	/* most of the per-file conditions only depend on a few
+	 * characteristics of each file, so that they only have to be
+	 * checked once per set of similar files
+	 */
+	build.classes = fma_selection_classes_new( selection );
+
+	/* above the threshold, we are in degraded mode: the classes are
+	 * only computed from an evenly spread sample of the selected files
+	 * (see fma_selection_classes_set_sample() for the consequences)
+	 */
+	threshold = fma_settings_get_uint( IPREFS_PLUGIN_MENU_DEGRADED_THRESHOLD, NULL, NULL );
+	if( threshold && fma_selection_classes_get_count( build.classes ) > threshold ){
+		fma_selection_classes_set_sample( build.classes,
+				fma_settings_get_uint( IPREFS_PLUGIN_MENU_DEGRADED_SAMPLE, NULL, NULL ));
+		g_debug( "%s: degraded mode, count=%u, threshold=%u, sampled=%s",
+				thisfn, fma_selection_classes_get_count( build.classes ), threshold,
+				fma_selection_classes_is_sampled( build.classes ) ? "True":"False" );
+	}
 
-	tree = fma_pivot_get_items( plugin->private->pivot );
+	/* the results of the checks against this selection are shared
+	 * while building this menu
+	 */
+	build.scope = fma_icontext_program_scope_new( target, selection, build.classes );
+
+	/* only walk through the items which are eligible for this target
+	 */
+	tree = fma_pivot_get_target_items( build.pivot, target, NULL );
 	g_debug( "%s: tree=%p, count=%d", thisfn, ( void * ) tree, g_list_length( tree ));
 
-	filemanager_menu = build_filemanager_menu_rec( tree, target, selection, tokens );
+	/* the candidate status of most items only depends on a few
+	 * characteristics of the selection, so that we may reuse the
+	 * decisions already taken for a similar selection
+	 * a sampled selection is not fully described by its classes: the
+	 * decisions taken for it are neither reused nor recorded
+	 */
+	build.entry = fma_selection_classes_is_sampled( build.classes )
+			? NULL
+			: fma_menu_cache_lookup( plugin->private->cache,
+					fma_pivot_get_generation( build.pivot ), target, build.classes );
+
+	/* only the items whose mimetypes and schemes conditions may match
+	 * the selection are worth being checked
+	 */
+	build.candidates = fma_pivot_index_select( fma_pivot_get_index( build.pivot ), build.classes );
+
+	/* ShowIfTrue and ShowIfRunning conditions are only waited for
+	 * during a limited time, so that a slow command does not freeze the
+	 * file manager
+	 */
+	timeout = fma_settings_get_uint( IPREFS_PLUGIN_MENU_CONDITIONS_TIMEOUT, NULL, NULL );
+	deadline = timeout ? g_get_monotonic_time() + timeout * G_TIME_SPAN_MILLISECOND : 0;
+	if( build.deadline && ( !deadline || build.deadline < deadline )){
+		deadline = build.deadline;
+	}
+	fma_icontext_program_set_deadline(
+			deadline, fma_settings_get_boolean( IPREFS_PLUGIN_MENU_CONDITIONS_DEFAULT, NULL, NULL ));
+	fma_icontext_program_set_show_if_true_ttl(
+			fma_settings_get_uint( IPREFS_PLUGIN_MENU_SHOW_IF_TRUE_TTL, NULL, NULL ) * G_TIME_SPAN_MILLISECOND );
+	fma_icontext_program_set_show_if_true_timeout(
+			fma_settings_get_uint( IPREFS_PLUGIN_MENU_SHOW_IF_TRUE_TIMEOUT, NULL, NULL ) * G_TIME_SPAN_MILLISECOND );
+	fma_proc_snapshot_set_ttl(
+			fma_settings_get_uint( IPREFS_PLUGIN_MENU_PROCESSES_TTL, NULL, NULL ) * G_TIME_SPAN_MILLISECOND );
+
+	/* the conditions which only depend on the selection may be checked
+	 * in parallel, the results being then used while walking the tree
+	 */
+	threads = fma_settings_get_uint( IPREFS_PLUGIN_MENU_PARALLEL_THREADS, NULL, NULL );
+	if( threads > 1 ){
+		contexts = g_ptr_array_new();
+		collect_contexts_rec( tree, &build, contexts );
+		fma_icontext_program_evaluate_pure( build.scope, contexts, threads );
+		g_ptr_array_unref( contexts );
+	}
+
+	/* have all the ShowIfTrue commands which may be needed run
+	 * concurrently rather than one after the other
+	 */
+	prefetch_conditions_rec( tree, &build );
+
+	filemanager_menu = build_filemanager_menu_rec( tree, &build );
+
+	fma_icontext_program_set_deadline( 0, FALSE );
+
+	fma_icontext_program_scope_free( build.scope );
+	fma_pivot_index_set_free( build.candidates );
+	fma_selection_classes_free( build.classes );
 
 	/* the FMATokens object has been attached (and reffed) by each found
 	 * candidate profile, so it will be actually finalized only on actual
 	 * NautilusMenu finalization itself
 	 */
-	g_object_unref( tokens );
+	g_object_unref( build.tokens );
 
 	if( target != ITEM_TARGET_TOOLBAR && filemanager_menu && g_list_length( filemanager_menu )){
 
@@ -587,7 +700,7 @@ build_filemanager_menu( FMAMenuPlugin *plugin, guint target, GList *selection )
 }
 
 static GList *
-build_filemanager_menu_rec( GList *tree, guint target, GList *selection, FMATokens *tokens )
+build_filemanager_menu_rec( GList *tree, BuildMenuData *build )
 {
 	static const gchar *thisfn = "fma_menu_plugin_build_filemanager_menu_rec";
 	GList *filemanager_menu;
@@ -598,22 +711,50 @@ build_filemanager_menu_rec( GList *tree, guint target, GList *selection, FMAToke
 	FMAObjectProfile *profile;
 	FileManagerMenuItem *menu_item;
 	gchar *label;
+	gboolean cached;
+	guint decision;
 
 	filemanager_menu = NULL;
 
-	for( it=tree ; it ; it=it->next ){
+	for( it=tree ; it && !is_over_budget( build ) ; it=it->next ){
 
 		g_return_val_if_fail( FMA_IS_OBJECT_ITEM( it->data ), NULL );
 		label = fma_object_get_label( it->data );
 		g_debug( "%s: examining %s", thisfn, label );
 
-		if( !fma_icontext_is_candidate( FMA_ICONTEXT( it->data ), target, selection )){
+		if( !fma_pivot_index_has( build->candidates, FMA_ICONTEXT( it->data ))){
+			g_debug( "%s: is not candidate (index): %s", thisfn, label );
+			g_free( label );
+			continue;
+		}
+
+		/* a cached decision is zero when the item is not a candidate,
+		 * or (for an action) the index of the candidate profile + 1
+		 */
+		decision = 0;
+		cached = fma_menu_cache_get( build->entry, FMA_OBJECT_ITEM( it->data ), &decision );
+
+		if( cached && !decision ){
+			g_debug( "%s: is not candidate (cached): %s", thisfn, label );
+			g_free( label );
+			continue;
+		}
+
+		/* the FMAIContext::is_candidate() method of the menus, actions
+		 * and profiles does not check anything, so the compiled program
+		 * is directly run against the selection, without having to go
+		 * through a list of FMASelectedInfo views
+		 */
+		if( !cached && !fma_icontext_program_is_candidate( FMA_ICONTEXT( it->data ), build->scope )){
 			g_debug( "%s: is not candidate (FMAIContext): %s", thisfn, label );
+			if( build->entry ){
+				fma_menu_cache_set( build->entry, FMA_OBJECT_ITEM( it->data ), 0 );
+			}
 			g_free( label );
 			continue;
 		}
 
-		item = expand_tokens_item( FMA_OBJECT_ITEM( it->data ), tokens );
+		item = expand_tokens_item( FMA_OBJECT_ITEM( it->data ), build->tokens );
 
 		/* but we have to re-check for validity as a label may become
 		 * dynamically empty - thus the FMAObjectItem invalid :(
@@ -631,18 +772,22 @@ build_filemanager_menu_rec( GList *tree, guint target, GList *selection, FMAToke
 		 */
 		if( FMA_IS_OBJECT_MENU( it->data )){
 
-			subitems = fma_object_get_items( FMA_OBJECT( it->data ));
+			if( build->entry ){
+				fma_menu_cache_set( build->entry, FMA_OBJECT_ITEM( it->data ), 1 );
+			}
+
+			subitems = fma_pivot_get_target_items( build->pivot, build->target, FMA_OBJECT_ITEM( it->data ));
 			g_debug( "%s: menu has %d items", thisfn, g_list_length( subitems ));
 
-			submenu = build_filemanager_menu_rec( subitems, target, selection, tokens );
+			submenu = build_filemanager_menu_rec( subitems, build );
 			g_debug( "%s: submenu has %d items", thisfn, g_list_length( submenu ));
 
 			if( submenu ){
-				if( target == ITEM_TARGET_TOOLBAR ){
+				if( build->target == ITEM_TARGET_TOOLBAR ){
 					filemanager_menu = g_list_concat( filemanager_menu, submenu );
 
 				} else {
-					menu_item = create_item_from_menu( FMA_OBJECT_MENU( item ), submenu, target );
+					menu_item = create_item_from_menu( FMA_OBJECT_MENU( item ), submenu, build->target );
 					filemanager_menu = g_list_append( filemanager_menu, menu_item );
 				}
 			}
@@ -655,9 +800,12 @@ build_filemanager_menu_rec( GList *tree, guint target, GList *selection, FMAToke
 
 		/* if we have an action, searches for a candidate profile
 		 */
-		profile = get_candidate_profile( FMA_OBJECT_ACTION( item ), target, selection );
+		profile = get_candidate_profile( FMA_OBJECT_ACTION( item ), FMA_OBJECT_ACTION( it->data ), build, &decision );
+		if( !cached && build->entry ){
+			fma_menu_cache_set( build->entry, FMA_OBJECT_ITEM( it->data ), decision );
+		}
 		if( profile ){
-			menu_item = create_item_from_profile( profile, target, selection, tokens );
+			menu_item = create_item_from_profile( profile, build->target, build->selection, build->tokens );
 			filemanager_menu = g_list_append( filemanager_menu, menu_item );
 
 		} else {
@@ -671,6 +819,98 @@ build_filemanager_menu_rec( GList *tree, guint target, GList *selection, FMAToke
 	return( filemanager_menu );
 }
 
+/*
+ * start the ShowIfTrue commands of the items and profiles which may be
+ * candidate; as in build_filemanager_menu_rec(), the command of a profile
+ * is run after parameters expansion, while the one of a menu or an
+ * action is run as is
+ */
+static void
+prefetch_conditions_rec( GList *tree, BuildMenuData *build )
+{
+	GList *it, *ip;
+	guint decision;
+
+	for( it=tree ; it && !is_over_budget( build ) ; it=it->next ){
+
+		if( !fma_pivot_index_has( build->candidates, FMA_ICONTEXT( it->data ))){
+			continue;
+		}
+
+		if( fma_menu_cache_get( build->entry, FMA_OBJECT_ITEM( it->data ), &decision ) && !decision ){
+			continue;
+		}
+
+		if( !fma_icontext_program_prefetch( FMA_ICONTEXT( it->data ), build->scope, NULL )){
+			continue;
+		}
+
+		if( FMA_IS_OBJECT_MENU( it->data )){
+			prefetch_conditions_rec(
+					fma_pivot_get_target_items( build->pivot, build->target, FMA_OBJECT_ITEM( it->data )), build );
+
+		} else if( FMA_IS_OBJECT_ACTION( it->data )){
+			for( ip = fma_object_get_items( it->data ) ; ip ; ip = ip->next ){
+				if( fma_pivot_index_has( build->candidates, FMA_ICONTEXT( ip->data ))){
+					fma_icontext_program_prefetch( FMA_ICONTEXT( ip->data ), build->scope, build->tokens );
+				}
+			}
+		}
+	}
+}
+
+/*
+ * collect, in the tree order, the items and profiles which may be
+ * candidate, so that their conditions may be evaluated in parallel
+ */
+static void
+collect_contexts_rec( GList *tree, BuildMenuData *build, GPtrArray *contexts )
+{
+	GList *it, *ip;
+	guint decision;
+
+	for( it=tree ; it ; it=it->next ){
+
+		if( !fma_pivot_index_has( build->candidates, FMA_ICONTEXT( it->data ))){
+			continue;
+		}
+
+		if( fma_menu_cache_get( build->entry, FMA_OBJECT_ITEM( it->data ), &decision ) && !decision ){
+			continue;
+		}
+
+		g_ptr_array_add( contexts, it->data );
+
+		if( FMA_IS_OBJECT_MENU( it->data )){
+			collect_contexts_rec(
+					fma_pivot_get_target_items( build->pivot, build->target, FMA_OBJECT_ITEM( it->data )), build, contexts );
+
+		} else if( FMA_IS_OBJECT_ACTION( it->data )){
+			for( ip = fma_object_get_items( it->data ) ; ip ; ip = ip->next ){
+				if( fma_pivot_index_has( build->candidates, FMA_ICONTEXT( ip->data ))){
+					g_ptr_array_add( contexts, ip->data );
+				}
+			}
+		}
+	}
+}
+
+/*
+ * whether the wall-clock budget of the menu has been exhausted
+ */
+static gboolean
+is_over_budget( BuildMenuData *build )
+{
+	static const gchar *thisfn = "fma_menu_plugin_is_over_budget";
+
+	if( !build->over && build->deadline && g_get_monotonic_time() > build->deadline ){
+		g_warning( "%s: menu budget exhausted, the remaining items are ignored", thisfn );
+		build->over = TRUE;
+	}
+
+	return( build->over );
+}
+
 /*
  * expand_tokens_item:
  * @item: a FMAObjectItem read from the FMAPivot.
@@ -690,7 +930,7 @@ expand_tokens_item( const FMAObjectItem *src, FMATokens *tokens )
 {
 	gchar *old, *new;
 	GSList *subitems_slist, *its, *new_slist;
-	GList *subitems, *it;
+	GList *subitems, *it, *src_profiles, *ip;
 	FMAObjectItem *item;
 
 	item = FMA_OBJECT_ITEM( fma_object_duplicate( src, FMA_DUPLICATE_OBJECT ));
@@ -752,8 +992,9 @@ expand_tokens_item( const FMAObjectItem *src, FMATokens *tokens )
 	if( FMA_IS_OBJECT_ACTION( item )){
 
 		subitems = fma_object_get_items( item );
+		src_profiles = fma_object_get_items( src );
 
-		for( it = subitems ; it ; it = it->next ){
+		for( it = subitems, ip = src_profiles ; it && ip ; it = it->next, ip = ip->next ){
 
 			/* desktop Exec key = GConf path+parameters
 			 * do not touch them here
@@ -767,9 +1008,15 @@ expand_tokens_item( const FMAObjectItem *src, FMATokens *tokens )
 			/* a FMAObjectProfile is also a FMAIContext
 			 */
 			expand_tokens_context( FMA_ICONTEXT( it->data ), tokens );
+
+			/* share the compiled conditions of the original profile
+			 */
+			fma_icontext_program_derive( FMA_ICONTEXT( it->data ), FMA_ICONTEXT( ip->data ));
 		}
 	}
 
+	fma_icontext_program_derive( FMA_ICONTEXT( item ), FMA_ICONTEXT( src ));
+
 	return( item );
 }
 
@@ -805,38 +1052,59 @@ expand_tokens_context( FMAIContext *context, FMATokens *tokens )
 
 /*
  * could also be a FMAObjectAction method - but this is not used elsewhere
+ *
+ * @action: the action whose parameters have been expanded.
+ * @source: the original action, as found in the FMAPivot tree.
+ * @build: the data of the menu being built.
+ * @index: on input, the cached index of the candidate profile + 1, or
+ *  zero if the profiles have to be evaluated; on output, the index of
+ *  the found candidate profile + 1, or zero if none has been found.
  */
 static FMAObjectProfile *
-get_candidate_profile( FMAObjectAction *action, guint target, GList *files )
+get_candidate_profile( FMAObjectAction *action, const FMAObjectAction *source, BuildMenuData *build, guint *index )
 {
 	static const gchar *thisfn = "fma_menu_plugin_get_candidate_profile";
 	FMAObjectProfile *candidate = NULL;
 	gchar *action_label;
 	gchar *profile_label;
-	GList *profiles, *ip;
+	GList *profiles, *ip, *src_profiles, *isp;
+	guint i;
 
 	action_label = fma_object_get_label( action );
 	profiles = fma_object_get_items( action );
 
-	for( ip = profiles ; ip && !candidate ; ip = ip->next ){
+	if( *index ){
+		candidate = FMA_OBJECT_PROFILE( g_list_nth_data( profiles, *index-1 ));
+		g_debug( "%s: selecting %s (profile=%p, cached)", thisfn, action_label, ( void * ) candidate );
+	}
+
+	src_profiles = fma_object_get_items( source );
+
+	for( ip = profiles, isp = src_profiles, i = 0 ; ip && isp && !candidate ; ip = ip->next, isp = isp->next, i++ ){
 		FMAObjectProfile *profile = FMA_OBJECT_PROFILE( ip->data );
 
-		if( fma_icontext_is_candidate( FMA_ICONTEXT( profile ), target, files )){
+		if( fma_pivot_index_has( build->candidates, FMA_ICONTEXT( isp->data )) &&
+				fma_icontext_program_is_candidate( FMA_ICONTEXT( profile ), build->scope )){
 			profile_label = fma_object_get_label( profile );
 			g_debug( "%s: selecting %s (profile=%p '%s')", thisfn, action_label, ( void * ) profile, profile_label );
 			g_free( profile_label );
 
 			candidate = profile;
+			*index = i+1;
 		}
 	}
 
+	if( !candidate ){
+		*index = 0;
+	}
+
 	g_free( action_label );
 
 	return( candidate );
 }
 
 static FileManagerMenuItem *
-create_item_from_profile( FMAObjectProfile *profile, guint target, GList *files, FMATokens *tokens )
+create_item_from_profile( FMAObjectProfile *profile, guint target, FMASelection *selection, FMATokens *tokens )
 {
 	FileManagerMenuItem *item;
 	FMAObjectAction *action;
@@ -1101,6 +1369,7 @@ on_settings_key_changed_handler( const gchar *group, const gchar *key, gconstpoi
 
 	if( !plugin->private->dispose_has_run ){
 
+		fma_menu_cache_invalidate( plugin->private->cache );
 		fma_timeout_event( &plugin->private->change_timeout );
 	}
 }
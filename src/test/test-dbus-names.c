@@ -0,0 +1,173 @@
+/*
+ * Nautilus-Actions
+ * A Nautilus extension which offers configurable context menu actions.
+ *
+ * Copyright (C) 2005 The GNOME Foundation
+ * Copyright (C) 2006-2008 Frederic Ruaudel and others (see AUTHORS)
+ * Copyright (C) 2009-2015 Pierre Wieser and others (see AUTHORS)
+ *
+ * Nautilus-Actions is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * Nautilus-Actions is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Nautilus-Actions; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Frederic Ruaudel <grumz@grumz.net>
+ *   Rodrigo Moya <rodrigo@gnome-db.org>
+ *   Pierre Wieser <pwieser@trychlos.org>
+ *   ... and many others (see AUTHORS)
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <gio/gio.h>
+#include <glib/gprintf.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <core/fma-dbus-names.h>
+
+/* checks the set of owned names maintained by FMADBusNames against a
+ * private session bus, started by GTestDBus
+ */
+#define NAME_EARLY					"org.filemanager.actions.test.Early"
+#define NAME_LATE					"org.filemanager.actions.test.Late"
+
+#define WAIT_TIMEOUT				5		/* seconds */
+
+static gboolean  wait_for( const gchar *name, gboolean expected );
+static gboolean  on_timeout( gboolean *timed_out );
+static void      request_name( GDBusConnection *connection, const gchar *method, const gchar *name );
+static gboolean  check( const gchar *label, gboolean ok );
+
+int
+main( int argc, char **argv )
+{
+	GTestDBus *bus;
+	GDBusConnection *owner;
+	gboolean ok;
+
+#if !GLIB_CHECK_VERSION( 2,36, 0 )
+	g_type_init();
+#endif
+
+	g_printf( "FMADBusNames test.\n\n" );
+
+	g_test_dbus_unset();
+	bus = g_test_dbus_new( G_TEST_DBUS_NONE );
+	g_test_dbus_up( bus );
+
+	/* the names are owned by another connection than the one used by
+	 * FMADBusNames
+	 */
+	owner = g_dbus_connection_new_for_address_sync( g_test_dbus_get_bus_address( bus ),
+			G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT | G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,
+			NULL, NULL, NULL );
+	ok = check( "connect the owner", owner != NULL );
+
+	if( ok ){
+		request_name( owner, "RequestName", NAME_EARLY );
+		fma_dbus_names_init();
+
+		ok &= check( "name already owned", wait_for( NAME_EARLY, TRUE ));
+		ok &= check( "name not owned", !fma_dbus_names_has_owner( NAME_LATE ));
+
+		request_name( owner, "RequestName", NAME_LATE );
+		ok &= check( "name acquired later", wait_for( NAME_LATE, TRUE ));
+
+		request_name( owner, "ReleaseName", NAME_EARLY );
+		ok &= check( "name released later", wait_for( NAME_EARLY, FALSE ));
+
+		/* the owner is disconnected too, so the names cannot come back
+		 */
+		g_test_dbus_stop( bus );
+		ok &= check( "connection lost", wait_for( NAME_LATE, FALSE ));
+
+		g_object_unref( owner );
+	}
+
+	g_test_dbus_down( bus );
+	g_object_unref( bus );
+
+	g_printf( "\n%s\n", ok ? "All tests passed." : "Some tests failed." );
+
+	return( ok ? EXIT_SUCCESS : EXIT_FAILURE );
+}
+
+/*
+ * the set is updated asynchronously: iterate the main context until it
+ * reflects the expected state, or the timeout expires
+ */
+static gboolean
+wait_for( const gchar *name, gboolean expected )
+{
+	gboolean timed_out;
+	guint source_id;
+
+	timed_out = FALSE;
+	source_id = g_timeout_add_seconds( WAIT_TIMEOUT, ( GSourceFunc ) on_timeout, &timed_out );
+
+	while( fma_dbus_names_has_owner( name ) != expected && !timed_out ){
+		g_main_context_iteration( NULL, TRUE );
+	}
+
+	if( !timed_out ){
+		g_source_remove( source_id );
+	}
+
+	return( !timed_out );
+}
+
+static gboolean
+on_timeout( gboolean *timed_out )
+{
+	*timed_out = TRUE;
+
+	return( FALSE );
+}
+
+static void
+request_name( GDBusConnection *connection, const gchar *method, const gchar *name )
+{
+	GVariant *reply;
+	GError *error;
+
+	error = NULL;
+
+	if( !strcmp( method, "RequestName" )){
+		reply = g_dbus_connection_call_sync( connection,
+				"org.freedesktop.DBus", "/org/freedesktop/DBus", "org.freedesktop.DBus", method,
+				g_variant_new( "(su)", name, 0 ), NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL, &error );
+	} else {
+		reply = g_dbus_connection_call_sync( connection,
+				"org.freedesktop.DBus", "/org/freedesktop/DBus", "org.freedesktop.DBus", method,
+				g_variant_new( "(s)", name ), NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL, &error );
+	}
+
+	if( reply ){
+		g_variant_unref( reply );
+
+	} else {
+		g_printf( "%s %s: %s\n", method, name, error->message );
+		g_error_free( error );
+	}
+}
+
+static gboolean
+check( const gchar *label, gboolean ok )
+{
+	g_printf( "%-24s %s\n", label, ok ? "OK" : "FAILED" );
+
+	return( ok );
+}
@@ -0,0 +1,238 @@
+/*
+ * Nautilus-Actions
+ * A Nautilus extension which offers configurable context menu actions.
+ *
+ * Copyright (C) 2005 The GNOME Foundation
+ * Copyright (C) 2006-2008 Frederic Ruaudel and others (see AUTHORS)
+ * Copyright (C) 2009-2015 Pierre Wieser and others (see AUTHORS)
+ *
+ * Nautilus-Actions is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * Nautilus-Actions is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Nautilus-Actions; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Frederic Ruaudel <grumz@grumz.net>
+ *   Rodrigo Moya <rodrigo@gnome-db.org>
+ *   Pierre Wieser <pwieser@trychlos.org>
+ *   ... and many others (see AUTHORS)
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib/gprintf.h>
+#include <stdlib.h>
+
+#include <core/fma-template.h>
+#include <core/fma-tokens.h>
+
+/* the selected files, with spaces, quotes and shell metacharacters
+ */
+static const gchar *uris[] = {
+		"file:///tmp/fma%20test/it's%20%22quoted%22.txt",
+		"file:///tmp/fma%20test/plain",
+		"file:///tmp/%24HOME/a%5Cb%20c.tar.gz",
+		NULL
+};
+
+/* the commands, along with their expected form of execution, and
+ * whether they may be expanded directly as an argument vector
+ */
+typedef struct {
+	const gchar *command;
+	gboolean     singular;
+	gboolean     argv;
+}
+	TestCommand;
+
+static const TestCommand commands[] = {
+		{ "echo",                                  FALSE, TRUE  },
+		{ "echo %f",                               TRUE,  TRUE  },
+		{ "echo %F",                               FALSE, TRUE  },
+		{ "echo %c %u",                            TRUE,  TRUE  },
+		{ "echo %c %U",                            FALSE, TRUE  },
+		{ "echo %o %U",                            TRUE,  TRUE  },
+		{ "echo %O %f",                            FALSE, TRUE  },
+		{ "echo --files=%B --dirs %D",             FALSE, TRUE  },
+		{ "echo prefix%wsuffix.%x",                TRUE,  TRUE  },
+		{ "echo %s://%h:%p",                       FALSE, TRUE  },
+		{ "echo 100%% %f",                         TRUE,  TRUE  },
+		{ "echo %%f %F",                           FALSE, TRUE  },
+		{ "echo %F %",                             FALSE, TRUE  },
+		{ "echo a%",                               FALSE, TRUE  },
+		{ "echo \"a b\" 'c d' e\\ f %U",           FALSE, TRUE  },
+		{ "echo %Z %f",                            TRUE,  TRUE  },
+		{ "echo '%f'",                             TRUE,  FALSE },
+		{ "sh -c \"ls %F\"",                       FALSE, FALSE },
+		{ "echo 'unterminated %f",                 TRUE,  FALSE },
+		{ NULL }
+};
+
+/* commands without any parameter, whose words must be those of the
+ * shell
+ */
+static const gchar *literals[] = {
+		"echo",
+		"  echo   a\tb  ",
+		"echo \"a \\\"b\\\" c\" 'd e' f\\ g",
+		"echo \"\\x \\$ \\\\\"",
+		"echo a#b",
+		"echo ''",
+		"echo a'b'\"c\"d",
+		NULL
+};
+
+static gboolean check_argv( const gchar *label, gchar **argv, const gchar *command );
+static gchar  **parse_argv( const gchar *command );
+
+int
+main( int argc, char **argv )
+{
+	FMASelection *selection;
+	FMATokens *tokens;
+	FMATemplate *template;
+	GFile *location;
+	gchar **words, *command, *label;
+	guint count, i, first, last;
+	gboolean ok, singular;
+
+#if !GLIB_CHECK_VERSION( 2,36, 0 )
+	g_type_init();
+#endif
+
+	g_printf( "Argument vectors expansion test.\n\n" );
+
+	selection = fma_selection_new();
+	for( count = 0 ; uris[count] ; ++count ){
+		location = g_file_new_for_uri( uris[count] );
+		fma_selection_add_location( selection, location, uris[count], "text/plain", G_FILE_TYPE_REGULAR );
+		g_object_unref( location );
+	}
+	tokens = fma_tokens_new_from_selection( selection );
+	ok = TRUE;
+
+	for( i = 0 ; commands[i].command ; ++i ){
+		template = fma_template_get( commands[i].command );
+		singular = fma_template_is_singular( template );
+		fma_template_unref( template );
+
+		if( singular != commands[i].singular ){
+			g_printf( "%-40s singular=%s: FAILED\n", commands[i].command, singular ? "True":"False" );
+			ok = FALSE;
+			continue;
+		}
+
+		/* a singular command is executed once per file, a plural one
+		 * once for the whole selection
+		 */
+		first = 0;
+		last = singular ? count : 1;
+
+		for( ; first < last ; ++first ){
+			label = g_strdup_printf( "%s [%u]", commands[i].command, first );
+			words = fma_tokens_expand_argv( tokens, commands[i].command, first, 0, count );
+
+			if( !words ){
+				g_printf( "%-40s %s\n", label, commands[i].argv ? "FAILED (not expandable)" : "OK (quoted string)" );
+				ok &= !commands[i].argv;
+
+			} else if( !commands[i].argv ){
+				g_printf( "%-40s FAILED (expandable)\n", label );
+				g_strfreev( words );
+				ok = FALSE;
+
+			} else {
+				command = fma_tokens_expand_command( tokens, commands[i].command, first, 0, count );
+				ok &= check_argv( label, words, command );
+				g_free( command );
+				g_strfreev( words );
+			}
+
+			g_free( label );
+		}
+	}
+
+	g_printf( "\n" );
+
+	for( i = 0 ; literals[i] ; ++i ){
+		words = fma_tokens_expand_argv( tokens, literals[i], 0, 0, count );
+		if( !words ){
+			g_printf( "%-40s FAILED (not expandable)\n", literals[i] );
+			ok = FALSE;
+
+		} else {
+			ok &= check_argv( literals[i], words, literals[i] );
+			g_strfreev( words );
+		}
+	}
+
+	g_object_unref( tokens );
+	fma_selection_unref( selection );
+
+	g_printf( "\n%s\n", ok ? "All tests passed." : "Some tests failed." );
+
+	return( ok ? EXIT_SUCCESS : EXIT_FAILURE );
+}
+
+/*
+ * compares the expanded @argv with the words the shell would find in
+ * the @command
+ */
+static gboolean
+check_argv( const gchar *label, gchar **argv, const gchar *command )
+{
+	gchar **expected;
+	gboolean ok;
+	guint i;
+
+	expected = parse_argv( command );
+	ok = ( g_strv_length( argv ) == g_strv_length( expected ));
+
+	for( i = 0 ; ok && argv[i] ; ++i ){
+		ok = ( g_strcmp0( argv[i], expected[i] ) == 0 );
+	}
+
+	g_printf( "%-40s %s\n", label, ok ? "OK" : "FAILED" );
+
+	if( !ok ){
+		for( i = 0 ; argv[i] ; ++i ){
+			g_printf( "  argv[%u]=<%s>\n", i, argv[i] );
+		}
+		for( i = 0 ; expected[i] ; ++i ){
+			g_printf( "  expected[%u]=<%s>\n", i, expected[i] );
+		}
+	}
+
+	g_strfreev( expected );
+
+	return( ok );
+}
+
+/*
+ * g_shell_parse_argv() refuses a command without any word
+ */
+static gchar **
+parse_argv( const gchar *command )
+{
+	gchar **argv;
+	GError *error;
+
+	error = NULL;
+	if( !g_shell_parse_argv( command, NULL, &argv, &error )){
+		g_error_free( error );
+		argv = g_new0( gchar *, 1 );
+	}
+
+	return( argv );
+}
@@ -0,0 +1,150 @@
+/*
+ * Nautilus-Actions
+ * A Nautilus extension which offers configurable context menu actions.
+ *
+ * Copyright (C) 2005 The GNOME Foundation
+ * Copyright (C) 2006-2008 Frederic Ruaudel and others (see AUTHORS)
+ * Copyright (C) 2009-2015 Pierre Wieser and others (see AUTHORS)
+ *
+ * Nautilus-Actions is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * Nautilus-Actions is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Nautilus-Actions; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Frederic Ruaudel <grumz@grumz.net>
+ *   Rodrigo Moya <rodrigo@gnome-db.org>
+ *   Pierre Wieser <pwieser@trychlos.org>
+ *   ... and many others (see AUTHORS)
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib/gprintf.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <core/fma-folder-trie.h>
+
+/* the Folders patterns, a '!' making them negative
+ * the same pattern may appear several times
+ */
+static const gchar *patterns[] = {
+		"/",
+		"/home/",
+		"/home/user",
+		"!/home/user/private",
+		"/home/*/music",
+		"/srv/what?/",
+		"/srv/*",
+		"*/tmp",
+		"!*.git*",
+		"/home/user",
+		"/var/lib/apt/lists",
+		NULL
+};
+
+static const gchar *paths[] = {
+		"/",
+		"/home",
+		"/home/user",
+		"/home/username",
+		"/home/user/private/notes",
+		"/home/other/music",
+		"/home/other/music/rock",
+		"/srv/what?/data",
+		"/srv/whats/data",
+		"/var/tmp",
+		"/tmp",
+		"/home/user/src/project.git/objects",
+		"/var/lib/apt",
+		"/var/lib/apt/lists/partial",
+		NULL
+};
+
+static gboolean baseline_match( const gchar *pattern, const gchar *path );
+static void     on_matched( guint id, gboolean *matched );
+
+int
+main( int argc, char **argv )
+{
+	FMAFolderTrie *trie;
+	gboolean *matched, expected, ok, path_ok;
+	const gchar *pattern;
+	guint i, j, count;
+
+#if !GLIB_CHECK_VERSION( 2,36, 0 )
+	g_type_init();
+#endif
+
+	g_printf( "Folders trie test.\n\n" );
+
+	for( count = 0 ; patterns[count] ; ++count )
+		;
+
+	trie = fma_folder_trie_new();
+	for( i = 0 ; i < count ; ++i ){
+		pattern = patterns[i][0] == '!' ? patterns[i]+1 : patterns[i];
+		fma_folder_trie_add( trie, pattern, i );
+	}
+
+	matched = g_new0( gboolean, count );
+	ok = TRUE;
+
+	for( j = 0 ; paths[j] ; ++j ){
+		memset( matched, '\0', count * sizeof( gboolean ));
+		fma_folder_trie_match( trie, paths[j], ( FMAFolderTrieFunc ) on_matched, matched );
+		path_ok = TRUE;
+
+		for( i = 0 ; i < count ; ++i ){
+			pattern = patterns[i][0] == '!' ? patterns[i]+1 : patterns[i];
+			expected = baseline_match( pattern, paths[j] );
+			if( expected != matched[i] ){
+				g_printf( "  pattern=%s, path=%s: trie=%s, expected=%s\n",
+						patterns[i], paths[j], matched[i] ? "True":"False", expected ? "True":"False" );
+				path_ok = FALSE;
+			}
+		}
+
+		g_printf( "%-40s %s\n", paths[j], path_ok ? "OK" : "FAILED" );
+		ok &= path_ok;
+	}
+
+	g_free( matched );
+	fma_folder_trie_free( trie );
+
+	g_printf( "\n%s\n", ok ? "All tests passed." : "Some tests failed." );
+
+	return( ok ? EXIT_SUCCESS : EXIT_FAILURE );
+}
+
+/*
+ * the rule applied before the trie was introduced
+ */
+static gboolean
+baseline_match( const gchar *pattern, const gchar *path )
+{
+	gboolean has_pattern;
+
+	has_pattern = ( g_strstr_len( pattern, -1, "*" ) != NULL );
+
+	return(( has_pattern && g_pattern_match_simple( pattern, path )) ||
+			g_str_has_prefix( path, pattern ));
+}
+
+static void
+on_matched( guint id, gboolean *matched )
+{
+	matched[id] = TRUE;
+}
@@ -0,0 +1,259 @@
+/*
+ * Nautilus-Actions
+ * A Nautilus extension which offers configurable context menu actions.
+ *
+ * Copyright (C) 2005 The GNOME Foundation
+ * Copyright (C) 2006-2008 Frederic Ruaudel and others (see AUTHORS)
+ * Copyright (C) 2009-2015 Pierre Wieser and others (see AUTHORS)
+ *
+ * Nautilus-Actions is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * Nautilus-Actions is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Nautilus-Actions; see the file COPYING. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *   Frederic Ruaudel <grumz@grumz.net>
+ *   Rodrigo Moya <rodrigo@gnome-db.org>
+ *   Pierre Wieser <pwieser@trychlos.org>
+ *   ... and many others (see AUTHORS)
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib/gprintf.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <core/fma-tokens.h>
+
+/* the plural-form command which is split
+ */
+#define COMMAND							"echo %c %F"
+
+static FMATokens *tokens_new( guint count, guint length, guint oversized, const gchar *prefix );
+static gboolean   check_chunks( const gchar *label, FMATokens *tokens, guint count, const gchar *mode, gsize limit, guint oversized );
+static gchar     *get_run_command( FMATokens *tokens, const gchar *mode, guint start, guint end );
+static gsize      get_cost( FMATokens *tokens, guint i, gboolean requoted );
+static void       check( const gchar *label, gboolean ok, gboolean *all_ok );
+
+int
+main( int argc, char **argv )
+{
+	FMATokens *tokens;
+	gsize normal, terminal;
+	gboolean ok;
+
+#if !GLIB_CHECK_VERSION( 2,36, 0 )
+	g_type_init();
+#endif
+
+	g_printf( "Plural-form command chunks test.\n\n" );
+
+	ok = TRUE;
+
+	/* small files, one of them being larger than the limit by itself
+	 */
+	tokens = tokens_new( 40, 20, 17, "" );
+	check( "40 files, limit=1024, oversized #17", check_chunks( "40 files", tokens, 40, "Normal", 1024, 17 ), &ok );
+	g_object_unref( tokens );
+
+	/* the oversized file is the first and the last one
+	 */
+	tokens = tokens_new( 10, 20, 0, "" );
+	check( "10 files, limit=512, oversized #0", check_chunks( "first", tokens, 10, "Normal", 512, 0 ), &ok );
+	g_object_unref( tokens );
+
+	tokens = tokens_new( 10, 20, 9, "" );
+	check( "10 files, limit=512, oversized #9", check_chunks( "last", tokens, 10, "Normal", 512, 9 ), &ok );
+	g_object_unref( tokens );
+
+	/* a command run through a terminal is passed as one argument, which
+	 * is quoted again as a whole: each single quote of the names then
+	 * grows from one to four characters
+	 */
+	tokens = tokens_new( 40, 20, G_MAXUINT, "Bob's photo '' " );
+	check( "40 quoted files, limit=2048, Normal", check_chunks( "normal", tokens, 40, "Normal", 2048, G_MAXUINT ), &ok );
+	check( "40 quoted files, limit=2048, Terminal", check_chunks( "terminal", tokens, 40, "Terminal", 2048, G_MAXUINT ), &ok );
+	check( "40 quoted files, limit=2048, DisplayOutput", check_chunks( "output", tokens, 40, "DisplayOutput", 2048, G_MAXUINT ), &ok );
+	g_object_unref( tokens );
+
+	normal = fma_tokens_get_arg_limit( "Normal" );
+	terminal = fma_tokens_get_arg_limit( "Terminal" );
+	g_printf( "\nlimits: Normal=%" G_GSIZE_FORMAT ", Terminal=%" G_GSIZE_FORMAT "\n", normal, terminal );
+	check( "Terminal limit fits in one argument", terminal < FMA_TOKENS_ARG_STRLEN_MAX, &ok );
+	check( "Terminal limit is not above Normal", terminal <= normal, &ok );
+	check( "Embedded limit is the Terminal one", fma_tokens_get_arg_limit( "Embedded" ) == terminal, &ok );
+	check( "DisplayOutput limit is the Terminal one", fma_tokens_get_arg_limit( "DisplayOutput" ) == terminal, &ok );
+
+	tokens = tokens_new( 2000, 150, G_MAXUINT, "it's ''''' " );
+	check( "2000 quoted files, Terminal limit", check_chunks( "terminal", tokens, 2000, "Terminal", terminal, G_MAXUINT ), &ok );
+	g_object_unref( tokens );
+
+	g_printf( "\n%s\n", ok ? "All tests passed." : "Some tests failed." );
+
+	return( ok ? EXIT_SUCCESS : EXIT_FAILURE );
+}
+
+/*
+ * a selection of @count files whose basenames start with @prefix and
+ * are about @length long, the @oversized-th one being 4096 bytes long
+ */
+static FMATokens *
+tokens_new( guint count, guint length, guint oversized, const gchar *prefix )
+{
+	FMASelection *selection;
+	FMATokens *tokens;
+	GFile *location;
+	gchar *padding, *escaped, *uri;
+	guint i;
+
+	selection = fma_selection_new();
+	escaped = g_uri_escape_string( prefix, NULL, FALSE );
+
+	for( i = 0 ; i < count ; ++i ){
+		padding = g_strnfill( i == oversized ? 4096 : length, 'x' );
+		uri = g_strdup_printf( "file:///tmp/fma%%20chunks/%s%04u%%20%s.txt", escaped, i, padding );
+		location = g_file_new_for_uri( uri );
+		fma_selection_add_location( selection, location, uri, "text/plain", G_FILE_TYPE_REGULAR );
+		g_object_unref( location );
+		g_free( uri );
+		g_free( padding );
+	}
+
+	g_free( escaped );
+	tokens = fma_tokens_new_from_selection( selection );
+	fma_selection_unref( selection );
+
+	return( tokens );
+}
+
+/*
+ * the chunks must cover the whole selection, in order; a chunk of
+ * several files fits in the @limit, as the single argument of a
+ * terminal if the @mode is not Normal, and would not fit with one more
+ * file; the @oversized file is alone in its chunk; %c is the count of
+ * files of the chunk
+ */
+static gboolean
+check_chunks( const gchar *label, FMATokens *tokens, guint count, const gchar *mode, gsize limit, guint oversized )
+{
+	guint *ends, chunks, i, k, start, end;
+	gsize fixed, size;
+	gchar **argv, *command, *count_str;
+	gboolean ok, requoted;
+
+	requoted = ( strcmp( mode, "Normal" ) != 0 );
+	ends = fma_tokens_get_plural_chunks( tokens, COMMAND, mode, limit, &chunks );
+	g_printf( "%s: count=%u, mode=%s, limit=%" G_GSIZE_FORMAT ", chunks=%u\n", label, count, mode, limit, chunks );
+
+	/* the estimate of the splitting: the fixed part of the command,
+	 * plus the quoted argument and one pointer per file
+	 */
+	command = get_run_command( tokens, mode, 0, 0 );
+	fixed = strlen( command ) + 1 + 16;
+	g_free( command );
+
+	ok = ( chunks > 0 && ends[chunks-1] == count );
+
+	for( i = 0, start = 0 ; ok && i < chunks ; start = ends[i++] ){
+		end = ends[i];
+		ok = ( end > start );
+
+		if( ok && end - start > 1 ){
+			command = get_run_command( tokens, mode, start, end );
+			ok = ( strlen( command ) < limit );
+			g_free( command );
+		}
+
+		if( ok && end < count ){
+			for( size = fixed, k = start ; k <= end ; ++k ){
+				size += get_cost( tokens, k, requoted );
+			}
+			ok = ( size > limit );
+		}
+
+		if( ok && oversized >= start && oversized < end ){
+			ok = ( oversized == start && end == start + 1 );
+		}
+
+		if( ok ){
+			argv = fma_tokens_expand_argv( tokens, COMMAND, start, start, end );
+			count_str = g_strdup_printf( "%u", end - start );
+			ok = ( g_strv_length( argv ) == 2 + end - start && !strcmp( argv[1], count_str ));
+			g_free( count_str );
+			g_strfreev( argv );
+		}
+
+		if( !ok ){
+			g_printf( "  chunk #%u [%u, %u[: FAILED\n", i, start, end );
+		}
+	}
+
+	g_free( ends );
+
+	return( ok );
+}
+
+/*
+ * the command for the [@start, @end[ range, as it is passed to the
+ * terminal, or to the shell, when the @mode is not Normal
+ */
+static gchar *
+get_run_command( FMATokens *tokens, const gchar *mode, guint start, guint end )
+{
+	gchar *command, *run_command;
+
+	command = fma_tokens_expand_command( tokens, COMMAND, start, start, end );
+	if( !strcmp( mode, "Normal" )){
+		return( command );
+	}
+
+	run_command = fma_tokens_command_for_terminal( "COMMAND", command );
+	g_free( command );
+
+	return( run_command );
+}
+
+/*
+ * the cost of the @i-th file in COMMAND: its quoted name, quoted again
+ * without the enclosing quotes if @requoted
+ */
+static gsize
+get_cost( FMATokens *tokens, guint i, gboolean requoted )
+{
+	gchar **argv, *quoted, *twice;
+	gsize cost;
+
+	argv = fma_tokens_expand_argv( tokens, "%f", i, 0, 0 );
+	quoted = g_shell_quote( argv[0] );
+	cost = strlen( quoted ) + 1 + sizeof( gchar * );
+
+	if( requoted ){
+		twice = g_shell_quote( quoted );
+		cost = strlen( twice ) - 2 + 1 + sizeof( gchar * );
+		g_free( twice );
+	}
+
+	g_free( quoted );
+	g_strfreev( argv );
+
+	return( cost );
+}
+
+static void
+check( const gchar *label, gboolean ok, gboolean *all_ok )
+{
+	g_printf( "%-40s %s\n", label, ok ? "OK" : "FAILED" );
+	*all_ok &= ok;
+}
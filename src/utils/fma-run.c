@@ -33,7 +33,9 @@
 
 #include <glib.h>
 #include <glib/gi18n.h>
+#include <glib-unix.h>
 #include <locale.h>
+#include <signal.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -41,9 +43,11 @@
 #include <api/fma-object-api.h>
 #include <api/fma-dbus.h>
 
+#include <core/fma-exec-queue.h>
 #include <core/fma-gconf-migration.h>
+#include <core/fma-icontext-program.h>
 #include <core/fma-pivot.h>
-#include <core/fma-selected-info.h>
+#include <core/fma-selection.h>
 #include <core/fma-tokens.h>
 
 #include "console-utils.h"
@@ -71,12 +75,14 @@ static GOptionEntry misc_entries[] = {
 
 static GOptionContext  *init_options( void );
 static FMAObjectAction  *get_action( const gchar *id );
-static GList           *targets_from_selection( void );
-static GList           *targets_from_commandline( void );
-static GList           *get_selection_from_strv( const gchar **strv, gboolean has_mimetype );
-static FMAObjectProfile *get_profile_for_targets( FMAObjectAction *action, GList *targets );
-static void             execute_action( FMAObjectAction *action, FMAObjectProfile *profile, GList *targets );
-static void             dump_targets( GList *targets );
+static FMASelection     *targets_from_selection( void );
+static FMASelection     *targets_from_commandline( void );
+static FMASelection     *get_selection_from_strv( const gchar **strv, gboolean has_mimetype );
+static FMAObjectProfile *get_profile_for_targets( FMAObjectAction *action, FMAIContextProgramScope *scope );
+static void             execute_action( FMAObjectAction *action, FMAObjectProfile *profile, FMASelection *targets );
+static gboolean         on_interrupt( FMAExecQueue *queue );
+static void             on_exec_finished( FMAExecQueue *queue, guint done, guint cancelled, GMainLoop *loop );
+static void             dump_targets( FMASelection *targets );
 static void             exit_with_usage( void );
 
 int
@@ -90,7 +96,8 @@ main( int argc, char** argv )
 	gint errors;
 	FMAObjectAction *action;
 	FMAObjectProfile *profile;
-	GList *targets;
+	FMASelection *targets;
+	FMAIContextProgramScope *scope;
 
 #if !GLIB_CHECK_VERSION( 2,36, 0 )
 	g_type_init();
@@ -155,17 +162,21 @@ main( int argc, char** argv )
 
 	dump_targets( targets );
 
-	if( g_list_length( targets ) == 0 ){
+	if( !targets || !fma_selection_get_count( targets )){
 		g_print( _( "No current selection. Nothing to do. Exiting.\n" ));
 		exit( status );
 	}
 
-	if( !fma_icontext_is_candidate( FMA_ICONTEXT( action ), ITEM_TARGET_ANY, targets )){
+	scope = fma_icontext_program_scope_new( ITEM_TARGET_ANY, targets, NULL );
+
+	if( !fma_icontext_program_is_candidate( FMA_ICONTEXT( action ), scope )){
 		g_printerr( _( "Action %s is not a valid candidate. Exiting.\n" ), id );
 		exit( status );
 	}
 
-	profile = get_profile_for_targets( action, targets );
+	profile = get_profile_for_targets( action, scope );
+	fma_icontext_program_scope_free( scope );
+
 	if( !profile ){
 		g_print( _( "No valid profile is candidate to execution. Exiting.\n" ));
 		exit( status );
@@ -174,7 +185,7 @@ main( int argc, char** argv )
 
 	execute_action( action, profile, targets );
 
-	fma_selected_info_free_list( targets );
+	fma_selection_unref( targets );
 	exit( status );
 }
 
@@ -256,13 +267,13 @@ get_action( const gchar *id )
  * where each selected item brings up both its URI and its Nautilus
  * mime type.
  *
- * We return to the caller a GList of FMASelectedInfo objects
+ * We return to the caller a FMASelection
  */
-static GList *
+static FMASelection *
 targets_from_selection( void )
 {
 	static const gchar *thisfn = "nautilus_actions_run_targets_from_selection";
-	GList *selection;
+	FMASelection *selection;
 	GError *error;
 	gchar **paths;
 	GDBusObjectManager *manager;
@@ -328,13 +339,13 @@ targets_from_selection( void )
 /*
  * get targets from command-line
  *
- * We return to the caller a GList of FMASelectedInfo objects.
+ * We return to the caller a FMASelection.
  */
-static GList *
+static FMASelection *
 targets_from_commandline( void )
 {
 	static const gchar *thisfn = "nautilus_actions_run_targets_from_commandline";
-	GList *targets;
+	FMASelection *targets;
 
 	g_debug( "%s", thisfn );
 
@@ -343,14 +354,14 @@ targets_from_commandline( void )
 	return( targets );
 }
 
-static GList *
+static FMASelection *
 get_selection_from_strv( const gchar **strv, gboolean has_mimetype )
 {
-	GList *list;
+	FMASelection *selection;
 	gchar **iter;
 	gchar *errmsg;
 
-	list = NULL;
+	selection = fma_selection_new();
 	iter = ( gchar ** ) strv;
 
 	while( *iter ){
@@ -362,27 +373,23 @@ get_selection_from_strv( const gchar **strv, gboolean has_mimetype )
 		}
 
 		errmsg = NULL;
-		FMASelectedInfo *nsi = fma_selected_info_create_for_uri( uri, mimetype, &errmsg );
+		fma_selection_add_uri( selection, uri, mimetype, &errmsg );
 
 		if( errmsg ){
 			g_printerr( "%s\n", errmsg );
 			g_free( errmsg );
 		}
-
-		if( nsi ){
-			list = g_list_prepend( list, nsi );
-		}
 		iter++;
 	}
 
-	return( g_list_reverse( list ));
+	return( selection );
 }
 
 /*
  * find a profile candidate to be executed for the given uris
  */
 static FMAObjectProfile *
-get_profile_for_targets( FMAObjectAction *action, GList *targets )
+get_profile_for_targets( FMAObjectAction *action, FMAIContextProgramScope *scope )
 {
 	/*static const gchar *thisfn = "nautilus_actions_run_get_profile_for_targets";*/
 	GList *profiles, *ip;
@@ -392,7 +399,7 @@ get_profile_for_targets( FMAObjectAction *action, GList *targets )
 	profiles = fma_object_get_items( action );
 
 	for( ip = profiles ; ip && !candidate ; ip = ip->next ){
-		if( fma_icontext_is_candidate( FMA_ICONTEXT( ip->data ), ITEM_TARGET_ANY, targets )){
+		if( fma_icontext_program_is_candidate( FMA_ICONTEXT( ip->data ), scope )){
 			candidate = FMA_OBJECT_PROFILE( ip->data );
 		}
 	}
@@ -401,31 +408,79 @@ get_profile_for_targets( FMAObjectAction *action, GList *targets )
 }
 
 static void
-execute_action( FMAObjectAction *action, FMAObjectProfile *profile, GList *targets )
+execute_action( FMAObjectAction *action, FMAObjectProfile *profile, FMASelection *targets )
 {
 	/*static const gchar *thisfn = "nautilus_action_run_execute_action";*/
 	FMATokens *tokens;
+	FMAExecQueue *queue;
+	GMainLoop *loop;
+	gulong finished_handler;
+	guint interrupt_source;
+
+	queue = fma_exec_queue_get_default();
+	loop = g_main_loop_new( NULL, FALSE );
+
+	finished_handler = g_signal_connect( queue, EXEC_QUEUE_SIGNAL_FINISHED, G_CALLBACK( on_exec_finished ), loop );
+
+	/* an interrupt drops the commands which have not been started yet;
+	 * the finished signal then ends the loop once the running ones have
+	 * exited
+	 */
+	interrupt_source = g_unix_signal_add( SIGINT, ( GSourceFunc ) on_interrupt, queue );
 
 	tokens = fma_tokens_new_from_selection( targets );
 	fma_tokens_execute_action( tokens, profile );
+
+	/* wait for the queued commands to have all been run
+	 */
+	if( !fma_exec_queue_is_idle( queue )){
+		g_main_loop_run( loop );
+	}
+
+	g_source_remove( interrupt_source );
+	g_signal_handler_disconnect( queue, finished_handler );
+	g_object_unref( tokens );
+	g_main_loop_unref( loop );
+}
+
+static gboolean
+on_interrupt( FMAExecQueue *queue )
+{
+	static const gchar *thisfn = "nautilus_action_run_on_interrupt";
+
+	g_debug( "%s: queue=%p", thisfn, ( void * ) queue );
+	fma_exec_queue_cancel( queue );
+
+	return( TRUE );
+}
+
+static void
+on_exec_finished( FMAExecQueue *queue, guint done, guint cancelled, GMainLoop *loop )
+{
+	static const gchar *thisfn = "nautilus_action_run_on_exec_finished";
+
+	g_debug( "%s: done=%u, cancelled=%u", thisfn, done, cancelled );
+
+	if( cancelled ){
+		g_printerr( _( "%u command(s) cancelled.\n" ), cancelled );
+	}
+
+	if( g_main_loop_is_running( loop )){
+		g_main_loop_quit( loop );
+	}
 }
 
 /*
  *
  */
 static void
-dump_targets( GList *targets )
+dump_targets( FMASelection *targets )
 {
-	GList *it;
-	gchar *uri, *mimetype;
-
-	for( it = targets ; it ; it = it->next ){
-		FMASelectedInfo *nsi = FMA_SELECTED_INFO( it->data );
-		uri = fma_selected_info_get_uri( nsi );
-		mimetype = fma_selected_info_get_mime_type( nsi );
-		g_print( "%s\t[%s]\n", uri, mimetype );
-		g_free( mimetype );
-		g_free( uri );
+	guint i;
+
+	for( i = 0 ; targets && i < fma_selection_get_count( targets ) ; ++i ){
+		g_print( "%s\t[%s]\n",
+				fma_selection_peek_uri( targets, i ), fma_selection_peek_mimetype( targets, i ));
 	}
 }
 